@@ -0,0 +1,212 @@
+#ifndef WORM_ADDRESS_SET_HPP
+#define WORM_ADDRESS_SET_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace worm
+{
+/// Representation of an address set.
+enum struct set_representation
+{
+	/// Sorted list of addresses, suitable for sparse sets.
+	list,
+
+	/// Bitmaps over address ranges, one bit per granule, suitable for dense sets.
+	bitmap,
+};
+
+/**
+ * @brief Sorted set of addresses.
+ *
+ * It is used to represent scan results, either as a sorted list or as
+ * bitmaps over address ranges, depending on the expected density.
+ */
+struct address_set
+{
+	/// Bitmap of addresses in a range.
+	struct bitmap_segment
+	{
+		/// Address of the first granule of the segment.
+		address_t base;
+
+		/// Number of granules in the segment.
+		std::size_t size;
+
+		/// One bit per granule, least significant bit first.
+		std::vector<std::uint64_t> bits;
+	};
+
+	/// Iterator over addresses of a set in ascending order.
+	struct iterator;
+
+	/// Construct an empty set.
+	address_set() = default;
+
+	/**
+	 * @brief Construct a list set.
+	 *
+	 * @param[in] addresses addresses, which do not have to be sorted or unique
+	 */
+	explicit address_set(std::vector<address_t> addresses);
+
+	/**
+	 * @brief Construct a bitmap set.
+	 *
+	 * @param[in] segments    non-overlapping segments
+	 * @param[in] granularity number of bytes per bit
+	 */
+	explicit address_set(std::vector<bitmap_segment> segments, std::size_t granularity);
+
+	/**
+	 * @brief Get representation of the set.
+	 */
+	[[nodiscard]]
+	auto representation() const noexcept -> set_representation;
+
+	/**
+	 * @brief Get number of bytes per bit of a bitmap set, or `1` for a list set.
+	 */
+	[[nodiscard]]
+	auto granularity() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Get number of addresses in the set.
+	 */
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Check whether the set is empty.
+	 */
+	[[nodiscard]]
+	auto empty() const noexcept -> bool;
+
+	/**
+	 * @brief Check whether the set contains an address.
+	 *
+	 * @param[in] addr address
+	 */
+	[[nodiscard]]
+	auto contains(address_t addr) const noexcept -> bool;
+
+	/**
+	 * @brief Get iterator to the lowest address.
+	 */
+	[[nodiscard]]
+	auto begin() const noexcept -> iterator;
+
+	/**
+	 * @brief Get iterator past the highest address.
+	 */
+	[[nodiscard]]
+	auto end() const noexcept -> iterator;
+
+	/**
+	 * @brief Copy addresses into a sorted vector.
+	 */
+	[[nodiscard]]
+	auto to_vector() const -> std::vector<address_t>;
+
+	/**
+	 * @brief Shift all addresses of the set by an offset.
+	 *
+	 * The representation of the set is kept, and bitmaps are not copied bit by bit.
+	 *
+	 * @param[in] offset number of bytes to add to each address
+	 */
+	[[nodiscard]]
+	auto shift(std::ptrdiff_t offset) const -> address_set;
+
+private:
+	friend struct set_algebra;
+
+	set_representation          representation_ = set_representation::list;
+	std::size_t                 granularity_     = 1;
+	std::size_t                 size_            = 0;
+	std::vector<address_t>      list_;
+	std::vector<bitmap_segment> segments_;
+};
+
+struct address_set::iterator
+{
+	using iterator_category = std::forward_iterator_tag;
+	using value_type        = address_t;
+	using difference_type   = std::ptrdiff_t;
+	using pointer           = void;
+	using reference         = address_t;
+
+	iterator() = default;
+
+	[[nodiscard]]
+	auto operator*() const noexcept -> address_t;
+
+	auto operator++() noexcept -> iterator&;
+	auto operator++(int) noexcept -> iterator;
+
+	[[nodiscard]]
+	auto operator==(iterator const& other) const noexcept -> bool;
+
+private:
+	friend address_set;
+
+	/**
+	 * @brief Construct an iterator.
+	 *
+	 * @param[in] set   iterated set
+	 * @param[in] index index of the address in a list set, or of the segment in a bitmap set
+	 */
+	iterator(address_set const* set, std::size_t index) noexcept;
+
+	/// Skip to the next set bit of a bitmap set.
+	auto settle() noexcept -> void;
+
+	address_set const* set_{};
+	std::size_t        index_{};
+	std::size_t        word_{};
+	std::uint64_t      bits_{};
+};
+
+/**
+ * @brief Unite sets.
+ *
+ * Bitmap sets of the same granularity are united word by word, unless
+ * their granules overlap without coinciding, in which case the result is a list set.
+ *
+ * @param[in] lhs left-hand side set
+ * @param[in] rhs right-hand side set
+ */
+[[nodiscard]]
+auto operator|(address_set const& lhs, address_set const& rhs) -> address_set;
+
+/**
+ * @brief Intersect sets.
+ *
+ * Bitmap sets of the same granularity are intersected word by word, and
+ * the result is a bitmap set. Otherwise, the result is a list set.
+ *
+ * @param[in] lhs left-hand side set
+ * @param[in] rhs right-hand side set
+ */
+[[nodiscard]]
+auto operator&(address_set const& lhs, address_set const& rhs) -> address_set;
+
+/**
+ * @brief Subtract a set from another one.
+ *
+ * The result has the representation of the left-hand side set.
+ *
+ * @param[in] lhs left-hand side set
+ * @param[in] rhs right-hand side set
+ */
+[[nodiscard]]
+auto operator-(address_set const& lhs, address_set const& rhs) -> address_set;
+}
+
+#include "address_set.inl"
+
+#endif
@@ -0,0 +1,73 @@
+#include <bit>
+
+namespace worm
+{
+inline address_set::iterator::iterator(address_set const* set, std::size_t index) noexcept
+	: set_{set}
+	, index_{index}
+{
+	if (set_->representation_ == set_representation::bitmap && index_ < set_->segments_.size())
+	{
+		bits_ = set_->segments_[index_].bits.empty() ? 0 : set_->segments_[index_].bits.front();
+		settle();
+	}
+}
+
+inline auto address_set::iterator::settle() noexcept -> void
+{
+	auto const& segments = set_->segments_;
+
+	while (!bits_ && index_ < segments.size())
+	{
+		if (++word_ >= segments[index_].bits.size())
+		{
+			word_ = 0;
+
+			if (++index_ == segments.size())
+			{
+				return;
+			}
+		}
+
+		bits_ = segments[index_].bits.empty() ? 0 : segments[index_].bits[word_];
+	}
+}
+
+inline auto address_set::iterator::operator*() const noexcept -> address_t
+{
+	if (set_->representation_ == set_representation::list)
+	{
+		return set_->list_[index_];
+	}
+
+	auto const& segment = set_->segments_[index_];
+	return segment.base + (word_ * 64 + static_cast<std::size_t>(std::countr_zero(bits_))) * set_->granularity_;
+}
+
+inline auto address_set::iterator::operator++() noexcept -> iterator&
+{
+	if (set_->representation_ == set_representation::list)
+	{
+		++index_;
+	}
+	else
+	{
+		bits_ &= bits_ - 1;
+		settle();
+	}
+
+	return *this;
+}
+
+inline auto address_set::iterator::operator++(int) noexcept -> iterator
+{
+	auto const copy = *this;
+	++*this;
+	return copy;
+}
+
+inline auto address_set::iterator::operator==(iterator const& other) const noexcept -> bool
+{
+	return index_ == other.index_ && word_ == other.word_ && bits_ == other.bits_;
+}
+}
@@ -0,0 +1,188 @@
+#ifndef WORM_DAEMON_HPP
+#define WORM_DAEMON_HPP
+
+#include "address_set.hpp"
+#include "scan.hpp"
+#include "worm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace worm
+{
+/// Options of a daemon.
+struct daemon_options
+{
+	/// Path of the socket to listen on, or an empty string for the default one.
+	std::string socket_path;
+
+	/**
+	 * @brief Permissions of the socket file.
+	 *
+	 * Anyone who can connect to the socket can read memory of every process
+	 * that the daemon can, so that it should only be widened deliberately.
+	 */
+	unsigned socket_mode = 0600;
+
+	/// Longest duration that a region table is served from the cache before it is enumerated again.
+	std::chrono::milliseconds region_ttl = std::chrono::seconds(1);
+
+	/// Longest duration that a process is kept after its last request, before its handle and cache are dropped.
+	std::chrono::milliseconds target_ttl = std::chrono::minutes(1);
+};
+
+/**
+ * @brief Get the default path of the daemon socket.
+ *
+ * It is `$XDG_RUNTIME_DIR/worm.sock`, or `/tmp/worm-<uid>.sock` if the
+ * variable is not set.
+ */
+[[nodiscard]]
+auto default_daemon_socket() -> std::string;
+
+/**
+ * @brief Daemon that serves memory of processes to local clients.
+ *
+ * It owns handles of the processes that clients ask for, and caches their
+ * region tables, so that tools attached to the same processes share the
+ * work, and clients need no privileges to access other processes. Requests
+ * are served over a Unix socket, one thread per client, and bulk results are
+ * passed in memory files whose descriptors are sent along with the replies,
+ * rather than being serialized into the socket. Requests that would read or
+ * return more than 1 GiB at once are rejected, and so are scans for patterns
+ * without a fixed byte, and requests for processes that do not exist. Processes that exited or were not asked for in a while are
+ * forgotten.
+ *
+ * It is only supported on Linux.
+ */
+struct daemon_server
+{
+	/**
+	 * @brief Listen on a socket, replacing a stale socket file.
+	 *
+	 * @param[in] options daemon options
+	 *
+	 * @throws `std::system_error` if could not listen on the socket
+	 */
+	explicit daemon_server(daemon_options const& options = {});
+
+	daemon_server(daemon_server&&) noexcept;
+	auto operator=(daemon_server&&) noexcept -> daemon_server&;
+
+	/**
+	 * @brief Stop serving and remove the socket file.
+	 */
+	~daemon_server();
+
+	/**
+	 * @brief Get path of the socket.
+	 */
+	[[nodiscard]]
+	auto socket_path() const noexcept -> std::string const&;
+
+	/**
+	 * @brief Serve clients until stopped.
+	 *
+	 * @throws `std::system_error` if could not accept a client
+	 */
+	auto run() -> void;
+
+	/**
+	 * @brief Stop serving, disconnecting all clients.
+	 *
+	 * It may be called from any thread.
+	 */
+	auto stop() noexcept -> void;
+
+private:
+	/// Internal state of a daemon.
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+
+/**
+ * @brief Client of a daemon.
+ *
+ * Requests of a client are served one at a time.
+ */
+struct daemon_client
+{
+	/**
+	 * @brief Connect to a daemon.
+	 *
+	 * @param[in] socket_path path of the daemon socket
+	 *
+	 * @throws `std::system_error` if could not connect
+	 */
+	explicit daemon_client(std::string const& socket_path = default_daemon_socket());
+
+	daemon_client(daemon_client&&) noexcept;
+	auto operator=(daemon_client&&) noexcept -> daemon_client&;
+
+	~daemon_client();
+
+	/**
+	 * @brief Enumerate virtual memory regions of a process.
+	 *
+	 * @param[in] pid     process id
+	 * @param[in] refresh whether to enumerate regions again rather than serve them from the cache
+	 *
+	 * @throws `std::system_error` on failed request
+	 */
+	[[nodiscard]]
+	auto regions(pid_t pid, bool refresh = false) const -> std::vector<memory_region>;
+
+	/**
+	 * @brief Read bytes from virtual memory of a process into a buffer.
+	 *
+	 * @param[in]  pid  process id
+	 * @param[in]  src  remote virtual memory address
+	 * @param[out] dst  local buffer
+	 * @param[in]  size number of bytes to read
+	 *
+	 * @throws `std::system_error` on failed request
+	 *
+	 * @return number of bytes read
+	 */
+	auto read_bytes(pid_t pid, address_t src, void* dst, std::size_t size) const -> std::size_t;
+
+	/**
+	 * @brief Read bytes from virtual memory of a process into buffers in batches.
+	 *
+	 * @param[in]     pid       process id
+	 * @param[in,out] transfers transfers, of which the number of transferred bytes is set
+	 *
+	 * @throws `std::system_error` on failed request
+	 *
+	 * @return total number of bytes read
+	 */
+	auto read_bytes(pid_t pid, std::span<memory_transfer> transfers) const -> std::size_t;
+
+	/**
+	 * @brief Scan all readable virtual memory of a process for a pattern.
+	 *
+	 * @param[in] pid       process id
+	 * @param[in] p         pattern to scan for
+	 * @param[in] alignment alignment of matched addresses
+	 *
+	 * @throws `std::system_error` on failed request
+	 *
+	 * @return addresses of matches
+	 */
+	[[nodiscard]]
+	auto scan(pid_t pid, pattern const& p, std::size_t alignment = 1) const -> address_set;
+
+private:
+	/// Internal state of a client.
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#endif
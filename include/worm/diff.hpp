@@ -0,0 +1,167 @@
+#ifndef WORM_DIFF_HPP
+#define WORM_DIFF_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace worm
+{
+/// Difference between memory of two processes.
+struct memory_difference
+{
+	/// Name of the module that the differing bytes belong to.
+	std::string module;
+
+	/// Offset of the first differing byte relative to the module base.
+	address_t offset;
+
+	/// Number of consecutive differing bytes.
+	std::size_t size;
+};
+
+/// Memory diff options.
+struct diff_options
+{
+	/// Number of worker threads, or `0` to use hardware concurrency.
+	std::size_t threads = 0;
+
+	/// Number of bytes that a worker reads from each process at once.
+	std::size_t chunk_size = 1 << 20;
+
+	/// Number of bytes that are compared as a whole before being compared byte by byte.
+	std::size_t page_size = 1 << 12;
+};
+
+/**
+ * @brief Diff virtual memory of two processes.
+ *
+ * Regions of both processes are paired by module name and offset relative to
+ * the module base, so that processes of the same binary can be compared
+ * regardless of address space layout randomization. Only mapped files are
+ * modules, along with the single anonymous region of `.bss` that follows a
+ * writable region of a module, as in `worm::module_table`. Heaps, stacks and
+ * other anonymous or pseudo-regions such as `[anon:name]` are not compared.
+ *
+ * Paired regions are split into chunks that are read and compared page by
+ * page in parallel, and only pages that differ are compared byte by byte.
+ * Each worker reads its chunks through a pair of region readers, so that
+ * reading overlaps with comparing. Chunks that could not be read from either
+ * process are skipped.
+ *
+ * @param[in] lhs         left-hand side handle
+ * @param[in] lhs_regions regions of the left-hand side process to compare
+ * @param[in] rhs         right-hand side handle
+ * @param[in] rhs_regions regions of the right-hand side process to compare
+ * @param[in] options     diff options
+ *
+ * @return differences sorted by module name and offset
+ */
+template <handle_mode LhsMode, handle_mode RhsMode>
+[[nodiscard]]
+auto diff(
+	handle<LhsMode> const&            lhs,
+	std::vector<memory_region> const& lhs_regions,
+	handle<RhsMode> const&            rhs,
+	std::vector<memory_region> const& rhs_regions,
+	diff_options const&               options = {}
+) -> std::vector<memory_difference>
+	requires handle<LhsMode>::readable && handle<RhsMode>::readable;
+
+/**
+ * @brief Diff all readable virtual memory of two processes.
+ *
+ * @param[in] lhs     left-hand side handle
+ * @param[in] rhs     right-hand side handle
+ * @param[in] options diff options
+ *
+ * @throws `std::system_error` if could not enumerate memory regions
+ *
+ * @return differences sorted by module name and offset
+ */
+template <handle_mode LhsMode, handle_mode RhsMode>
+[[nodiscard]]
+auto diff(handle<LhsMode> const& lhs, handle<RhsMode> const& rhs, diff_options const& options = {}) -> std::vector<memory_difference>
+	requires handle<LhsMode>::readable && handle<RhsMode>::readable;
+
+/// Memory clone options.
+struct clone_options
+{
+	/// Number of worker threads, or `0` to use hardware concurrency.
+	std::size_t threads = 0;
+
+	/**
+	 * @brief Number of bytes that a worker reads from the source and writes to the destination at once.
+	 *
+	 * Chunks that fit in caches are written from them, so that larger ones are slower.
+	 */
+	std::size_t chunk_size = 1 << 18;
+
+	/// Number of chunks that each worker reads ahead of its writes.
+	std::size_t depth = 2;
+};
+
+/// Result of a memory clone.
+struct clone_result
+{
+	/// Number of bytes copied.
+	std::size_t copied = 0;
+
+	/// Number of paired bytes that could not be read from the source or written to the destination.
+	std::size_t skipped = 0;
+};
+
+/**
+ * @brief Copy virtual memory of a process into another process of the same binary.
+ *
+ * Readable regions of the source are paired with writable regions of the
+ * destination by module name and offset relative to the module base, as in a
+ * diff, so that state is carried over regardless of address space layout
+ * randomization. Regions that do not belong to any module as in a diff, such
+ * as heaps, stacks and malloc arenas, are not copied, and pointers are copied
+ * as they are.
+ *
+ * Paired regions are split into large chunks. Each worker reads its chunks
+ * through a region reader ahead of writing them, so that reading the next
+ * chunks from the source overlaps with writing the current one to the
+ * destination.
+ *
+ * @param[in] src         source handle
+ * @param[in] src_regions regions of the source process to copy
+ * @param[in] dst         destination handle
+ * @param[in] dst_regions regions of the destination process to copy into
+ * @param[in] options     clone options
+ *
+ * @throws `std::system_error` on failed transfer other than an inaccessible address
+ *
+ * @return numbers of copied and skipped bytes
+ */
+template <handle_mode SrcMode, handle_mode DstMode>
+auto clone_memory(
+	handle<SrcMode> const&            src,
+	std::vector<memory_region> const& src_regions,
+	handle<DstMode> const&            dst,
+	std::vector<memory_region> const& dst_regions,
+	clone_options const&              options = {}
+) -> clone_result
+	requires handle<SrcMode>::readable && handle<DstMode>::writable;
+
+/**
+ * @brief Copy all readable virtual memory of modules of a process into another process of the same binary.
+ *
+ * @param[in] src     source handle
+ * @param[in] dst     destination handle
+ * @param[in] options clone options
+ *
+ * @throws `std::system_error` if could not enumerate memory regions, or on failed transfer other than an inaccessible address
+ *
+ * @return numbers of copied and skipped bytes
+ */
+template <handle_mode SrcMode>
+auto clone_memory(handle<SrcMode> const& src, iohandle const& dst, clone_options const& options = {}) -> clone_result
+	requires handle<SrcMode>::readable;
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef WORM_LIBSTDCXX_HPP
+#define WORM_LIBSTDCXX_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Decoders of libstdc++ containers in remote virtual memory.
+ *
+ * They assume the layouts of the 64-bit libstdc++ ABI with `_GLIBCXX_USE_CXX11_ABI`,
+ * default allocators, and empty comparators and hashers. Headers and elements
+ * are fetched with as few batched reads as possible: node-based containers
+ * are walked breadth-first, reading every node of a level at once.
+ *
+ * Containers that are modified while being decoded may be decoded
+ * inconsistently, in which case an exception is thrown rather than looping or
+ * allocating without bounds.
+ */
+namespace worm::libstdcxx
+{
+/// Elements of a remote container.
+struct container_elements
+{
+	/// Number of bytes in an element.
+	std::size_t element_size = 0;
+
+	/// Remote virtual memory addresses of the elements.
+	std::vector<address_t> addresses;
+
+	/// Object representations of the elements, one after another.
+	std::vector<unsigned char> bytes;
+
+	/**
+	 * @brief Get number of elements.
+	 */
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Copy elements into values.
+	 *
+	 * @tparam T type of element, of the element size
+	 *
+	 * @throws `std::invalid_argument` if the size of the type differs from the element size
+	 */
+	template <typename T>
+	[[nodiscard]]
+	auto as() const -> std::vector<T>
+		requires std::is_trivially_copyable_v<T>;
+};
+
+/**
+ * @brief Read elements of a `std::vector`.
+ *
+ * @param[in] h            handle
+ * @param[in] addr         remote virtual memory address of the vector
+ * @param[in] element_size number of bytes in an element
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto vector_elements(handle<Mode> const& h, address_t addr, std::size_t element_size) -> container_elements
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read elements of a `std::deque`.
+ *
+ * @param[in] h            handle
+ * @param[in] addr         remote virtual memory address of the deque
+ * @param[in] element_size number of bytes in an element
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto deque_elements(handle<Mode> const& h, address_t addr, std::size_t element_size) -> container_elements
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read elements of a `std::map`, `std::set` or their multi variants in order.
+ *
+ * @param[in] h             handle
+ * @param[in] addr          remote virtual memory address of the container
+ * @param[in] element_size  number of bytes in an element
+ * @param[in] element_align alignment of an element
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto tree_elements(handle<Mode> const& h, address_t addr, std::size_t element_size, std::size_t element_align) -> container_elements
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read elements of a `std::unordered_map`, `std::unordered_set` or their multi variants.
+ *
+ * Elements are in no particular order.
+ *
+ * @param[in] h             handle
+ * @param[in] addr          remote virtual memory address of the container
+ * @param[in] element_size  number of bytes in an element
+ * @param[in] element_align alignment of an element
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto hashtable_elements(handle<Mode> const& h, address_t addr, std::size_t element_size, std::size_t element_align) -> container_elements
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read a `std::string`.
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the string
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_string(handle<Mode> const& h, address_t addr) -> std::string
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read `std::string`s in two batched reads.
+ *
+ * @param[in] h     handle
+ * @param[in] addrs remote virtual memory addresses of the strings
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_strings(handle<Mode> const& h, std::span<address_t const> addrs) -> std::vector<std::string>
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read a `std::vector<T>`.
+ *
+ * @tparam T type of element
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the vector
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename T, handle_mode Mode>
+[[nodiscard]]
+auto read_vector(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Read a `std::deque<T>`.
+ *
+ * @tparam T type of element
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the deque
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename T, handle_mode Mode>
+[[nodiscard]]
+auto read_deque(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Read a `std::set<T>` in order.
+ *
+ * @tparam T type of element
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the set
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename T, handle_mode Mode>
+[[nodiscard]]
+auto read_set(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Read a `std::map<K, V>` in order.
+ *
+ * @tparam K type of key
+ * @tparam V type of mapped value
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the map
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename K, typename V, handle_mode Mode>
+[[nodiscard]]
+auto read_map(handle<Mode> const& h, address_t addr) -> std::vector<std::pair<K, V>>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>;
+
+/**
+ * @brief Read a `std::unordered_set<T>`.
+ *
+ * @tparam T type of element
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the set
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename T, handle_mode Mode>
+[[nodiscard]]
+auto read_unordered_set(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>;
+
+/**
+ * @brief Read a `std::unordered_map<K, V>`.
+ *
+ * @tparam K type of key
+ * @tparam V type of mapped value
+ *
+ * @param[in] h    handle
+ * @param[in] addr remote virtual memory address of the map
+ *
+ * @throws `std::system_error` on failed read attempt, or if the layout is inconsistent
+ */
+template <typename K, typename V, handle_mode Mode>
+[[nodiscard]]
+auto read_unordered_map(handle<Mode> const& h, address_t addr) -> std::vector<std::pair<K, V>>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>;
+}
+
+#include "libstdcxx.inl"
+
+#endif
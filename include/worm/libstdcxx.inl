@@ -0,0 +1,92 @@
+#include <cstring>
+#include <stdexcept>
+
+namespace worm::libstdcxx
+{
+namespace detail
+{
+/// Layout of `std::pair<K const, V>`, which is not trivially copyable itself.
+template <typename K, typename V>
+struct map_value
+{
+	K first;
+	V second;
+};
+
+template <typename K, typename V>
+[[nodiscard]]
+auto to_pairs(std::vector<map_value<K, V>> const& values) -> std::vector<std::pair<K, V>>
+{
+	std::vector<std::pair<K, V>> pairs;
+	pairs.reserve(values.size());
+
+	for (auto const& value : values)
+	{
+		pairs.emplace_back(value.first, value.second);
+	}
+
+	return pairs;
+}
+}
+
+template <typename T>
+auto container_elements::as() const -> std::vector<T>
+	requires std::is_trivially_copyable_v<T>
+{
+	if (sizeof(T) != element_size)
+	{
+		throw std::invalid_argument("size of the type differs from the element size");
+	}
+
+	std::vector<T> values(size());
+	std::memcpy(values.data(), bytes.data(), values.size() * sizeof(T));
+
+	return values;
+}
+
+template <typename T, handle_mode Mode>
+auto read_vector(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>
+{
+	return vector_elements(h, addr, sizeof(T)).template as<T>();
+}
+
+template <typename T, handle_mode Mode>
+auto read_deque(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>
+{
+	return deque_elements(h, addr, sizeof(T)).template as<T>();
+}
+
+template <typename T, handle_mode Mode>
+auto read_set(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>
+{
+	return tree_elements(h, addr, sizeof(T), alignof(T)).template as<T>();
+}
+
+template <typename K, typename V, handle_mode Mode>
+auto read_map(handle<Mode> const& h, address_t addr) -> std::vector<std::pair<K, V>>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>
+{
+	using value = detail::map_value<K, V>;
+
+	return detail::to_pairs(tree_elements(h, addr, sizeof(value), alignof(value)).template as<value>());
+}
+
+template <typename T, handle_mode Mode>
+auto read_unordered_set(handle<Mode> const& h, address_t addr) -> std::vector<T>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<T>
+{
+	return hashtable_elements(h, addr, sizeof(T), alignof(T)).template as<T>();
+}
+
+template <typename K, typename V, handle_mode Mode>
+auto read_unordered_map(handle<Mode> const& h, address_t addr) -> std::vector<std::pair<K, V>>
+	requires handle<Mode>::readable && std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>
+{
+	using value = detail::map_value<K, V>;
+
+	return detail::to_pairs(hashtable_elements(h, addr, sizeof(value), alignof(value)).template as<value>());
+}
+}
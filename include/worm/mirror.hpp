@@ -0,0 +1,139 @@
+#ifndef WORM_MIRROR_HPP
+#define WORM_MIRROR_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace worm
+{
+/**
+ * @brief Local mirror of a remote virtual memory range.
+ *
+ * It maps a local address range that mirrors a remote one, so that remote
+ * data structures can be dereferenced as plain pointers after rebasing.
+ *
+ * On POSIX, pages of the mirror are filled lazily on first touch by a
+ * `userfaultfd` handler thread, so that only touched pages are transferred.
+ * On Windows, the whole range is transferred eagerly.
+ *
+ * Pages that could not be read from the remote process are filled with zeros.
+ * Local writes to the mirror are not propagated to the remote process.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct mirror
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Construct a mirror.
+	 *
+	 * @param[in] h    handle, which must outlive the mirror
+	 * @param[in] addr remote virtual memory address
+	 * @param[in] size number of bytes to mirror
+	 *
+	 * @throws `std::system_error` on failure to map the mirror
+	 */
+	explicit mirror(handle_type const& h, address_t addr, std::size_t size)
+		requires handle_type::readable;
+
+	mirror(mirror const&) = delete;
+	auto operator=(mirror const&) -> mirror& = delete;
+
+	mirror(mirror&&) noexcept;
+	auto operator=(mirror&&) noexcept -> mirror&;
+
+	/**
+	 * @brief Destruct a mirror.
+	 *
+	 * Stop the handler thread and unmap the mirror.
+	 */
+	~mirror();
+
+	/**
+	 * @brief Get local address of the first mirrored byte.
+	 */
+	[[nodiscard]]
+	auto data() const noexcept -> void const*;
+
+	/**
+	 * @brief Get remote virtual memory address of the first mirrored byte.
+	 */
+	[[nodiscard]]
+	auto address() const noexcept -> address_t;
+
+	/**
+	 * @brief Get number of mirrored bytes.
+	 */
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Rebase a remote virtual memory address into the mirror.
+	 *
+	 * @tparam T type of pointed value
+	 *
+	 * @param[in] addr remote virtual memory address
+	 *
+	 * @return local pointer, or `nullptr` if the address is not mirrored
+	 */
+	template <typename T = void>
+	[[nodiscard]]
+	auto local(address_t addr) const noexcept -> T const*;
+
+	/**
+	 * @brief Invalidate mirrored pages.
+	 *
+	 * Invalidated pages are transferred again on next touch.
+	 *
+	 * @param[in] addr remote virtual memory address
+	 * @param[in] size number of bytes to invalidate
+	 *
+	 * @throws `std::system_error` on failure to invalidate pages
+	 */
+	auto invalidate(address_t addr, std::size_t size) -> void;
+
+	/**
+	 * @brief Invalidate all mirrored pages.
+	 *
+	 * @throws `std::system_error` on failure to invalidate pages
+	 */
+	auto invalidate() -> void;
+
+	/**
+	 * @brief Transfer mirrored pages again right away.
+	 *
+	 * @param[in] addr remote virtual memory address
+	 * @param[in] size number of bytes to refresh
+	 *
+	 * @throws `std::system_error` on failure to refresh pages
+	 */
+	auto refresh(address_t addr, std::size_t size) -> void;
+
+	/**
+	 * @brief Transfer all mirrored pages again right away.
+	 *
+	 * @throws `std::system_error` on failure to refresh pages
+	 */
+	auto refresh() -> void;
+
+private:
+	/**
+	 * @brief Internal state of a mirror.
+	 *
+	 * It owns the local mapping and, on POSIX, the fault handler.
+	 */
+	struct state;
+
+	std::unique_ptr<state> state_;
+	address_t              addr_;
+	std::size_t            size_;
+};
+}
+
+#include "mirror.inl"
+
+#endif
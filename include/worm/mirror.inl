@@ -0,0 +1,14 @@
+namespace worm
+{
+template <handle_mode Mode>
+template <typename T>
+auto mirror<Mode>::local(address_t addr) const noexcept -> T const*
+{
+	if (addr < addr_ || addr - addr_ >= size_)
+	{
+		return nullptr;
+	}
+
+	return reinterpret_cast<T const*>(static_cast<unsigned char const*>(data()) + (addr - addr_));
+}
+}
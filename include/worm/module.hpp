@@ -0,0 +1,150 @@
+#ifndef WORM_MODULE_HPP
+#define WORM_MODULE_HPP
+
+#include "worm.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace worm
+{
+/**
+ * @brief Address relative to a module.
+ *
+ * Unlike absolute addresses, it remains valid across restarts of a process
+ * regardless of address space layout randomization.
+ */
+struct module_address
+{
+	/// Module name, as in `worm::memory_region::name`.
+	std::string module;
+
+	/// Offset relative to the module base.
+	address_t offset;
+
+	[[nodiscard]]
+	auto operator<=>(module_address const&) const = default;
+};
+
+/// Module loaded into a process.
+struct loaded_module
+{
+	/// Module name, as in `worm::memory_region::name`.
+	std::string name;
+
+	/// Module base address.
+	address_t base;
+};
+
+/**
+ * @brief Table of modules loaded into a process.
+ *
+ * It is built once from memory regions and is used to convert between
+ * absolute and module-relative addresses without enumerating regions again.
+ *
+ * Modules are mapped files, so that pseudo-regions such as `[heap]`,
+ * `[stack]` and `[anon:name]` do not belong to any module. Module base is the
+ * start of the first region with the module name. A single unnamed region
+ * that immediately follows a writable region of a module with the same
+ * permissions (its `.bss`) belongs to that module, while anonymous mappings
+ * that follow it, such as malloc arenas and thread stacks, do not.
+ */
+struct module_table
+{
+	/// Construct an empty module table.
+	module_table() = default;
+
+	/**
+	 * @brief Construct a module table from memory regions.
+	 *
+	 * @param[in] regions memory regions sorted by address
+	 */
+	explicit module_table(std::vector<memory_region> const& regions);
+
+	/**
+	 * @brief Construct a module table from memory regions of a process.
+	 *
+	 * @param[in] h handle
+	 *
+	 * @throws `std::system_error` if could not enumerate memory regions
+	 */
+	template <handle_mode Mode>
+	explicit module_table(handle<Mode> const& h)
+		requires handle<Mode>::readable;
+
+	/**
+	 * @brief Get loaded modules, sorted by name.
+	 */
+	[[nodiscard]]
+	auto modules() const noexcept -> std::vector<loaded_module> const&;
+
+	/**
+	 * @brief Find a module by name.
+	 *
+	 * @param[in] name module name
+	 *
+	 * @return pointer to the module, or `nullptr` if it is not loaded
+	 */
+	[[nodiscard]]
+	auto find(std::string_view name) const noexcept -> loaded_module const*;
+
+	/**
+	 * @brief Convert a module-relative address to an absolute one.
+	 *
+	 * @param[in] addr module-relative address
+	 *
+	 * @return absolute address, or `std::nullopt` if the module is not loaded
+	 */
+	[[nodiscard]]
+	auto resolve(module_address const& addr) const noexcept -> std::optional<address_t>;
+
+	/**
+	 * @brief Convert module-relative addresses to absolute ones in one pass.
+	 *
+	 * Addresses whose modules are not loaded are converted to `0`.
+	 *
+	 * @param[in]  addrs module-relative addresses
+	 * @param[out] out   absolute addresses, must be at least as large as `addrs`
+	 *
+	 * @return number of converted addresses
+	 */
+	auto resolve(std::span<module_address const> addrs, std::span<address_t> out) const noexcept -> std::size_t;
+
+	/**
+	 * @brief Convert an absolute address to a module-relative one.
+	 *
+	 * @param[in] addr absolute address
+	 *
+	 * @return module-relative address, or `std::nullopt` if the address does
+	 *         not belong to any module
+	 */
+	[[nodiscard]]
+	auto relativize(address_t addr) const -> std::optional<module_address>;
+
+private:
+	/// Contiguous address range that belongs to a module.
+	struct segment
+	{
+		/// First address of the segment.
+		address_t begin;
+
+		/// Address past the last address of the segment.
+		address_t end;
+
+		/// Index of the module in the table.
+		std::size_t module;
+	};
+
+	std::vector<loaded_module> modules_;
+	std::vector<segment>       segments_;
+};
+}
+
+#include "module.inl"
+
+#endif
@@ -0,0 +1,23 @@
+#include <stdexcept>
+
+namespace worm
+{
+template <handle_mode Mode>
+module_table::module_table(handle<Mode> const& h)
+	requires(handle<Mode>::readable)
+	: module_table(h.regions())
+{}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::bind(module_table const& modules, module_address const& addr) const& -> bound<T>
+{
+	auto const resolved = modules.resolve(addr);
+	if (!resolved)
+	{
+		throw std::out_of_range("module is not loaded: " + addr.module);
+	}
+
+	return bound<T>(*this, *resolved);
+}
+}
@@ -0,0 +1,214 @@
+#ifndef WORM_MODULE_INFO_HPP
+#define WORM_MODULE_INFO_HPP
+
+#include "worm.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace worm
+{
+/// Section of a module that is loaded into memory.
+struct module_section
+{
+	/// Section name.
+	std::string name;
+
+	/// Offset of the section relative to the module base.
+	address_t offset;
+
+	/// Section size.
+	std::size_t size;
+};
+
+/// Symbol defined by a module.
+struct module_symbol
+{
+	/// Symbol name.
+	std::string name;
+
+	/// Offset of the symbol relative to the module base.
+	address_t offset;
+
+	/// Symbol size.
+	std::size_t size;
+};
+
+/**
+ * @brief Metadata of a module file.
+ *
+ * It does not depend on the process that the module is loaded into, as
+ * offsets are relative to the module base, as in `worm::module_address`.
+ * Module base is the start of the lowest loaded page of the module.
+ */
+struct module_info
+{
+	/**
+	 * @brief Load metadata of an ELF file.
+	 *
+	 * @param[in] path path to the file
+	 *
+	 * @throws `std::system_error` if could not read the file, or if it is not a supported ELF file
+	 */
+	[[nodiscard]]
+	static auto load(std::string const& path) -> module_info;
+
+	/**
+	 * @brief Get path to the file that the metadata was loaded from.
+	 */
+	[[nodiscard]]
+	auto path() const noexcept -> std::string const&;
+
+	/**
+	 * @brief Get build ID as a hexadecimal string, or an empty string if the module has none.
+	 */
+	[[nodiscard]]
+	auto build_id() const noexcept -> std::string const&;
+
+	/**
+	 * @brief Get loaded sections, sorted by offset.
+	 */
+	[[nodiscard]]
+	auto sections() const noexcept -> std::vector<module_section> const&;
+
+	/**
+	 * @brief Get defined symbols, sorted by offset.
+	 */
+	[[nodiscard]]
+	auto symbols() const noexcept -> std::vector<module_symbol> const&;
+
+	/**
+	 * @brief Find a loaded section by name.
+	 *
+	 * @param[in] name section name
+	 *
+	 * @return pointer to the section, or `nullptr` if there is none
+	 */
+	[[nodiscard]]
+	auto find_section(std::string_view name) const noexcept -> module_section const*;
+
+	/**
+	 * @brief Find a symbol by name.
+	 *
+	 * @param[in] name symbol name
+	 *
+	 * @return pointer to the symbol, or `nullptr` if there is none
+	 */
+	[[nodiscard]]
+	auto find_symbol(std::string_view name) const noexcept -> module_symbol const*;
+
+	/**
+	 * @brief Find a symbol that contains an offset.
+	 *
+	 * @param[in] offset offset relative to the module base
+	 *
+	 * @return pointer to the symbol, or `nullptr` if there is none
+	 */
+	[[nodiscard]]
+	auto symbolize(address_t offset) const noexcept -> module_symbol const*;
+
+private:
+	friend struct module_parser;
+
+	std::string                 path_;
+	std::string                 build_id_;
+	std::vector<module_section> sections_;
+	std::vector<module_symbol>  symbols_;
+
+	/// Indices of symbols, sorted by name.
+	std::vector<std::size_t> symbols_by_name_;
+};
+
+/**
+ * @brief Cache of module metadata shared between handles.
+ *
+ * Metadata of a module is the same in every process that maps the same file,
+ * so it is loaded once and shared. Files are identified by device, inode and
+ * modification time taken from region metadata, and by build ID, so that the
+ * same binary found at another path (e.g. in another container) is loaded once
+ * as well.
+ *
+ * It is safe to use concurrently.
+ */
+struct module_cache
+{
+	/// Construct an empty cache.
+	module_cache() = default;
+
+	module_cache(module_cache const&)                    = delete;
+	auto operator=(module_cache const&) -> module_cache& = delete;
+
+	/**
+	 * @brief Get the process-wide cache.
+	 */
+	[[nodiscard]]
+	static auto global() noexcept -> module_cache&;
+
+	/**
+	 * @brief Get metadata of the file that a region maps.
+	 *
+	 * The file is opened through the root of the process, so that modules of
+	 * processes in other mount namespaces are found.
+	 *
+	 * @param[in] pid    ID of the process that the region belongs to
+	 * @param[in] region file-backed region
+	 *
+	 * @throws `std::system_error` if the region is not file-backed, if could not read the file, or if it is not a supported ELF file
+	 */
+	[[nodiscard]]
+	auto get(pid_t pid, memory_region const& region) -> std::shared_ptr<module_info const>;
+
+	/**
+	 * @brief Get metadata of all modules of a process.
+	 *
+	 * Modules that could not be loaded, such as non-ELF files, are skipped.
+	 *
+	 * @param[in] pid     process ID
+	 * @param[in] regions memory regions of the process
+	 *
+	 * @return metadata by module name
+	 */
+	[[nodiscard]]
+	auto get(pid_t pid, std::vector<memory_region> const& regions) -> std::map<std::string, std::shared_ptr<module_info const>, std::less<>>;
+
+	/**
+	 * @brief Get number of cached files.
+	 */
+	[[nodiscard]]
+	auto size() const -> std::size_t;
+
+	/**
+	 * @brief Remove all metadata from the cache.
+	 *
+	 * Metadata that is still referenced remains valid.
+	 */
+	auto clear() -> void;
+
+private:
+	/// Identity of a file.
+	struct file_key
+	{
+		std::uint64_t device;
+		std::uint64_t inode;
+		std::int64_t  mtime_sec;
+		std::int64_t  mtime_nsec;
+
+		[[nodiscard]]
+		auto operator<=>(file_key const&) const = default;
+	};
+
+	mutable std::mutex                                                      mutex_;
+	std::map<file_key, std::shared_ptr<module_info const>>                  by_file_;
+	std::map<std::string, std::shared_ptr<module_info const>, std::less<>> by_build_id_;
+};
+}
+
+#endif
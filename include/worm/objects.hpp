@@ -0,0 +1,88 @@
+#ifndef WORM_OBJECTS_HPP
+#define WORM_OBJECTS_HPP
+
+#include "module.hpp"
+#include "worm.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace worm
+{
+/// Options of object discovery.
+struct object_scan_options
+{
+	/**
+	 * @brief Whether or not to resolve names of dynamic types.
+	 *
+	 * Names are taken from Itanium ABI type information, or from vtable
+	 * symbols for modules built without it. Type names also confirm that
+	 * vtables found by their layout alone are genuine.
+	 */
+	bool resolve_names = true;
+
+	/// Whether or not to only look for objects in writable regions.
+	bool writable_only = true;
+
+	/// Maximum number of bytes read at once.
+	std::size_t chunk_size = 1 << 20;
+};
+
+/// Objects of a dynamic type.
+struct object_group
+{
+	/// Address point of the vtable of the type, which objects start with a pointer to.
+	address_t vtable;
+
+	/// Address point of the vtable relative to its module.
+	module_address location;
+
+	/// Demangled type name, or an empty string if it is unknown.
+	std::string name;
+
+	/// Addresses of objects, in ascending order.
+	std::vector<address_t> objects;
+};
+
+/**
+ * @brief Find polymorphic C++ objects by their vtable pointers.
+ *
+ * Vtables are located in `.data.rel.ro`, `.data.rel.ro.local` and `.rodata`
+ * of loaded modules by their Itanium ABI layout: a zero offset to top, a
+ * pointer to type information and a pointer to code. Vtables of modules built
+ * without type information are located by their symbols.
+ *
+ * Regions are then read in chunks and searched for aligned pointers to the
+ * address points of the vtables. Only the primary vtable pointer of an object
+ * is looked for, so that objects are reported once, at their start.
+ *
+ * @param[in] h       handle
+ * @param[in] regions memory regions of the process
+ * @param[in] options discovery options
+ *
+ * @return groups of objects by dynamic type, sorted by vtable address, without empty ones
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto find_objects(handle<Mode> const& h, std::vector<memory_region> const& regions, object_scan_options const& options = {})
+	-> std::vector<object_group>
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Find polymorphic C++ objects in all memory of a process.
+ *
+ * @param[in] h       handle
+ * @param[in] options discovery options
+ *
+ * @throws `std::system_error` if could not enumerate memory regions
+ *
+ * @return groups of objects by dynamic type, sorted by vtable address, without empty ones
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto find_objects(handle<Mode> const& h, object_scan_options const& options = {}) -> std::vector<object_group>
+	requires handle<Mode>::readable;
+}
+
+#endif
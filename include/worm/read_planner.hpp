@@ -0,0 +1,152 @@
+#ifndef WORM_READ_PLANNER_HPP
+#define WORM_READ_PLANNER_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace worm
+{
+/// Read planner options.
+struct read_planner_options
+{
+	/**
+	 * @brief Largest gap between requested bytes that is read through rather than split at.
+	 *
+	 * If it is not specified, it is measured by comparing the cost of a
+	 * vectored read of many small pieces with the cost of one large read.
+	 */
+	std::optional<std::size_t> gap_threshold;
+
+	/// Maximum number of bytes in a merged read.
+	std::size_t max_read_size = 1 << 20;
+};
+
+/// Read that covers one or more requested transfers.
+struct planned_read
+{
+	/// Remote virtual memory address of the first byte.
+	address_t address;
+
+	/// Number of bytes to read.
+	std::size_t size;
+
+	/// Index of the first covered transfer in the order of the plan.
+	std::size_t first;
+
+	/// Number of covered transfers.
+	std::size_t count;
+};
+
+/// Plan of reads for a set of transfers.
+struct read_plan
+{
+	/// Reads, sorted by address.
+	std::vector<planned_read> reads;
+
+	/// Indices of transfers, sorted by address, which reads refer to.
+	std::vector<std::size_t> order;
+
+	/// Number of bytes read, including gaps.
+	std::size_t bytes = 0;
+
+	/// Number of system calls that the reads take.
+	std::size_t calls = 0;
+};
+
+/**
+ * @brief Planner of batched reads.
+ *
+ * Requested transfers are sorted, and transfers separated by gaps below a
+ * threshold are merged into a single read, as reading a few extra bytes is
+ * cheaper than another vector element. Transfers are never merged across
+ * boundaries of memory regions, so that a merged read does not fail where
+ * separate ones would succeed. Reads are issued in batches of `IOV_MAX`.
+ *
+ * A plan can be reused for any transfers with the same addresses and sizes,
+ * which makes repeated polling of the same values cheaper still.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct read_planner
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Construct a planner.
+	 *
+	 * @param[in] h       handle, which must outlive the planner
+	 * @param[in] regions memory regions of the process
+	 * @param[in] options planner options
+	 */
+	explicit read_planner(handle_type const& h, std::vector<memory_region> const& regions, read_planner_options const& options = {})
+		requires handle_type::readable;
+
+	/**
+	 * @brief Construct a planner for the current memory regions of a process.
+	 *
+	 * @param[in] h       handle, which must outlive the planner
+	 * @param[in] options planner options
+	 *
+	 * @throws `std::system_error` if could not enumerate memory regions
+	 */
+	explicit read_planner(handle_type const& h, read_planner_options const& options = {})
+		requires handle_type::readable;
+
+	/**
+	 * @brief Replace memory regions, e.g. after the process mapped or unmapped memory.
+	 *
+	 * @param[in] regions memory regions of the process
+	 */
+	auto update_regions(std::vector<memory_region> const& regions) -> void;
+
+	/**
+	 * @brief Get the largest gap that is read through.
+	 */
+	[[nodiscard]]
+	auto gap_threshold() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Plan reads of transfers.
+	 *
+	 * @param[in] transfers transfers
+	 */
+	[[nodiscard]]
+	auto plan(std::span<memory_transfer const> transfers) const -> read_plan;
+
+	/**
+	 * @brief Read transfers according to a plan.
+	 *
+	 * @param[in]     plan      plan made for transfers with the same addresses and sizes
+	 * @param[in,out] transfers transfers, of which the number of transferred bytes is set
+	 *
+	 * @throws `std::system_error` on failed read attempt other than an inaccessible address
+	 *
+	 * @return total number of bytes transferred into the transfers
+	 */
+	auto read(read_plan const& plan, std::span<memory_transfer> transfers) const -> std::size_t;
+
+	/**
+	 * @brief Plan and read transfers.
+	 *
+	 * @param[in,out] transfers transfers, of which the number of transferred bytes is set
+	 *
+	 * @throws `std::system_error` on failed read attempt other than an inaccessible address
+	 *
+	 * @return total number of bytes transferred into the transfers
+	 */
+	auto read(std::span<memory_transfer> transfers) const -> std::size_t;
+
+private:
+	handle_type const*         h_;
+	std::size_t                gap_threshold_;
+	std::size_t                max_read_size_;
+	std::vector<address_range> ranges_;
+};
+}
+
+#endif
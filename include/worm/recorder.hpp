@@ -0,0 +1,146 @@
+#ifndef WORM_RECORDER_HPP
+#define WORM_RECORDER_HPP
+
+#include "worm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace worm
+{
+/// Recorder options.
+struct recorder_options
+{
+	/// Interval between captures, or zero to capture only on demand.
+	std::chrono::nanoseconds interval = std::chrono::milliseconds(100);
+
+	/// Path of the log file, or an empty string to keep the log in an anonymous memory file.
+	std::string path;
+
+	/// Maximum number of bytes in the log, which is reserved up front without being committed.
+	std::size_t capacity = std::size_t{1} << 30;
+
+	/**
+	 * @brief Whether or not to find written pages with soft-dirty bits rather than by hashing every page.
+	 *
+	 * Bits cannot be read and cleared at once from another process, so that
+	 * writes between the two, or bits cleared by anyone else, are missed until
+	 * the next resync.
+	 */
+	bool soft_dirty = false;
+
+	/// Number of frames between resyncs that hash every page while soft-dirty bits are used, or `0` to never resync.
+	std::size_t resync_frames = 16;
+};
+
+/// Captured frame of a recording.
+struct recorded_frame
+{
+	/// Time of the capture.
+	std::chrono::system_clock::time_point time;
+
+	/// Number of pages that changed since the previous frame.
+	std::size_t pages;
+};
+
+/**
+ * @brief Recorder of changes of memory regions over time.
+ *
+ * Every capture appends only the pages that changed since the previous one to
+ * an append-only, memory-mapped log, and indexes them by page address, so
+ * that the regions as of any past frame are reconstructed at a fraction of
+ * the cost of periodic full dumps. The first frame holds every readable page.
+ *
+ * Written pages are found by hashing every page, or optionally with
+ * soft-dirty bits, which reads only written pages but clears the bits for the
+ * whole process. Soft-dirty bits are not exact: pages written between finding
+ * and clearing the bits are missed, and so are pages whose bits were cleared
+ * by anyone else, such as `handle::wait_until` with
+ * `wait_options::soft_dirty`. Missed pages are recorded by the next resync,
+ * which hashes every page. Pages whose contents did not change are never
+ * logged.
+ *
+ * It is only supported on Linux.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct recorder
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Create a log, capture the first frame, and start capturing periodically.
+	 *
+	 * @param[in] h       handle, which must outlive the recorder
+	 * @param[in] regions memory regions, of which only readable ones are recorded
+	 * @param[in] options recorder options
+	 *
+	 * @throws `std::system_error` if could not create the log, or capture the first frame
+	 */
+	explicit recorder(handle_type const& h, std::vector<memory_region> const& regions, recorder_options const& options = {})
+		requires handle_type::readable;
+
+	recorder(recorder const&)                    = delete;
+	auto operator=(recorder const&) -> recorder& = delete;
+
+	/**
+	 * @brief Stop capturing, and unmap the log.
+	 *
+	 * A log file is kept.
+	 */
+	~recorder();
+
+	/**
+	 * @brief Capture a frame right away.
+	 *
+	 * @throws `std::system_error` if the log is full, or on failed read attempt other than an inaccessible address
+	 *
+	 * @return number of pages that changed since the previous frame
+	 */
+	auto capture() -> std::size_t;
+
+	/**
+	 * @brief Get captured frames, in order.
+	 */
+	[[nodiscard]]
+	auto frames() const -> std::vector<recorded_frame>;
+
+	/**
+	 * @brief Reconstruct bytes as of a frame.
+	 *
+	 * @param[in]  frame index of the frame
+	 * @param[in]  src   remote virtual memory address
+	 * @param[out] dst   local buffer
+	 * @param[in]  size  number of bytes to reconstruct
+	 *
+	 * @throws `std::out_of_range` if the frame was not captured
+	 *
+	 * @return number of leading bytes that were recorded by the frame, and so reconstructed
+	 */
+	auto read_bytes(std::size_t frame, address_t src, void* dst, std::size_t size) const -> std::size_t;
+
+	/**
+	 * @brief Get number of bytes in the log.
+	 */
+	[[nodiscard]]
+	auto log_size() const -> std::size_t;
+
+	/**
+	 * @brief Check whether written pages are found with soft-dirty bits.
+	 */
+	[[nodiscard]]
+	auto soft_dirty() const noexcept -> bool;
+
+private:
+	/// Internal state of a recorder.
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef WORM_REFERENCES_HPP
+#define WORM_REFERENCES_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace worm
+{
+/// Options of reference search.
+struct reference_options
+{
+	/// Alignment of referring pointers, which either divides or is a multiple of the size of an address.
+	std::size_t alignment = alignof(address_t);
+
+	/// Number of worker threads, or `0` to use hardware concurrency.
+	std::size_t threads = 0;
+
+	/// Number of bytes that a worker reads at once.
+	std::size_t chunk_size = 1 << 20;
+};
+
+/// Pointer into a target range.
+struct reference
+{
+	/// Remote virtual memory address of the pointer.
+	address_t address;
+
+	/// Offset of the pointed to address from the start of the target range.
+	std::size_t offset;
+};
+
+/**
+ * @brief Find pointers into an address range, e.g. to an object.
+ *
+ * Readable regions are split into chunks that are read in bulk by parallel
+ * workers, and every aligned pointer-sized value is compared against the
+ * range several at once. Chunks that could not be read are skipped.
+ *
+ * @param[in] h       handle
+ * @param[in] regions regions to search, of which only readable ones are searched
+ * @param[in] target  range of addresses pointed into
+ * @param[in] options search options
+ *
+ * @throws `std::invalid_argument` if the alignment neither divides nor is a multiple of the size of an address
+ *
+ * @return references, sorted by address
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto find_references(handle<Mode> const& h, std::vector<memory_region> const& regions, address_range target, reference_options const& options = {})
+	-> std::vector<reference>
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Find pointers into an address range in all readable virtual memory.
+ *
+ * @param[in] h       handle
+ * @param[in] target  range of addresses pointed into
+ * @param[in] options search options
+ *
+ * @throws `std::system_error` if could not enumerate memory regions
+ * @throws `std::invalid_argument` if the alignment neither divides nor is a multiple of the size of an address
+ *
+ * @return references, sorted by address
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto find_references(handle<Mode> const& h, address_range target, reference_options const& options = {}) -> std::vector<reference>
+	requires handle<Mode>::readable;
+}
+
+#endif
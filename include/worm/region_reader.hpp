@@ -0,0 +1,120 @@
+#ifndef WORM_REGION_READER_HPP
+#define WORM_REGION_READER_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace worm
+{
+/// Chunk of virtual memory read by a region reader.
+struct memory_chunk
+{
+	/// Remote virtual memory address of the first byte.
+	address_t address;
+
+	/**
+	 * @brief Read bytes.
+	 *
+	 * It is shorter than requested, or empty, if a part of the chunk could not be read.
+	 */
+	std::span<unsigned char const> data;
+};
+
+/// Region reader options.
+struct region_reader_options
+{
+	/// Maximum number of bytes in a chunk.
+	std::size_t chunk_size = 1 << 20;
+
+	/// Maximum number of chunks that are read ahead of the consumer.
+	std::size_t depth = 2;
+
+	/**
+	 * @brief Number of bytes that each chunk shares with the previous chunk of the same range.
+	 *
+	 * It allows values that cross chunk boundaries to be seen whole.
+	 */
+	std::size_t overlap = 0;
+};
+
+/**
+ * @brief Pipelined reader of virtual memory ranges.
+ *
+ * It splits ranges into chunks and reads them on a background thread ahead of
+ * the consumer, so that reading the next chunks overlaps with processing the
+ * current one. At most `depth` chunks are read ahead, after which the reader
+ * waits for the consumer.
+ *
+ * Chunks are delivered in order, one per chunk of the ranges, including the
+ * ones that could not be read.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct region_reader
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Construct a reader of address ranges.
+	 *
+	 * @param[in] h       handle, which must outlive the reader
+	 * @param[in] ranges  address ranges to read
+	 * @param[in] options reader options
+	 */
+	explicit region_reader(handle_type const& h, std::vector<address_range> ranges, region_reader_options const& options = {})
+		requires handle_type::readable;
+
+	/**
+	 * @brief Construct a reader of readable memory regions.
+	 *
+	 * @param[in] h       handle, which must outlive the reader
+	 * @param[in] regions memory regions, of which only readable ones are read
+	 * @param[in] options reader options
+	 */
+	explicit region_reader(handle_type const& h, std::vector<memory_region> const& regions, region_reader_options const& options = {})
+		requires handle_type::readable;
+
+	region_reader(region_reader const&)                    = delete;
+	auto operator=(region_reader const&) -> region_reader& = delete;
+
+	region_reader(region_reader&&) noexcept;
+	auto operator=(region_reader&&) noexcept -> region_reader&;
+
+	/**
+	 * @brief Destruct a reader.
+	 *
+	 * Stop the reader thread.
+	 */
+	~region_reader();
+
+	/**
+	 * @brief Get the next chunk.
+	 *
+	 * Block until the chunk is read. The chunk remains valid until the next call.
+	 *
+	 * @throws exception thrown by the reader thread, other than a failed read attempt
+	 *
+	 * @return next chunk, or `std::nullopt` if all chunks have been delivered
+	 */
+	[[nodiscard]]
+	auto next() -> std::optional<memory_chunk>;
+
+private:
+	/**
+	 * @brief Internal state of a reader.
+	 *
+	 * It is shared with the reader thread.
+	 */
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#endif
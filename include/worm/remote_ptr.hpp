@@ -0,0 +1,157 @@
+#ifndef WORM_REMOTE_PTR_HPP
+#define WORM_REMOTE_PTR_HPP
+
+#include "worm.hpp"
+
+#include <compare>
+#include <cstddef>
+#include <type_traits>
+
+namespace worm
+{
+template <handle_mode Mode>
+template <typename T>
+struct handle<Mode>::remote_ptr
+{
+	static_assert(std::is_trivially_copyable_v<T>, "pointed type must be trivially copyable");
+
+	using handle_type     = handle<Mode>;
+	using value_type      = T;
+	using difference_type = std::ptrdiff_t;
+
+	/// Whether or not pointed value can be read.
+	static constexpr bool readable = handle_type::readable;
+
+	/// Construct a null pointer.
+	remote_ptr() noexcept = default;
+
+	/**
+	 * @brief Construct a pointer.
+	 *
+	 * @param[in] h    handle
+	 * @param[in] addr remote virtual memory address
+	 */
+	explicit remote_ptr(handle_type const& h, address_t addr) noexcept;
+
+	/**
+	 * @brief Get pointed remote virtual memory address.
+	 */
+	[[nodiscard]]
+	auto address() const noexcept -> address_t;
+
+	/**
+	 * @brief Check whether the pointer is not null.
+	 */
+	[[nodiscard]]
+	explicit operator bool() const noexcept;
+
+	/**
+	 * @brief Dereference the pointer.
+	 *
+	 * The pointed value is read once and cached until invalidated.
+	 *
+	 * @throws `std::system_error` on failed read attempt
+	 */
+	[[nodiscard]]
+	auto operator*() const -> value_type const&
+		requires readable;
+
+	/**
+	 * @brief Access a member of the pointed value.
+	 *
+	 * The pointed value is read once and cached until invalidated.
+	 *
+	 * @throws `std::system_error` on failed read attempt
+	 */
+	[[nodiscard]]
+	auto operator->() const -> value_type const*
+		requires readable;
+
+	/**
+	 * @brief Read a value at an offset from the pointer.
+	 *
+	 * @param[in] n offset in values
+	 *
+	 * @throws `std::system_error` on failed read attempt
+	 */
+	[[nodiscard]]
+	auto operator[](difference_type n) const -> value_type
+		requires readable;
+
+	/**
+	 * @brief Point to a member of the pointed value without reading it.
+	 *
+	 * @tparam U type of the member
+	 * @tparam C class that the member belongs to
+	 *
+	 * @param[in] member pointer to the member
+	 */
+	template <typename U, typename C>
+	[[nodiscard]]
+	auto operator->*(U C::* member) const noexcept -> remote_ptr<U>
+		requires std::is_same_v<C, T>;
+
+	/**
+	 * @brief Follow a pointer stored in the pointed value.
+	 *
+	 * @throws `std::system_error` on failed read attempt
+	 */
+	[[nodiscard]]
+	auto follow() const -> remote_ptr<std::remove_cv_t<std::remove_pointer_t<T>>>
+		requires readable && std::is_pointer_v<T>;
+
+	/**
+	 * @brief Discard the cached value, so that it is read again on next dereference.
+	 */
+	auto invalidate() const noexcept -> void;
+
+	auto operator++() noexcept -> remote_ptr&;
+	auto operator++(int) noexcept -> remote_ptr;
+	auto operator--() noexcept -> remote_ptr&;
+	auto operator--(int) noexcept -> remote_ptr;
+	auto operator+=(difference_type n) noexcept -> remote_ptr&;
+	auto operator-=(difference_type n) noexcept -> remote_ptr&;
+
+	[[nodiscard]]
+	auto operator+(difference_type n) const noexcept -> remote_ptr;
+
+	[[nodiscard]]
+	auto operator-(difference_type n) const noexcept -> remote_ptr;
+
+	[[nodiscard]]
+	auto operator-(remote_ptr const& other) const noexcept -> difference_type;
+
+	[[nodiscard]]
+	auto operator==(remote_ptr const& other) const noexcept -> bool;
+
+	[[nodiscard]]
+	auto operator<=>(remote_ptr const& other) const noexcept -> std::strong_ordering;
+
+private:
+	/// Storage for the cached value that does not require `T` to be default-constructible.
+	union storage
+	{
+		storage() noexcept
+		{}
+
+		T value;
+	};
+
+	/**
+	 * @brief Read the pointed value into the cache, unless already cached.
+	 *
+	 * @throws `std::system_error` on failed read attempt
+	 */
+	auto fetch() const -> value_type const&
+		requires readable;
+
+	handle_type const* h_{};
+	address_t          addr_{};
+	mutable bool       cached_{};
+	mutable storage    cache_;
+};
+}
+
+#include "remote_ptr.inl"
+
+#endif
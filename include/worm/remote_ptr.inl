@@ -0,0 +1,180 @@
+namespace worm
+{
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::ptr(address_t addr) const& noexcept -> remote_ptr<T>
+{
+	return remote_ptr<T>(*this, addr);
+}
+
+template <handle_mode Mode>
+template <typename T>
+handle<Mode>::remote_ptr<T>::remote_ptr(handle_type const& h, address_t addr) noexcept
+	: h_{&h}
+	, addr_{addr}
+{}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::address() const noexcept -> address_t
+{
+	return addr_;
+}
+
+template <handle_mode Mode>
+template <typename T>
+handle<Mode>::remote_ptr<T>::operator bool() const noexcept
+{
+	return addr_ != 0;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::fetch() const -> value_type const&
+	requires readable
+{
+	if (!cached_)
+	{
+		h_->read_bytes(addr_, &cache_.value, sizeof(value_type));
+		cached_ = true;
+	}
+
+	return cache_.value;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator*() const -> value_type const&
+	requires readable
+{
+	return fetch();
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator->() const -> value_type const*
+	requires readable
+{
+	return &fetch();
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator[](difference_type n) const -> value_type
+	requires readable
+{
+	return *(*this + n);
+}
+
+template <handle_mode Mode>
+template <typename T>
+template <typename U, typename C>
+auto handle<Mode>::remote_ptr<T>::operator->*(U C::* member) const noexcept -> remote_ptr<U>
+	requires std::is_same_v<C, T>
+{
+	// Only the address of the member within the storage is taken, the value is not accessed.
+	auto const offset = reinterpret_cast<unsigned char const*>(&(cache_.value.*member)) - reinterpret_cast<unsigned char const*>(&cache_.value);
+
+	return remote_ptr<U>(*h_, addr_ + offset);
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::follow() const -> remote_ptr<std::remove_cv_t<std::remove_pointer_t<T>>>
+	requires readable && std::is_pointer_v<T>
+{
+	return remote_ptr<std::remove_cv_t<std::remove_pointer_t<T>>>(*h_, reinterpret_cast<address_t>(fetch()));
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::invalidate() const noexcept -> void
+{
+	cached_ = false;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator++() noexcept -> remote_ptr&
+{
+	return *this += 1;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator++(int) noexcept -> remote_ptr
+{
+	auto const copy = *this;
+	++*this;
+	return copy;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator--() noexcept -> remote_ptr&
+{
+	return *this -= 1;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator--(int) noexcept -> remote_ptr
+{
+	auto const copy = *this;
+	--*this;
+	return copy;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator+=(difference_type n) noexcept -> remote_ptr&
+{
+	addr_ += static_cast<address_t>(n) * sizeof(value_type);
+	cached_ = false;
+	return *this;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator-=(difference_type n) noexcept -> remote_ptr&
+{
+	addr_ -= static_cast<address_t>(n) * sizeof(value_type);
+	cached_ = false;
+	return *this;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator+(difference_type n) const noexcept -> remote_ptr
+{
+	return remote_ptr(*h_, addr_ + static_cast<address_t>(n) * sizeof(value_type));
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator-(difference_type n) const noexcept -> remote_ptr
+{
+	return remote_ptr(*h_, addr_ - static_cast<address_t>(n) * sizeof(value_type));
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator-(remote_ptr const& other) const noexcept -> difference_type
+{
+	return static_cast<difference_type>(addr_ - other.addr_) / static_cast<difference_type>(sizeof(value_type));
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator==(remote_ptr const& other) const noexcept -> bool
+{
+	return addr_ == other.addr_;
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto handle<Mode>::remote_ptr<T>::operator<=>(remote_ptr const& other) const noexcept -> std::strong_ordering
+{
+	return addr_ <=> other.addr_;
+}
+}
@@ -0,0 +1,312 @@
+#ifndef WORM_SCAN_HPP
+#define WORM_SCAN_HPP
+
+#include "address_set.hpp"
+#include "worm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace worm
+{
+/// Byte pattern to scan for.
+struct pattern
+{
+	/// Bytes to match.
+	std::vector<unsigned char> bytes;
+
+	/// Mask of bytes to match, with `0xff` for bytes that have to match and `0x00` for wildcards.
+	std::vector<unsigned char> mask;
+
+	/**
+	 * @brief Construct a pattern that matches object representation of a value.
+	 *
+	 * @tparam T type of the value
+	 *
+	 * @param[in] value value
+	 */
+	template <typename T>
+	[[nodiscard]]
+	static auto value(T const& value) -> pattern
+		requires std::is_trivially_copyable_v<T>;
+
+	/**
+	 * @brief Construct a pattern that matches characters of a string, without the terminator.
+	 *
+	 * @param[in] str string
+	 */
+	[[nodiscard]]
+	static auto text(std::string_view str) -> pattern;
+
+	/**
+	 * @brief Parse a signature.
+	 *
+	 * A signature is a whitespace-separated list of hexadecimal bytes and
+	 * wildcards, e.g. `48 8B 05 ?? ?? ?? ??`.
+	 *
+	 * @param[in] signature signature
+	 *
+	 * @throws `std::invalid_argument` if the signature is malformed or empty
+	 */
+	[[nodiscard]]
+	static auto signature(std::string_view signature) -> pattern;
+
+	/**
+	 * @brief Get number of bytes in the pattern.
+	 */
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t;
+};
+
+/// Way of reading memory during a scan.
+enum struct scan_strategy
+{
+	/// Read chunks synchronously on worker threads, which is cheaper for small scans.
+	direct,
+
+	/// Read chunks through region readers, so that reading overlaps with matching.
+	streaming,
+};
+
+/// Memory scan options.
+struct scan_options
+{
+	/// Alignment of matched addresses.
+	std::size_t alignment = 1;
+
+	/// Number of worker threads, or `0` to use hardware concurrency.
+	std::size_t threads = 0;
+
+	/// Number of bytes that a worker reads at once.
+	std::size_t chunk_size = 1 << 20;
+
+	/// Representation of the result, or `std::nullopt` to choose it by estimating the scan.
+	std::optional<set_representation> representation;
+
+	/// Strategy of the scan, or `std::nullopt` to choose it by estimating the scan.
+	std::optional<scan_strategy> strategy;
+
+	/// Number of samples taken to estimate a scan.
+	std::size_t samples = 64;
+
+	/// Number of bytes in a sample.
+	std::size_t sample_size = 1 << 12;
+};
+
+/// Estimated cost of a memory scan.
+struct scan_estimate
+{
+	/// Number of bytes to read.
+	std::size_t bytes;
+
+	/// Number of sampled bytes that could be read.
+	std::size_t sampled_bytes;
+
+	/// Number of matches in the samples.
+	std::size_t sampled_hits;
+
+	/// Expected number of matches per byte.
+	double hit_density;
+
+	/// Expected number of matches.
+	std::size_t expected_hits;
+
+	/// Expected number of bytes taken by the result.
+	std::size_t expected_result_size;
+
+	/// Expected wall-clock duration of the scan.
+	std::chrono::nanoseconds expected_duration;
+
+	/// Representation of the result that takes less memory.
+	set_representation representation;
+
+	/// Strategy that is expected to be faster.
+	scan_strategy strategy;
+};
+
+/**
+ * @brief Estimate cost of a memory scan.
+ *
+ * Read a few random samples of readable regions, weighted by size, and
+ * measure density of matches and throughput of reading and matching. The
+ * estimate is only as good as the samples are representative, so it is meant
+ * for planning scans and warning about expensive ones rather than for exact
+ * figures.
+ *
+ * @param[in] h       handle
+ * @param[in] regions regions to scan, of which only readable ones are considered
+ * @param[in] p       pattern to scan for
+ * @param[in] options scan options
+ *
+ * @return estimate of the scan
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto estimate_scan(handle<Mode> const& h, std::vector<memory_region> const& regions, pattern const& p, scan_options const& options = {}) -> scan_estimate
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Scan virtual memory for a pattern.
+ *
+ * Readable regions are split into chunks, which overlap so that matches
+ * crossing chunk boundaries are found, and are matched in parallel. Chunks
+ * that could not be read are skipped.
+ *
+ * If either the representation or the strategy is not specified, the scan is
+ * estimated first. Pass the choices of `estimate_scan` to avoid estimating
+ * twice.
+ *
+ * @param[in] h       handle
+ * @param[in] regions regions to scan, of which only readable ones are scanned
+ * @param[in] p       pattern to scan for
+ * @param[in] options scan options
+ *
+ * @return addresses of matches
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto scan(handle<Mode> const& h, std::vector<memory_region> const& regions, pattern const& p, scan_options const& options = {}) -> address_set
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Scan all readable virtual memory for a pattern.
+ *
+ * @param[in] h       handle
+ * @param[in] p       pattern to scan for
+ * @param[in] options scan options
+ *
+ * @throws `std::system_error` if could not enumerate memory regions
+ *
+ * @return addresses of matches
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto scan(handle<Mode> const& h, pattern const& p, scan_options const& options = {}) -> address_set
+	requires handle<Mode>::readable;
+
+/// Budget of a step of an incremental scan.
+struct scan_budget
+{
+	/// Longest duration of the step, or `std::nullopt` for no limit.
+	std::optional<std::chrono::nanoseconds> time;
+
+	/// Maximum number of bytes to read in the step, or `std::nullopt` for no limit.
+	std::optional<std::size_t> bytes;
+};
+
+/// Progress of an incremental scan.
+struct scan_progress
+{
+	/// Number of bytes scanned so far.
+	std::size_t scanned_bytes;
+
+	/// Number of bytes to scan in total.
+	std::size_t total_bytes;
+
+	/// Number of matches found so far.
+	std::size_t hits;
+
+	/// Whether or not the scan is complete.
+	bool done;
+};
+
+/**
+ * @brief Memory scan that runs in steps.
+ *
+ * Each step reads and matches readable regions on the calling thread until
+ * its budget runs out, so that a scan can run inside an event loop or a frame
+ * loop without blocking it for long. The size of each read is adapted to the
+ * measured throughput, so that steps overrun a time budget by little. Every
+ * step makes some progress, even with an exhausted budget.
+ *
+ * Matches found so far are available between steps.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct incremental_scan
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Prepare a scan.
+	 *
+	 * Representation, strategy and thread count of the options are ignored.
+	 *
+	 * @param[in] h       handle, which must outlive the scan
+	 * @param[in] regions regions to scan, of which only readable ones are scanned
+	 * @param[in] p       pattern to scan for
+	 * @param[in] options scan options
+	 */
+	explicit incremental_scan(handle_type const& h, std::vector<memory_region> const& regions, pattern p, scan_options const& options = {})
+		requires handle_type::readable;
+
+	/**
+	 * @brief Prepare a scan of all readable virtual memory.
+	 *
+	 * @param[in] h       handle, which must outlive the scan
+	 * @param[in] p       pattern to scan for
+	 * @param[in] options scan options
+	 *
+	 * @throws `std::system_error` if could not enumerate memory regions
+	 */
+	explicit incremental_scan(handle_type const& h, pattern p, scan_options const& options = {})
+		requires handle_type::readable;
+
+	incremental_scan(incremental_scan&&) noexcept;
+	auto operator=(incremental_scan&&) noexcept -> incremental_scan&;
+
+	~incremental_scan();
+
+	/**
+	 * @brief Scan until the budget runs out or the scan is complete.
+	 *
+	 * @param[in] budget budget of the step
+	 *
+	 * @return progress after the step
+	 */
+	auto step(scan_budget const& budget) -> scan_progress;
+
+	/**
+	 * @brief Get progress of the scan.
+	 */
+	[[nodiscard]]
+	auto progress() const noexcept -> scan_progress;
+
+	/**
+	 * @brief Check whether the scan is complete.
+	 */
+	[[nodiscard]]
+	auto done() const noexcept -> bool;
+
+	/**
+	 * @brief Get addresses of matches found so far, in ascending order.
+	 *
+	 * They remain valid until the next step.
+	 */
+	[[nodiscard]]
+	auto hits() const noexcept -> std::span<address_t const>;
+
+	/**
+	 * @brief Copy matches found so far into an address set.
+	 */
+	[[nodiscard]]
+	auto result() const -> address_set;
+
+private:
+	/// Internal state of a scan.
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#include "scan.inl"
+
+#endif
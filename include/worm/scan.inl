@@ -0,0 +1,14 @@
+#include <cstring>
+
+namespace worm
+{
+template <typename T>
+auto pattern::value(T const& value) -> pattern
+	requires std::is_trivially_copyable_v<T>
+{
+	pattern p{std::vector<unsigned char>(sizeof(T)), std::vector<unsigned char>(sizeof(T), 0xff)};
+	std::memcpy(p.bytes.data(), &value, sizeof(T));
+
+	return p;
+}
+}
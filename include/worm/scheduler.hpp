@@ -0,0 +1,131 @@
+#ifndef WORM_SCHEDULER_HPP
+#define WORM_SCHEDULER_HPP
+
+#include "worm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace worm
+{
+/// Scheduler options.
+struct scheduler_options
+{
+	/// Resolution of the timer wheel, to which periods are rounded up.
+	std::chrono::nanoseconds tick = std::chrono::milliseconds(1);
+
+	/// Number of slots of the timer wheel.
+	std::size_t slots = 512;
+
+	/// Number of worker threads that run due jobs.
+	std::size_t threads = 2;
+};
+
+/// Identifier of a scheduled job.
+using job_id = std::uint64_t;
+
+/**
+ * @brief Scheduler of periodic jobs against handles.
+ *
+ * Jobs are kept in a hashed timer wheel that a single timer thread advances
+ * every tick, and due jobs are run by a small pool of workers, so that
+ * thousands of jobs take a few threads. Reads and writes due in the same
+ * tick against the same handle are grouped into a single vectored transfer.
+ *
+ * Deadlines advance by whole periods, so that jobs do not drift. An
+ * occurrence of a job is skipped if its previous one is still running, or
+ * if the timer thread fell behind it by more than a period.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct scheduler
+{
+	using handle_type = handle<Mode>;
+
+	/// Function called with read bytes, of which only the transferred ones are valid.
+	using read_callback = std::function<void(std::span<unsigned char const> bytes, std::size_t transferred)>;
+
+	/**
+	 * @brief Start a scheduler.
+	 *
+	 * @param[in] options scheduler options
+	 */
+	explicit scheduler(scheduler_options const& options = {});
+
+	scheduler(scheduler const&)                    = delete;
+	auto operator=(scheduler const&) -> scheduler& = delete;
+
+	/**
+	 * @brief Stop the scheduler, waiting for running jobs.
+	 */
+	~scheduler();
+
+	/**
+	 * @brief Schedule a function.
+	 *
+	 * @param[in] period interval between runs
+	 * @param[in] job    function to run
+	 *
+	 * @return identifier of the job
+	 */
+	auto schedule(std::chrono::nanoseconds period, std::function<void()> job) -> job_id;
+
+	/**
+	 * @brief Schedule a periodic read.
+	 *
+	 * @param[in] h       handle, which must outlive the job
+	 * @param[in] addr    remote virtual memory address
+	 * @param[in] size    number of bytes to read
+	 * @param[in] period  interval between reads
+	 * @param[in] on_read function called after every read
+	 *
+	 * @return identifier of the job
+	 */
+	auto schedule_read(handle_type const& h, address_t addr, std::size_t size, std::chrono::nanoseconds period, read_callback on_read) -> job_id
+		requires handle_type::readable;
+
+	/**
+	 * @brief Schedule a periodic write, e.g. to freeze a value.
+	 *
+	 * @param[in] h      handle, which must outlive the job
+	 * @param[in] addr   remote virtual memory address
+	 * @param[in] bytes  bytes to write
+	 * @param[in] period interval between writes
+	 *
+	 * @return identifier of the job
+	 */
+	auto schedule_write(handle_type const& h, address_t addr, std::vector<unsigned char> bytes, std::chrono::nanoseconds period) -> job_id
+		requires handle_type::writable;
+
+	/**
+	 * @brief Cancel a job.
+	 *
+	 * A run of the job that already started is not interrupted.
+	 *
+	 * @param[in] id identifier of the job
+	 *
+	 * @return whether or not the job was scheduled
+	 */
+	auto cancel(job_id id) -> bool;
+
+	/**
+	 * @brief Get number of skipped occurrences of jobs.
+	 */
+	[[nodiscard]]
+	auto skipped() const noexcept -> std::size_t;
+
+private:
+	/// Internal state of a scheduler.
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef WORM_SHARED_BUFFER_HPP
+#define WORM_SHARED_BUFFER_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace worm
+{
+/**
+ * @brief Memory shared with a remote process.
+ *
+ * It maps the same memory both into the remote process and locally, so that
+ * data can be exchanged with a cooperative process through plain loads and
+ * stores, without a system call per transfer.
+ *
+ * On POSIX, `memfd_create` and `mmap` are injected into the main thread of the
+ * remote process with `ptrace`, which briefly stops all of its threads and
+ * requires the permission to trace it. Only x86-64 is supported. On Windows, a view of a
+ * local file mapping is mapped into the remote process with `MapViewOfFile2`.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct shared_buffer
+{
+	using handle_type = handle<Mode>;
+
+	/**
+	 * @brief Construct a shared buffer.
+	 *
+	 * @param[in] h    handle, which must outlive the buffer
+	 * @param[in] size number of bytes to share, rounded up to a multiple of the page size
+	 *
+	 * @throws `std::system_error` on failure to map the buffer either remotely or locally
+	 */
+	explicit shared_buffer(handle_type const& h, std::size_t size)
+		requires handle_type::readable && handle_type::writable;
+
+	shared_buffer(shared_buffer const&)                    = delete;
+	auto operator=(shared_buffer const&) -> shared_buffer& = delete;
+
+	shared_buffer(shared_buffer&&) noexcept;
+	auto operator=(shared_buffer&&) noexcept -> shared_buffer&;
+
+	/**
+	 * @brief Destruct a shared buffer.
+	 *
+	 * Unmap the buffer locally and, if possible, remotely.
+	 */
+	~shared_buffer();
+
+	/**
+	 * @brief Get local address of the first shared byte.
+	 */
+	[[nodiscard]]
+	auto data() const noexcept -> void*;
+
+	/**
+	 * @brief Get remote virtual memory address of the first shared byte.
+	 */
+	[[nodiscard]]
+	auto address() const noexcept -> address_t;
+
+	/**
+	 * @brief Get number of shared bytes, which is a multiple of the page size.
+	 */
+	[[nodiscard]]
+	auto size() const noexcept -> std::size_t;
+
+	/**
+	 * @brief Rebase a remote virtual memory address into the buffer.
+	 *
+	 * @tparam T type of pointed value
+	 *
+	 * @param[in] addr remote virtual memory address
+	 *
+	 * @return local pointer, or `nullptr` if the address is not shared
+	 */
+	template <typename T = void>
+	[[nodiscard]]
+	auto local(address_t addr) const noexcept -> T*;
+
+	/**
+	 * @brief Rebase a local pointer into the remote process.
+	 *
+	 * @param[in] ptr local pointer into the buffer
+	 *
+	 * @return remote virtual memory address, or `0` if the pointer is not into the buffer
+	 */
+	[[nodiscard]]
+	auto remote(void const* ptr) const noexcept -> address_t;
+
+private:
+	/**
+	 * @brief Internal state of a shared buffer.
+	 *
+	 * It owns the local and the remote mapping.
+	 */
+	struct state;
+
+	std::unique_ptr<state> state_;
+	address_t              addr_;
+	std::size_t            size_;
+};
+}
+
+#include "shared_buffer.inl"
+
+#endif
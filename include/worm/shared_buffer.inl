@@ -0,0 +1,14 @@
+namespace worm
+{
+template <handle_mode Mode>
+template <typename T>
+auto shared_buffer<Mode>::local(address_t addr) const noexcept -> T*
+{
+	if (addr < addr_ || addr - addr_ >= size_)
+	{
+		return nullptr;
+	}
+
+	return reinterpret_cast<T*>(static_cast<unsigned char*>(data()) + (addr - addr_));
+}
+}
@@ -0,0 +1,89 @@
+#ifndef WORM_STRINGS_HPP
+#define WORM_STRINGS_HPP
+
+#include "worm.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace worm
+{
+/**
+ * @brief Read a NUL-terminated string.
+ *
+ * The string is read in chunks that end at page boundaries, so that a read
+ * never crosses into an unmapped page past the terminator, and chunks grow
+ * for long strings.
+ *
+ * @param[in] h          handle
+ * @param[in] addr       remote virtual memory address of the first character
+ * @param[in] max_length maximum number of characters, after which the string is truncated
+ *
+ * @throws `std::system_error` on failed read attempt, or if memory ends before the terminator
+ *
+ * @return string without the terminator
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_cstring(handle<Mode> const& h, address_t addr, std::size_t max_length = 1 << 12) -> std::string
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read a NUL-terminated wide string, with characters as large as `wchar_t`.
+ *
+ * @param[in] h          handle
+ * @param[in] addr       remote virtual memory address of the first character
+ * @param[in] max_length maximum number of characters, after which the string is truncated
+ *
+ * @throws `std::system_error` on failed read attempt, or if memory ends before the terminator
+ *
+ * @return string without the terminator
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_wstring(handle<Mode> const& h, address_t addr, std::size_t max_length = 1 << 12) -> std::wstring
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read NUL-terminated strings in batches.
+ *
+ * Chunks of all strings that are not terminated yet are read with a single
+ * batched read per round, so that reading many short strings takes a few
+ * system calls in total.
+ *
+ * @param[in] h          handle
+ * @param[in] addrs      remote virtual memory addresses of the first characters
+ * @param[in] max_length maximum number of characters, after which a string is truncated
+ *
+ * @throws `std::system_error` on failed read attempt other than an inaccessible address
+ *
+ * @return strings without terminators, or `std::nullopt` for strings whose memory ends before the terminator
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_cstrings(handle<Mode> const& h, std::span<address_t const> addrs, std::size_t max_length = 1 << 12)
+	-> std::vector<std::optional<std::string>>
+	requires handle<Mode>::readable;
+
+/**
+ * @brief Read NUL-terminated wide strings in batches, with characters as large as `wchar_t`.
+ *
+ * @param[in] h          handle
+ * @param[in] addrs      remote virtual memory addresses of the first characters
+ * @param[in] max_length maximum number of characters, after which a string is truncated
+ *
+ * @throws `std::system_error` on failed read attempt other than an inaccessible address
+ *
+ * @return strings without terminators, or `std::nullopt` for strings whose memory ends before the terminator
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto read_wstrings(handle<Mode> const& h, std::span<address_t const> addrs, std::size_t max_length = 1 << 12)
+	-> std::vector<std::optional<std::wstring>>
+	requires handle<Mode>::readable;
+}
+
+#endif
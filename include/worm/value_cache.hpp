@@ -0,0 +1,156 @@
+#ifndef WORM_VALUE_CACHE_HPP
+#define WORM_VALUE_CACHE_HPP
+
+#include "worm.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace worm
+{
+/**
+ * @brief Cache of remote values shared between threads.
+ *
+ * A poller thread refreshes all watched values with batched reads and
+ * publishes each of them through a sequence lock. Any number of threads can
+ * then take consistent snapshots of the values without locks or system calls,
+ * so that the number of reads does not grow with the number of consumers.
+ *
+ * Values that did not change since the previous poll are not republished, so
+ * that consumers keep them in their caches.
+ *
+ * @tparam Mode handle access mode
+ */
+template <handle_mode Mode>
+struct value_cache
+{
+	using handle_type = handle<Mode>;
+
+	/// Published value.
+	struct slot;
+
+	/**
+	 * @brief Watched value.
+	 *
+	 * It is a cheap reference to a slot, which remains valid as long as the cache.
+	 *
+	 * @tparam T type of watched value
+	 */
+	template <typename T>
+	struct entry
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "watched type must be trivially copyable");
+
+		/**
+		 * @brief Get the latest published value.
+		 *
+		 * @return value, or `std::nullopt` if it has not been read yet, or could not be read the last time
+		 */
+		[[nodiscard]]
+		auto read() const noexcept -> std::optional<T>;
+
+		/**
+		 * @brief Get remote virtual memory address of the value.
+		 */
+		[[nodiscard]]
+		auto address() const noexcept -> address_t;
+
+	private:
+		friend value_cache;
+
+		explicit entry(slot const* s) noexcept;
+
+		slot const* slot_;
+	};
+
+	/**
+	 * @brief Construct a cache and start its poller thread.
+	 *
+	 * @param[in] h        handle, which must outlive the cache
+	 * @param[in] interval interval between polls
+	 */
+	explicit value_cache(handle_type const& h, std::chrono::nanoseconds interval = std::chrono::milliseconds(1))
+		requires handle_type::readable;
+
+	value_cache(value_cache const&)                    = delete;
+	auto operator=(value_cache const&) -> value_cache& = delete;
+
+	/**
+	 * @brief Destruct a cache.
+	 *
+	 * Stop the poller thread. Entries must not be used afterwards.
+	 */
+	~value_cache();
+
+	/**
+	 * @brief Watch a value.
+	 *
+	 * It is first read by the next poll.
+	 *
+	 * @tparam T type of watched value
+	 *
+	 * @param[in] addr remote virtual memory address of the value
+	 */
+	template <typename T>
+	[[nodiscard]]
+	auto watch(address_t addr) -> entry<T>;
+
+	/**
+	 * @brief Poll all watched values right away.
+	 *
+	 * @throws `std::system_error` on failed read attempt other than an inaccessible address
+	 */
+	auto refresh() -> void;
+
+	/**
+	 * @brief Get number of completed polls.
+	 */
+	[[nodiscard]]
+	auto epoch() const noexcept -> std::uint64_t;
+
+private:
+	/**
+	 * @brief Add a slot.
+	 *
+	 * @param[in] addr remote virtual memory address
+	 * @param[in] size number of bytes
+	 */
+	[[nodiscard]]
+	auto add(address_t addr, std::size_t size) -> slot const*;
+
+	/**
+	 * @brief Take a consistent snapshot of a slot.
+	 *
+	 * @param[in]  s   slot
+	 * @param[out] dst buffer of at least the size of the slot
+	 *
+	 * @return whether or not the value is valid
+	 */
+	static auto load(slot const& s, void* dst) noexcept -> bool;
+
+	/**
+	 * @brief Get remote virtual memory address of a slot.
+	 *
+	 * @param[in] s slot
+	 */
+	[[nodiscard]]
+	static auto address(slot const& s) noexcept -> address_t;
+
+	/**
+	 * @brief Internal state of a cache.
+	 *
+	 * It is shared with the poller thread.
+	 */
+	struct state;
+
+	std::unique_ptr<state> state_;
+};
+}
+
+#include "value_cache.inl"
+
+#endif
@@ -0,0 +1,39 @@
+#include <array>
+#include <bit>
+
+namespace worm
+{
+template <handle_mode Mode>
+template <typename T>
+value_cache<Mode>::entry<T>::entry(slot const* s) noexcept
+	: slot_{s}
+{}
+
+template <handle_mode Mode>
+template <typename T>
+auto value_cache<Mode>::entry<T>::read() const noexcept -> std::optional<T>
+{
+	std::array<unsigned char, sizeof(T)> snapshot;
+
+	if (!load(*slot_, snapshot.data()))
+	{
+		return std::nullopt;
+	}
+
+	return std::bit_cast<std::remove_const_t<T>>(snapshot);
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto value_cache<Mode>::entry<T>::address() const noexcept -> address_t
+{
+	return value_cache::address(*slot_);
+}
+
+template <handle_mode Mode>
+template <typename T>
+auto value_cache<Mode>::watch(address_t addr) -> entry<T>
+{
+	return entry<T>(add(addr, sizeof(T)));
+}
+}
@@ -1,9 +1,13 @@
 #ifndef WORM_HPP
 #define WORM_HPP
 
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -15,6 +19,50 @@ using address_t = std::uintptr_t;
 /// Process ID type.
 using pid_t = std::size_t;
 
+/// Contiguous range of addresses.
+using address_range = std::ranges::iota_view<address_t, address_t>;
+
+struct module_address;
+struct module_table;
+
+/// Memory permissions.
+enum struct memory_permission
+{
+	/// No access.
+	none = 0,
+
+	/// Read access.
+	read = 1 << 0,
+
+	/// Write access.
+	write = 1 << 1,
+
+	/// Execute access.
+	execute = 1 << 2,
+};
+
+/**
+ * @brief Conjunction of two memory permissions.
+ *
+ * @param[in] lhs left-hand side parameter
+ * @param[in] rhs right-hand side parameter
+ *
+ * @relatesalso worm::memory_permission
+ */
+[[nodiscard]]
+constexpr auto operator&(memory_permission lhs, memory_permission rhs) noexcept -> memory_permission;
+
+/**
+ * @brief Disjunction of two memory permissions.
+ *
+ * @param[in] lhs left-hand side parameter
+ * @param[in] rhs right-hand side parameter
+ *
+ * @relatesalso worm::memory_permission
+ */
+[[nodiscard]]
+constexpr auto operator|(memory_permission lhs, memory_permission rhs) noexcept -> memory_permission;
+
 /// Memory region.
 struct memory_region
 {
@@ -22,7 +70,99 @@ struct memory_region
 	std::string name;
 
 	/// Address space range.
-	std::ranges::iota_view<address_t, address_t> range;
+	address_range range;
+
+	/// Access permissions.
+	memory_permission permissions;
+
+	/// Offset of the region in the mapped file, or `0` if the region is not file-backed.
+	std::uint64_t offset = 0;
+
+	/// Device of the mapped file, or `0` if the region is not file-backed.
+	std::uint64_t device = 0;
+
+	/// Inode of the mapped file, or `0` if the region is not file-backed.
+	std::uint64_t inode = 0;
+};
+
+/**
+ * @brief Check which addresses lie in memory regions with required permissions.
+ *
+ * Regions with the permissions are merged into a sorted index once, which
+ * every address is then located in with a branchless binary search, so that
+ * checking an address costs nanoseconds rather than a failed read.
+ *
+ * @param[in] regions  memory regions of the process
+ * @param[in] addrs    addresses to check
+ * @param[in] required permissions that a region must have
+ *
+ * @return bitmap of valid addresses, where bit `i % 64` of word `i / 64` corresponds to the address at index `i`
+ */
+[[nodiscard]]
+auto validate_pointers(std::vector<memory_region> const& regions, std::span<address_t const> addrs, memory_permission required = memory_permission::read)
+	-> std::vector<std::uint64_t>;
+
+/// Thread stack.
+struct thread_stack
+{
+	/// Thread ID.
+	pid_t tid;
+
+	/// Address space range of the whole stack, or an empty range if the stack could not be located.
+	address_range range;
+
+	/// Address space range of the live part of the stack, from the stack pointer to the top of the stack.
+	address_range live;
+
+	/// Stack pointer, or `0` if it is unknown.
+	address_t stack_pointer;
+};
+
+/// Transfer of bytes between a local buffer and remote virtual memory.
+struct memory_transfer
+{
+	/// Remote virtual memory address.
+	address_t address;
+
+	/// Local buffer.
+	void* buffer;
+
+	/// Number of bytes to transfer.
+	std::size_t size;
+
+	/// Number of bytes transferred, set by the transfer.
+	std::size_t transferred = 0;
+};
+
+/**
+ * @brief Options of waiting for remote values.
+ *
+ * Values are polled in a tight loop right after they change, since changes
+ * tend to come in bursts. Once they stay unchanged, the interval between
+ * polls doubles up to the longest one.
+ */
+struct wait_options
+{
+	/// Duration of tight polling after a change.
+	std::chrono::nanoseconds spin = std::chrono::microseconds(100);
+
+	/// Shortest interval between polls after spinning.
+	std::chrono::nanoseconds min_interval = std::chrono::microseconds(10);
+
+	/// Longest interval between polls.
+	std::chrono::nanoseconds max_interval = std::chrono::milliseconds(1);
+
+	/**
+	 * @brief Whether or not to skip reads of pages that were not written since the previous read.
+	 *
+	 * Writes are detected with soft-dirty bits of the pages on Linux, which
+	 * are cleared for the whole process, so that it interferes with other
+	 * users of the bits, such as a recorder. Bits are only cleared once
+	 * polling slowed down after the spin phase, and at most once per shortest
+	 * interval. Values are still read at least every longest interval, and
+	 * always if the bits are not accessible.
+	 */
+	bool soft_dirty = false;
 };
 
 /// Handle mode.
@@ -98,6 +238,18 @@ struct handle
 	template <typename T>
 	struct bound;
 
+	/**
+	 * @brief Pointer to a value in virtual memory.
+	 *
+	 * It supports pointer arithmetic and caches the pointed value on dereference.
+	 *
+	 * @tparam T type of pointed value
+	 *
+	 * @note Defined in `worm/remote_ptr.hpp`.
+	 */
+	template <typename T>
+	struct remote_ptr;
+
 	/**
 	 * @brief Construct a handle.
 	 *
@@ -131,6 +283,43 @@ struct handle
 	auto regions() const -> std::vector<memory_region>
 		requires readable;
 
+	/**
+	 * @brief Check which addresses lie in current memory regions with required permissions.
+	 *
+	 * Regions are enumerated once per call, so that many addresses should be
+	 * checked at once. Pass regions to `worm::validate_pointers` to reuse them
+	 * across calls.
+	 *
+	 * @param[in] addrs    addresses to check
+	 * @param[in] required permissions that a region must have
+	 *
+	 * @throws `std::system_error` if could not enumerate memory regions
+	 *
+	 * @return bitmap of valid addresses, where bit `i % 64` of word `i / 64` corresponds to the address at index `i`
+	 */
+	[[nodiscard]]
+	auto validate_pointers(std::span<address_t const> addrs, memory_permission required = memory_permission::read) const -> std::vector<std::uint64_t>
+		requires readable;
+
+	/**
+	 * @brief Locate stacks of the process' threads.
+	 *
+	 * On POSIX, stack pointers are taken from `/proc/<pid>/task/<tid>/stat`
+	 * (`kstkesp`), or from `/proc/<pid>/task/<tid>/syscall` for threads that
+	 * are blocked. On Windows, stack pointers are taken from thread contexts.
+	 *
+	 * The live part of a stack includes the red zone below the stack pointer.
+	 *
+	 * @param[in] interrupt whether to briefly interrupt threads whose stack
+	 *                      pointer is unknown otherwise (using `ptrace` on
+	 *                      POSIX, or by suspending them on Windows)
+	 *
+	 * @throws `std::system_error` if could not enumerate threads or memory regions
+	 */
+	[[nodiscard]]
+	auto thread_stacks(bool interrupt = false) const -> std::vector<thread_stack>
+		requires readable;
+
 	/**
 	 * @brief Read bytes from virtual memory into a buffer.
 	 *
@@ -155,6 +344,58 @@ struct handle
 	auto write_bytes(address_t dst, void const* src, std::size_t size) const -> std::size_t
 		requires writable;
 
+	/**
+	 * @brief Read bytes from virtual memory into buffers in batches.
+	 *
+	 * Transfers are batched into as few system calls as possible, so that
+	 * reading many small values costs about as much as reading one. A transfer
+	 * that fails does not prevent the following ones.
+	 *
+	 * @param[in,out] transfers transfers, of which the number of transferred bytes is set
+	 *
+	 * @throws `std::system_error` on failed read attempt other than an inaccessible address
+	 *
+	 * @return total number of bytes read
+	 */
+	auto read_bytes(std::span<memory_transfer> transfers) const -> std::size_t
+		requires readable;
+
+	/**
+	 * @brief Write bytes from buffers to virtual memory in batches.
+	 *
+	 * @param[in,out] transfers transfers, of which the number of transferred bytes is set
+	 *
+	 * @throws `std::system_error` on failed write attempt other than an inaccessible address
+	 *
+	 * @return total number of bytes written
+	 */
+	auto write_bytes(std::span<memory_transfer> transfers) const -> std::size_t
+		requires writable;
+
+	/**
+	 * @brief Wait until a predicate over remote values holds.
+	 *
+	 * All transfers are read with a single batched read on every poll, as
+	 * described by the options.
+	 *
+	 * @param[in,out] transfers transfers that are read on every poll
+	 * @param[in]     pred      predicate over buffers of the transfers, evaluated after the first poll and after every poll that changed them
+	 * @param[in]     timeout   longest duration to wait for
+	 * @param[in]     options   polling options
+	 *
+	 * @throws `std::invalid_argument` if the shortest polling interval is longer than the longest one
+	 * @throws `std::system_error` on failed read attempt other than an inaccessible address
+	 *
+	 * @return whether or not the predicate held before the timeout
+	 */
+	auto wait_until(
+		std::span<memory_transfer> transfers,
+		std::function<bool()> const& pred,
+		std::chrono::nanoseconds timeout,
+		wait_options const& options = {}
+	) const -> bool
+		requires readable;
+
 	/**
 	 * @brief Read value from virtual memory.
 	 *
@@ -194,6 +435,35 @@ struct handle
 	[[nodiscard]]
 	auto bind(address_t addr) const& noexcept -> bound<T>;
 
+	/**
+	 * @brief Bind value to a module-relative address.
+	 *
+	 * @tparam T type of bound value
+	 *
+	 * @param[in] modules module table of the process
+	 * @param[in] addr    module-relative address that holds bound value
+	 *
+	 * @throws `std::out_of_range` if the module is not loaded
+	 *
+	 * @note Defined in `worm/module.hpp`.
+	 */
+	template <typename T>
+	[[nodiscard]]
+	auto bind(module_table const& modules, module_address const& addr) const& -> bound<T>;
+
+	/**
+	 * @brief Point to a value at a virtual address.
+	 *
+	 * @tparam T type of pointed value
+	 *
+	 * @param[in] addr remote virtual memory address that holds pointed value
+	 *
+	 * @note Defined in `worm/remote_ptr.hpp`.
+	 */
+	template <typename T>
+	[[nodiscard]]
+	auto ptr(address_t addr) const& noexcept -> remote_ptr<T>;
+
 private:
 	/**
 	 * @brief Internal representation of a system handle.
@@ -246,6 +516,25 @@ struct handle<Mode>::bound
 	auto write(value_type const& value) const -> std::size_t
 		requires writable;
 
+	/**
+	 * @brief Wait until a predicate over the bound value holds.
+	 *
+	 * @tparam Predicate type of predicate
+	 *
+	 * @param[in] pred    predicate taking the value
+	 * @param[in] timeout longest duration to wait for
+	 * @param[in] options polling options
+	 *
+	 * @throws `std::invalid_argument` if the shortest polling interval is longer than the longest one
+	 * @throws `std::system_error` on failed read attempt
+	 *
+	 * @return value that satisfied the predicate, or `std::nullopt` on timeout
+	 */
+	template <typename Predicate>
+	[[nodiscard]]
+	auto wait_until(Predicate pred, std::chrono::nanoseconds timeout, wait_options const& options = {}) const -> std::optional<value_type>
+		requires readable;
+
 private:
 	handle_type const& h_;
 	address_t const    addr_;
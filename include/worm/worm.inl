@@ -1,3 +1,6 @@
+#include <system_error>
+#include <utility>
+
 namespace worm
 {
 constexpr auto operator&(handle_mode lhs, handle_mode rhs) noexcept -> handle_mode
@@ -10,6 +13,16 @@ constexpr auto operator|(handle_mode lhs, handle_mode rhs) noexcept -> handle_mo
 	return static_cast<handle_mode>(static_cast<int>(lhs) | static_cast<int>(rhs));
 }
 
+constexpr auto operator&(memory_permission lhs, memory_permission rhs) noexcept -> memory_permission
+{
+	return static_cast<memory_permission>(static_cast<int>(lhs) & static_cast<int>(rhs));
+}
+
+constexpr auto operator|(memory_permission lhs, memory_permission rhs) noexcept -> memory_permission
+{
+	return static_cast<memory_permission>(static_cast<int>(lhs) | static_cast<int>(rhs));
+}
+
 template <handle_mode Mode>
 template <typename T>
 auto handle<Mode>::read(address_t addr) const -> T
@@ -57,4 +70,37 @@ auto handle<Mode>::bound<T>::write(value_type const& value) const -> std::size_t
 {
 	return h_.write(addr_, value);
 }
+
+template <handle_mode Mode>
+template <typename T>
+template <typename Predicate>
+auto handle<Mode>::bound<T>::wait_until(Predicate pred, std::chrono::nanoseconds timeout, wait_options const& options) const
+	-> std::optional<value_type>
+	requires readable
+{
+	value_type      value;
+	memory_transfer transfer{addr_, &value, sizeof(value)};
+
+	bool const satisfied = h_.wait_until(
+		{&transfer, 1},
+		[&]
+		{
+			if (transfer.transferred != sizeof(value))
+			{
+				throw std::system_error(std::make_error_code(std::errc::bad_address), "failed to read from virtual memory");
+			}
+
+			return static_cast<bool>(std::invoke(pred, std::as_const(value)));
+		},
+		timeout,
+		options
+	);
+
+	if (!satisfied)
+	{
+		return std::nullopt;
+	}
+
+	return value;
+}
 }
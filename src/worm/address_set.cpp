@@ -0,0 +1,622 @@
+#include "worm/address_set.hpp"
+
+#include "simd.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <utility>
+
+namespace worm
+{
+address_set::address_set(std::vector<address_t> addresses)
+	: representation_{set_representation::list}
+	, granularity_{1}
+	, list_{std::move(addresses)}
+{
+	std::ranges::sort(list_);
+	list_.erase(std::ranges::unique(list_).begin(), list_.end());
+
+	size_ = list_.size();
+}
+
+address_set::address_set(std::vector<bitmap_segment> segments, std::size_t granularity)
+	: representation_{set_representation::bitmap}
+	, granularity_{std::max<std::size_t>(granularity, 1)}
+	, segments_{std::move(segments)}
+{
+	std::ranges::sort(segments_, {}, &bitmap_segment::base);
+
+	for (auto const& segment : segments_)
+	{
+		size_ += simd::popcount(segment.bits.data(), segment.bits.size());
+	}
+}
+
+auto address_set::representation() const noexcept -> set_representation
+{
+	return representation_;
+}
+
+auto address_set::granularity() const noexcept -> std::size_t
+{
+	return granularity_;
+}
+
+auto address_set::size() const noexcept -> std::size_t
+{
+	return size_;
+}
+
+auto address_set::empty() const noexcept -> bool
+{
+	return size_ == 0;
+}
+
+auto address_set::contains(address_t addr) const noexcept -> bool
+{
+	if (representation_ == set_representation::list)
+	{
+		return std::ranges::binary_search(list_, addr);
+	}
+
+	auto const it = std::ranges::upper_bound(segments_, addr, {}, &bitmap_segment::base);
+	if (it == segments_.begin())
+	{
+		return false;
+	}
+
+	auto const& segment = *std::prev(it);
+
+	address_t const offset = addr - segment.base;
+	if (offset % granularity_)
+	{
+		return false;
+	}
+
+	std::size_t const bit = offset / granularity_;
+	if (bit >= segment.size || bit / 64 >= segment.bits.size())
+	{
+		return false;
+	}
+
+	return (segment.bits[bit / 64] >> (bit % 64)) & 1;
+}
+
+auto address_set::begin() const noexcept -> iterator
+{
+	return {this, 0};
+}
+
+auto address_set::end() const noexcept -> iterator
+{
+	return {this, representation_ == set_representation::list ? list_.size() : segments_.size()};
+}
+
+auto address_set::to_vector() const -> std::vector<address_t>
+{
+	if (representation_ == set_representation::list)
+	{
+		return list_;
+	}
+
+	std::vector<address_t> addresses;
+	addresses.reserve(size_);
+	std::ranges::copy(*this, std::back_inserter(addresses));
+
+	return addresses;
+}
+
+auto address_set::shift(std::ptrdiff_t offset) const -> address_set
+{
+	address_set shifted = *this;
+
+	auto const delta = static_cast<address_t>(offset);
+
+	if (representation_ == set_representation::list)
+	{
+		for (auto& addr : shifted.list_)
+		{
+			addr += delta;
+		}
+
+		// Addresses that wrapped around now precede the others.
+		auto const wrapped = std::ranges::adjacent_find(shifted.list_, std::ranges::greater{});
+		if (wrapped != shifted.list_.end())
+		{
+			std::ranges::rotate(shifted.list_, std::next(wrapped));
+		}
+	}
+	else
+	{
+		for (auto& segment : shifted.segments_)
+		{
+			segment.base += delta;
+		}
+
+		std::ranges::sort(shifted.segments_, {}, &address_set::bitmap_segment::base);
+	}
+
+	return shifted;
+}
+
+/// Set operations, which need access to the representation of sets.
+struct set_algebra
+{
+	using segment = address_set::bitmap_segment;
+
+	/**
+	 * @brief Construct a list set.
+	 *
+	 * @param[in] addresses strictly ascending addresses
+	 */
+	[[nodiscard]]
+	static auto from_sorted(std::vector<address_t> addresses) -> address_set
+	{
+		address_set set;
+		set.size_ = addresses.size();
+		set.list_ = std::move(addresses);
+
+		return set;
+	}
+
+	/**
+	 * @brief Construct a bitmap set, dropping empty segments.
+	 *
+	 * @param[in] segments    sorted non-overlapping segments
+	 * @param[in] granularity number of bytes per bit
+	 */
+	[[nodiscard]]
+	static auto from_segments(std::vector<segment> segments, std::size_t granularity) -> address_set
+	{
+		address_set set;
+		set.representation_ = set_representation::bitmap;
+		set.granularity_    = granularity;
+
+		for (auto& s : segments)
+		{
+			std::size_t const count = simd::popcount(s.bits.data(), s.bits.size());
+			if (count)
+			{
+				set.size_ += count;
+				set.segments_.push_back(std::move(s));
+			}
+		}
+
+		return set;
+	}
+
+	/**
+	 * @brief Get address past the last granule of a segment.
+	 */
+	[[nodiscard]]
+	static auto end(segment const& s, std::size_t granularity) noexcept -> address_t
+	{
+		return s.base + s.size * granularity;
+	}
+
+	/**
+	 * @brief Get number of valid bits of a segment.
+	 */
+	[[nodiscard]]
+	static auto bit_count(segment const& s) noexcept -> std::size_t
+	{
+		return std::min(s.size, s.bits.size() * 64);
+	}
+
+	/**
+	 * @brief Find the bit of an address in segments.
+	 *
+	 * @return word and mask of the bit, or `std::nullopt` if the address is not on any granule
+	 */
+	[[nodiscard]]
+	static auto locate(std::vector<segment>& segments, std::size_t granularity, address_t addr) noexcept
+		-> std::optional<std::pair<std::uint64_t*, std::uint64_t>>
+	{
+		auto const it = std::ranges::upper_bound(segments, addr, {}, &segment::base);
+		if (it == segments.begin())
+		{
+			return std::nullopt;
+		}
+
+		auto& s = *std::prev(it);
+
+		address_t const offset = addr - s.base;
+		if (offset % granularity || offset / granularity >= bit_count(s))
+		{
+			return std::nullopt;
+		}
+
+		std::size_t const bit = offset / granularity;
+		return std::pair{&s.bits[bit / 64], std::uint64_t{1} << (bit % 64)};
+	}
+
+	/**
+	 * @brief Combine list sets with a kernel.
+	 *
+	 * @param[in] lhs      left-hand side addresses
+	 * @param[in] rhs      right-hand side addresses
+	 * @param[in] capacity maximum number of resulting addresses
+	 * @param[in] kernel   kernel
+	 */
+	template <typename Kernel>
+	[[nodiscard]]
+	static auto merge(std::span<address_t const> lhs, std::span<address_t const> rhs, std::size_t capacity, Kernel kernel) -> address_set
+	{
+		std::vector<address_t> out(capacity);
+		out.resize(kernel(lhs, rhs, out.data()));
+
+		return from_sorted(std::move(out));
+	}
+
+	/**
+	 * @brief Keep addresses of a set depending on whether another set contains them.
+	 *
+	 * @param[in] source set to filter
+	 * @param[in] other  set to test membership in
+	 * @param[in] keep   whether to keep members or non-members
+	 */
+	[[nodiscard]]
+	static auto filter(address_set const& source, address_set const& other, bool keep) -> address_set
+	{
+		std::vector<address_t> out;
+		for (auto const addr : source)
+		{
+			if (other.contains(addr) == keep)
+			{
+				out.push_back(addr);
+			}
+		}
+
+		return from_sorted(std::move(out));
+	}
+
+	/**
+	 * @brief Call a function for each pair of overlapping segments whose granules coincide.
+	 *
+	 * @param[in] lhs         left-hand side segments
+	 * @param[in] rhs         right-hand side segments
+	 * @param[in] granularity number of bytes per bit of both
+	 * @param[in] f           function taking index of the left-hand side segment,
+	 *                        first bit of the overlap in it, right-hand side segment,
+	 *                        first bit of the overlap in it, and number of overlapping bits
+	 */
+	template <typename F>
+	static auto for_each_overlap(std::vector<segment> const& lhs, std::vector<segment> const& rhs, std::size_t granularity, F f) -> void
+	{
+		std::size_t j = 0;
+
+		for (std::size_t i = 0; i < lhs.size(); ++i)
+		{
+			auto const&     l     = lhs[i];
+			address_t const l_end = end(l, granularity);
+
+			while (j < rhs.size() && end(rhs[j], granularity) <= l.base)
+			{
+				++j;
+			}
+
+			for (std::size_t k = j; k < rhs.size() && rhs[k].base < l_end; ++k)
+			{
+				auto const& r = rhs[k];
+				if (r.base % granularity != l.base % granularity)
+				{
+					continue;
+				}
+
+				address_t const first = std::max(l.base, r.base);
+				address_t const last  = std::min(l_end, end(r, granularity));
+
+				f(i, (first - l.base) / granularity, r, (first - r.base) / granularity, (last - first) / granularity);
+			}
+		}
+	}
+
+	/**
+	 * @brief Intersect bitmap sets of the same granularity.
+	 */
+	[[nodiscard]]
+	static auto intersect_bitmaps(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		std::size_t const granularity = lhs.granularity_;
+
+		std::vector<segment> out;
+		out.reserve(lhs.segments_.size());
+
+		for (auto const& s : lhs.segments_)
+		{
+			out.push_back({s.base, s.size, std::vector<std::uint64_t>((s.size + 63) / 64)});
+		}
+
+		std::vector<std::uint64_t> lhs_bits;
+		std::vector<std::uint64_t> rhs_bits;
+
+		for_each_overlap(
+			lhs.segments_,
+			rhs.segments_,
+			granularity,
+			[&](std::size_t i, std::size_t lhs_first, segment const& r, std::size_t rhs_first, std::size_t count)
+			{
+				std::size_t const words = (count + 63) / 64;
+
+				lhs_bits.resize(words);
+				rhs_bits.resize(words);
+
+				simd::extract_bits(lhs.segments_[i].bits, lhs_first, count, lhs_bits.data());
+				simd::extract_bits(r.bits, rhs_first, count, rhs_bits.data());
+				simd::and_words(lhs_bits.data(), rhs_bits.data(), words);
+				simd::deposit_bits(out[i].bits, lhs_first, lhs_bits.data(), count);
+			}
+		);
+
+		return from_segments(std::move(out), granularity);
+	}
+
+	/**
+	 * @brief Subtract a bitmap set from another one of the same granularity.
+	 */
+	[[nodiscard]]
+	static auto subtract_bitmaps(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		std::size_t const granularity = lhs.granularity_;
+
+		// Bits to clear in each segment of the left-hand side, allocated on first overlap.
+		std::vector<std::vector<std::uint64_t>> masks(lhs.segments_.size());
+		std::vector<std::uint64_t>              rhs_bits;
+
+		for_each_overlap(
+			lhs.segments_,
+			rhs.segments_,
+			granularity,
+			[&](std::size_t i, std::size_t lhs_first, segment const& r, std::size_t rhs_first, std::size_t count)
+			{
+				if (masks[i].empty())
+				{
+					masks[i].resize(lhs.segments_[i].bits.size());
+				}
+
+				rhs_bits.resize((count + 63) / 64);
+
+				simd::extract_bits(r.bits, rhs_first, count, rhs_bits.data());
+				simd::deposit_bits(masks[i], lhs_first, rhs_bits.data(), count);
+			}
+		);
+
+		std::vector<segment> out = lhs.segments_;
+
+		for (std::size_t i = 0; i < out.size(); ++i)
+		{
+			if (!masks[i].empty())
+			{
+				simd::andnot_words(out[i].bits.data(), masks[i].data(), out[i].bits.size());
+			}
+		}
+
+		return from_segments(std::move(out), granularity);
+	}
+
+	/**
+	 * @brief Unite bitmap sets of the same granularity.
+	 *
+	 * @return united set, or `std::nullopt` if granules of the sets overlap without coinciding
+	 */
+	[[nodiscard]]
+	static auto unite_bitmaps(address_set const& lhs, address_set const& rhs) -> std::optional<address_set>
+	{
+		std::size_t const granularity = lhs.granularity_;
+
+		std::vector<segment const*> all;
+		all.reserve(lhs.segments_.size() + rhs.segments_.size());
+
+		std::ranges::merge(
+			lhs.segments_ | std::views::transform([](auto const& s) { return &s; }),
+			rhs.segments_ | std::views::transform([](auto const& s) { return &s; }),
+			std::back_inserter(all),
+			{},
+			&segment::base,
+			&segment::base
+		);
+
+		std::vector<segment> out;
+
+		for (std::size_t i = 0; i < all.size();)
+		{
+			address_t const base = all[i]->base;
+			address_t       last = end(*all[i], granularity);
+
+			std::size_t k = i + 1;
+			for (; k < all.size() && all[k]->base < last; ++k)
+			{
+				if (all[k]->base % granularity != base % granularity)
+				{
+					return std::nullopt;
+				}
+
+				last = std::max(last, end(*all[k], granularity));
+			}
+
+			std::size_t const size = (last - base) / granularity;
+
+			segment merged{base, size, std::vector<std::uint64_t>((size + 63) / 64)};
+
+			for (; i < k; ++i)
+			{
+				simd::deposit_bits(merged.bits, (all[i]->base - base) / granularity, all[i]->bits.data(), bit_count(*all[i]));
+			}
+
+			out.push_back(std::move(merged));
+		}
+
+		return from_segments(std::move(out), granularity);
+	}
+
+	/**
+	 * @brief Unite sets as lists.
+	 */
+	[[nodiscard]]
+	static auto unite_lists(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		auto const l = lhs.to_vector();
+		auto const r = rhs.to_vector();
+
+		return merge(l, r, l.size() + r.size(), simd::unite);
+	}
+
+	/**
+	 * @brief Add or remove addresses of a set to or from a copy of a bitmap set.
+	 *
+	 * @param[in] bitmap bitmap set
+	 * @param[in] other  set of addresses to add or remove
+	 * @param[in] add    whether to add or remove addresses
+	 *
+	 * @return updated set, or `std::nullopt` if an added address is not on any granule
+	 */
+	[[nodiscard]]
+	static auto update_bitmap(address_set const& bitmap, address_set const& other, bool add) -> std::optional<address_set>
+	{
+		std::vector<segment> out = bitmap.segments_;
+
+		for (auto const addr : other)
+		{
+			auto const bit = locate(out, bitmap.granularity_, addr);
+			if (!bit)
+			{
+				if (add)
+				{
+					return std::nullopt;
+				}
+
+				continue;
+			}
+
+			if (add)
+			{
+				*bit->first |= bit->second;
+			}
+			else
+			{
+				*bit->first &= ~bit->second;
+			}
+		}
+
+		return from_segments(std::move(out), bitmap.granularity_);
+	}
+
+	[[nodiscard]]
+	static auto unite(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		if (lhs.empty())
+		{
+			return rhs;
+		}
+
+		if (rhs.empty())
+		{
+			return lhs;
+		}
+
+		bool const lhs_bitmap = lhs.representation_ == set_representation::bitmap;
+		bool const rhs_bitmap = rhs.representation_ == set_representation::bitmap;
+
+		if (!lhs_bitmap && !rhs_bitmap)
+		{
+			return merge(lhs.list_, rhs.list_, lhs.size_ + rhs.size_, simd::unite);
+		}
+
+		if (lhs_bitmap && rhs_bitmap && lhs.granularity_ == rhs.granularity_)
+		{
+			if (auto united = unite_bitmaps(lhs, rhs))
+			{
+				return *std::move(united);
+			}
+
+			return unite_lists(lhs, rhs);
+		}
+
+		// Addresses of the smaller set are added to the bitmap of the larger one, if they are on its granules.
+		auto const& bitmap = !rhs_bitmap || (lhs_bitmap && lhs.size_ >= rhs.size_) ? lhs : rhs;
+		auto const& other  = &bitmap == &lhs ? rhs : lhs;
+
+		if (auto updated = update_bitmap(bitmap, other, true))
+		{
+			return *std::move(updated);
+		}
+
+		return unite_lists(lhs, rhs);
+	}
+
+	[[nodiscard]]
+	static auto intersect(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		if (lhs.empty() || rhs.empty())
+		{
+			return {};
+		}
+
+		bool const lhs_bitmap = lhs.representation_ == set_representation::bitmap;
+		bool const rhs_bitmap = rhs.representation_ == set_representation::bitmap;
+
+		if (!lhs_bitmap && !rhs_bitmap)
+		{
+			return merge(lhs.list_, rhs.list_, std::min(lhs.size_, rhs.size_), simd::intersect);
+		}
+
+		if (lhs_bitmap && rhs_bitmap && lhs.granularity_ == rhs.granularity_)
+		{
+			return intersect_bitmaps(lhs, rhs);
+		}
+
+		// Addresses of a list set, or of the smaller set, are looked up in the other one.
+		bool const lhs_source = !lhs_bitmap || (rhs_bitmap && lhs.size_ <= rhs.size_);
+
+		return lhs_source ? filter(lhs, rhs, true) : filter(rhs, lhs, true);
+	}
+
+	[[nodiscard]]
+	static auto subtract(address_set const& lhs, address_set const& rhs) -> address_set
+	{
+		if (lhs.empty() || rhs.empty())
+		{
+			return lhs;
+		}
+
+		bool const lhs_bitmap = lhs.representation_ == set_representation::bitmap;
+		bool const rhs_bitmap = rhs.representation_ == set_representation::bitmap;
+
+		if (!lhs_bitmap)
+		{
+			if (!rhs_bitmap)
+			{
+				return merge(lhs.list_, rhs.list_, lhs.size_, simd::subtract);
+			}
+
+			return filter(lhs, rhs, false);
+		}
+
+		if (rhs_bitmap && lhs.granularity_ == rhs.granularity_)
+		{
+			return subtract_bitmaps(lhs, rhs);
+		}
+
+		return *update_bitmap(lhs, rhs, false);
+	}
+};
+
+auto operator|(address_set const& lhs, address_set const& rhs) -> address_set
+{
+	return set_algebra::unite(lhs, rhs);
+}
+
+auto operator&(address_set const& lhs, address_set const& rhs) -> address_set
+{
+	return set_algebra::intersect(lhs, rhs);
+}
+
+auto operator-(address_set const& lhs, address_set const& rhs) -> address_set
+{
+	return set_algebra::subtract(lhs, rhs);
+}
+}
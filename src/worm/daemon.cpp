@@ -0,0 +1,1179 @@
+#include "platform.hpp"
+#include "probes.hpp"
+
+#include "worm/daemon.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(WORM_POSIX) && defined(__linux__)
+
+#	include <atomic>
+#	include <list>
+#	include <map>
+#	include <mutex>
+#	include <thread>
+
+#	include <sys/mman.h>
+#	include <sys/socket.h>
+#	include <sys/stat.h>
+#	include <sys/un.h>
+#	include <unistd.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+/// Request operation.
+enum struct opcode : std::uint32_t
+{
+	regions = 1,
+	read,
+	read_batch,
+	scan,
+};
+
+/// Header of a request, followed by an inline payload and possibly a memory file.
+struct request_header
+{
+	opcode        op;
+	std::uint32_t flags;
+	std::uint64_t pid;
+	std::uint64_t address;
+	std::uint64_t size;
+	std::uint64_t count;
+	std::uint64_t alignment;
+};
+
+/// Header of a response, followed by an inline payload and possibly a memory file.
+struct response_header
+{
+	/// Error number, or `0` on success.
+	std::int32_t  error;
+	std::uint32_t reserved;
+	std::uint64_t count;
+	std::uint64_t size;
+};
+
+/// Serialized memory region, followed by its name padded to a multiple of eight bytes.
+struct region_record
+{
+	std::uint64_t begin;
+	std::uint64_t end;
+	std::uint64_t offset;
+	std::uint64_t device;
+	std::uint64_t inode;
+	std::uint32_t permissions;
+	std::uint32_t name_size;
+};
+
+/// Request flag to enumerate regions again.
+constexpr std::uint32_t refresh_flag = 1;
+
+/// Maximum number of bytes in an inline payload, above which memory files are used.
+constexpr std::size_t inline_limit = 1 << 12;
+
+/// Maximum number of bytes in a message.
+constexpr std::size_t max_message_size = sizeof(request_header) + 2 * inline_limit;
+
+/// Maximum number of bytes that a request may read.
+constexpr std::size_t max_transfer_size = std::size_t{1} << 30;
+
+/// Shortest interval between sweeps for processes to forget.
+constexpr std::chrono::seconds eviction_interval{1};
+
+/**
+ * @brief Round a size up to a multiple of eight bytes.
+ *
+ * @param[in] size size
+ */
+[[nodiscard]]
+constexpr auto pad(std::size_t size) noexcept -> std::size_t
+{
+	return (size + 7) / 8 * 8;
+}
+
+/// File descriptor that is closed on destruction.
+struct file_descriptor
+{
+	file_descriptor() noexcept = default;
+
+	explicit file_descriptor(int fd) noexcept
+		: fd{fd}
+	{}
+
+	file_descriptor(file_descriptor&& other) noexcept
+		: fd{std::exchange(other.fd, -1)}
+	{}
+
+	auto operator=(file_descriptor&& other) noexcept -> file_descriptor&
+	{
+		std::swap(fd, other.fd);
+		return *this;
+	}
+
+	~file_descriptor()
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+
+	int fd = -1;
+};
+
+/// Memory file mapped into the address space.
+struct memory_file
+{
+	/**
+	 * @brief Create a memory file and map it for writing.
+	 *
+	 * @param[in] size number of bytes
+	 *
+	 * @throws `std::system_error` if could not create or map the file
+	 */
+	[[nodiscard]]
+	static auto create(std::size_t size) -> memory_file
+	{
+		memory_file file;
+		file.file = file_descriptor(memfd_create("worm", MFD_CLOEXEC));
+
+		if (file.file.fd < 0)
+		{
+			throw make_system_error("failed to create memory file");
+		}
+
+		if (ftruncate(file.file.fd, static_cast<off_t>(size)) < 0)
+		{
+			throw make_system_error("failed to resize memory file");
+		}
+
+		file.map(size, PROT_READ | PROT_WRITE);
+
+		return file;
+	}
+
+	/**
+	 * @brief Map a received memory file for reading.
+	 *
+	 * @param[in] fd   file descriptor, which is owned by the file
+	 * @param[in] size number of bytes
+	 *
+	 * @throws `std::system_error` if the file is smaller than the size, or could not be mapped
+	 */
+	[[nodiscard]]
+	static auto open(file_descriptor fd, std::size_t size) -> memory_file
+	{
+		memory_file file;
+		file.file = std::move(fd);
+
+		struct stat status;
+		if (file.file.fd < 0 || fstat(file.file.fd, &status) < 0 || static_cast<std::size_t>(status.st_size) < size)
+		{
+			throw std::system_error(std::make_error_code(std::errc::bad_message), "memory file is missing or too small");
+		}
+
+		file.map(size, PROT_READ);
+
+		return file;
+	}
+
+	memory_file() noexcept = default;
+
+	memory_file(memory_file&& other) noexcept
+		: file{std::move(other.file)}
+		, data{std::exchange(other.data, nullptr)}
+		, size{std::exchange(other.size, 0)}
+	{}
+
+	auto operator=(memory_file&& other) noexcept -> memory_file&
+	{
+		std::swap(file, other.file);
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+		return *this;
+	}
+
+	~memory_file()
+	{
+		if (data)
+		{
+			munmap(data, size);
+		}
+	}
+
+	file_descriptor file;
+	unsigned char*  data = nullptr;
+	std::size_t     size = 0;
+
+private:
+	auto map(std::size_t bytes, int protection) -> void
+	{
+		if (!bytes)
+		{
+			return;
+		}
+
+		void* const mapping = mmap(nullptr, bytes, protection, MAP_SHARED, file.fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			throw make_system_error("failed to map memory file");
+		}
+
+		data = static_cast<unsigned char*>(mapping);
+		size = bytes;
+	}
+};
+
+/**
+ * @brief Send a message with an optional file descriptor.
+ *
+ * @param[in] socket  socket
+ * @param[in] header  header
+ * @param[in] payload inline payload
+ * @param[in] fd      file descriptor to send, or `-1`
+ *
+ * @throws `std::system_error` if could not send the message
+ */
+template <typename Header>
+auto send_message(int socket, Header const& header, std::span<unsigned char const> payload, int fd) -> void
+{
+	iovec vectors[] = {
+		{const_cast<Header*>(&header), sizeof(header)},
+		{const_cast<unsigned char*>(payload.data()), payload.size()},
+	};
+
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+	msghdr message{};
+	message.msg_iov    = vectors;
+	message.msg_iovlen = payload.empty() ? 1 : 2;
+
+	if (fd >= 0)
+	{
+		message.msg_control    = control;
+		message.msg_controllen = sizeof(control);
+
+		cmsghdr* const cmsg = CMSG_FIRSTHDR(&message);
+		cmsg->cmsg_level    = SOL_SOCKET;
+		cmsg->cmsg_type     = SCM_RIGHTS;
+		cmsg->cmsg_len      = CMSG_LEN(sizeof(int));
+		std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+	}
+
+	while (sendmsg(socket, &message, MSG_NOSIGNAL) < 0)
+	{
+		if (errno != EINTR)
+		{
+			throw make_system_error("failed to send message");
+		}
+	}
+}
+
+/**
+ * @brief Receive a message with an optional file descriptor.
+ *
+ * @param[in]  socket socket
+ * @param[out] buffer buffer of at least `max_message_size` bytes
+ * @param[out] fd     received file descriptor, if any
+ *
+ * @throws `std::system_error` if could not receive the message
+ *
+ * @return number of received bytes, or `0` if the peer disconnected
+ */
+auto receive_message(int socket, unsigned char* buffer, file_descriptor& fd) -> std::size_t
+{
+	iovec vector{buffer, max_message_size};
+
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+	msghdr message{};
+	message.msg_iov        = &vector;
+	message.msg_iovlen     = 1;
+	message.msg_control    = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received;
+	while ((received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC)) < 0)
+	{
+		if (errno != EINTR)
+		{
+			throw make_system_error("failed to receive message");
+		}
+	}
+
+	for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg))
+	{
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+		{
+			int received_fd;
+			std::memcpy(&received_fd, CMSG_DATA(cmsg), sizeof(int));
+			fd = file_descriptor(received_fd);
+		}
+	}
+
+	if (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+	{
+		throw std::system_error(std::make_error_code(std::errc::message_size), "message is too large");
+	}
+
+	return static_cast<std::size_t>(received);
+}
+
+/**
+ * @brief Make address of a Unix socket.
+ *
+ * @param[in] path socket path
+ *
+ * @throws `std::system_error` if the path is too long
+ */
+[[nodiscard]]
+auto make_address(std::string const& path) -> sockaddr_un
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+
+	if (path.size() >= sizeof(address.sun_path))
+	{
+		throw std::system_error(std::make_error_code(std::errc::filename_too_long), "socket path is too long");
+	}
+
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+	return address;
+}
+
+/**
+ * @brief Serialize memory regions into a memory file.
+ *
+ * @param[in] regions memory regions
+ */
+[[nodiscard]]
+auto serialize_regions(std::vector<memory_region> const& regions) -> memory_file
+{
+	std::size_t size = 0;
+	for (auto const& region : regions)
+	{
+		size += sizeof(region_record) + pad(region.name.size());
+	}
+
+	auto file = memory_file::create(size);
+
+	std::size_t offset = 0;
+	for (auto const& region : regions)
+	{
+		region_record const record{
+			.begin       = region.range.front(),
+			.end         = *region.range.end(),
+			.offset      = region.offset,
+			.device      = region.device,
+			.inode       = region.inode,
+			.permissions = static_cast<std::uint32_t>(region.permissions),
+			.name_size   = static_cast<std::uint32_t>(region.name.size()),
+		};
+
+		std::memcpy(file.data + offset, &record, sizeof(record));
+		std::memcpy(file.data + offset + sizeof(record), region.name.data(), region.name.size());
+
+		offset += sizeof(record) + pad(region.name.size());
+	}
+
+	return file;
+}
+
+/**
+ * @brief Deserialize memory regions from a memory file.
+ *
+ * @param[in] file  memory file
+ * @param[in] count number of regions
+ *
+ * @throws `std::system_error` if the file is malformed
+ */
+[[nodiscard]]
+auto deserialize_regions(memory_file const& file, std::size_t count) -> std::vector<memory_region>
+{
+	std::vector<memory_region> regions;
+
+	std::size_t offset = 0;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		region_record record;
+		if (file.size - offset < sizeof(record))
+		{
+			throw std::system_error(std::make_error_code(std::errc::bad_message), "malformed region table");
+		}
+
+		std::memcpy(&record, file.data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		if (file.size - offset < record.name_size || record.end < record.begin)
+		{
+			throw std::system_error(std::make_error_code(std::errc::bad_message), "malformed region table");
+		}
+
+		regions.push_back({
+			.name        = std::string(reinterpret_cast<char const*>(file.data + offset), record.name_size),
+			.range       = address_range(record.begin, record.end),
+			.permissions = static_cast<memory_permission>(record.permissions),
+			.offset      = record.offset,
+			.device      = record.device,
+			.inode       = record.inode,
+		});
+
+		offset += std::min(pad(record.name_size), file.size - offset);
+	}
+
+	return regions;
+}
+
+/**
+ * @brief Check whether a process exists.
+ *
+ * @param[in] pid process id
+ */
+[[nodiscard]]
+auto process_exists(pid_t pid) -> bool
+{
+	return pid > 0 && access(("/proc/" + std::to_string(pid)).c_str(), F_OK) == 0;
+}
+
+/// Process served by a daemon.
+struct target
+{
+	explicit target(pid_t pid)
+		: h{pid}
+	{}
+
+	ihandle h;
+
+	std::mutex                            mutex;
+	std::vector<memory_region>            regions;
+	std::chrono::steady_clock::time_point regions_time;
+	bool                                  regions_valid = false;
+
+	/// Time of the latest request, guarded by the daemon mutex.
+	std::chrono::steady_clock::time_point last_used;
+};
+#endif
+}
+
+#if defined(WORM_POSIX) && defined(__linux__)
+struct daemon_server::state
+{
+	std::string                              path;
+	std::chrono::milliseconds                region_ttl;
+	std::chrono::milliseconds                target_ttl;
+	file_descriptor                          listener;
+	std::atomic<bool>                        stopping = false;
+	std::mutex                               mutex;
+	std::map<pid_t, std::shared_ptr<target>> targets;
+	std::chrono::steady_clock::time_point    last_eviction;
+
+	/// Connected client.
+	struct connection
+	{
+		file_descriptor   socket;
+		std::thread       thread;
+		std::atomic<bool> done = false;
+	};
+
+	std::list<connection> connections;
+
+	/**
+	 * @brief Get a served process, attaching to it if needed.
+	 *
+	 * @param[in] pid process id
+	 *
+	 * @throws `std::system_error` if the process does not exist
+	 */
+	auto find_target(pid_t pid) -> std::shared_ptr<target>
+	{
+		// Handles are created for any pid, so that ones of processes that do not exist would be kept until evicted.
+		if (!process_exists(pid))
+		{
+			throw std::system_error(std::make_error_code(std::errc::no_such_process), "process does not exist");
+		}
+
+		auto const now = std::chrono::steady_clock::now();
+
+		std::scoped_lock lock(mutex);
+
+		evict_targets(now);
+
+		auto& t = targets[pid];
+		if (!t)
+		{
+			try
+			{
+				t = std::make_shared<target>(pid);
+			}
+			catch (...)
+			{
+				targets.erase(pid);
+				throw;
+			}
+		}
+
+		t->last_used = now;
+
+		return t;
+	}
+
+	/**
+	 * @brief Forget served processes that exited or were not asked for in a while.
+	 *
+	 * Requests in flight keep their processes alive, so that only the cache entries are dropped.
+	 * It must be called with the mutex locked.
+	 *
+	 * @param[in] now current time
+	 */
+	auto evict_targets(std::chrono::steady_clock::time_point now) -> void
+	{
+		if (now - last_eviction < eviction_interval)
+		{
+			return;
+		}
+
+		last_eviction = now;
+
+		std::erase_if(
+			targets,
+			[&](auto const& entry) { return now - entry.second->last_used > target_ttl || !process_exists(entry.first); }
+		);
+	}
+
+	/**
+	 * @brief Forget a served process, e.g. after it exited.
+	 *
+	 * @param[in] pid process id
+	 */
+	auto forget_target(pid_t pid) -> void
+	{
+		std::scoped_lock lock(mutex);
+		targets.erase(pid);
+	}
+
+	/**
+	 * @brief Get regions of a served process, from the cache if they are fresh.
+	 *
+	 * @param[in] t       served process
+	 * @param[in] refresh whether to enumerate regions regardless of the cache
+	 */
+	auto target_regions(target& t, bool refresh) -> std::vector<memory_region>
+	{
+		std::scoped_lock lock(t.mutex);
+
+		auto const now = std::chrono::steady_clock::now();
+
+		if (refresh || !t.regions_valid || now - t.regions_time > region_ttl)
+		{
+			try
+			{
+				t.regions = t.h.regions();
+			}
+			catch (std::system_error const&)
+			{
+				forget_target(t.h.pid());
+				throw;
+			}
+
+			t.regions_time  = now;
+			t.regions_valid = true;
+		}
+
+		return t.regions;
+	}
+
+	/**
+	 * @brief Serve a request.
+	 *
+	 * @param[in] socket  client socket
+	 * @param[in] request request header
+	 * @param[in] payload inline payload
+	 * @param[in] file    received file descriptor
+	 */
+	auto serve(int socket, request_header const& request, std::span<unsigned char const> payload, file_descriptor file) -> void
+	{
+		response_header response{};
+
+		auto const t = find_target(request.pid);
+
+		switch (request.op)
+		{
+		case opcode::regions:
+		{
+			auto const regions = target_regions(*t, request.flags & refresh_flag);
+			auto const file    = serialize_regions(regions);
+
+			response.count = regions.size();
+			response.size  = file.size;
+
+			send_message(socket, response, {}, file.file.fd);
+			return;
+		}
+
+		case opcode::read:
+		{
+			if (request.size <= inline_limit)
+			{
+				unsigned char buffer[inline_limit];
+
+				response.count = t->h.read_bytes(request.address, buffer, request.size);
+				response.size  = response.count;
+
+				send_message(socket, response, {buffer, response.count}, -1);
+				return;
+			}
+
+			if (request.size > max_transfer_size)
+			{
+				throw std::system_error(std::make_error_code(std::errc::value_too_large), "read is too large");
+			}
+
+			auto const out = memory_file::create(request.size);
+
+			response.count = t->h.read_bytes(request.address, out.data, request.size);
+			response.size  = out.size;
+
+			send_message(socket, response, {}, out.file.fd);
+			return;
+		}
+
+		case opcode::read_batch:
+		{
+			// Addresses and sizes of transfers, followed by transferred sizes and bytes in the response.
+			std::size_t in_size;
+			if (__builtin_mul_overflow(request.count, 2 * sizeof(std::uint64_t), &in_size) || in_size > max_transfer_size)
+			{
+				throw std::system_error(std::make_error_code(std::errc::value_too_large), "batch is too large");
+			}
+
+			// Opening fails unless the received file holds all entries.
+			auto const in = memory_file::open(std::move(file), in_size);
+
+			std::vector<memory_transfer> transfers(request.count);
+
+			std::size_t const header_size = transfers.size() * sizeof(std::uint64_t);
+
+			std::size_t total = header_size;
+			for (std::size_t i = 0; i < transfers.size(); ++i)
+			{
+				std::uint64_t entry[2];
+				std::memcpy(entry, in.data + i * sizeof(entry), sizeof(entry));
+
+				transfers[i] = {entry[0], nullptr, entry[1]};
+
+				if (__builtin_add_overflow(total, entry[1], &total) || total > max_transfer_size)
+				{
+					throw std::system_error(std::make_error_code(std::errc::value_too_large), "batch is too large");
+				}
+			}
+
+			auto const out = memory_file::create(total);
+
+			std::size_t offset = header_size;
+			for (auto& transfer : transfers)
+			{
+				transfer.buffer = out.data + offset;
+				offset += transfer.size;
+			}
+
+			response.count = t->h.read_bytes(transfers);
+			response.size  = out.size;
+
+			for (std::size_t i = 0; i < transfers.size(); ++i)
+			{
+				std::uint64_t const transferred = transfers[i].transferred;
+				std::memcpy(out.data + i * sizeof(std::uint64_t), &transferred, sizeof(transferred));
+			}
+
+			send_message(socket, response, {}, out.file.fd);
+			return;
+		}
+
+		case opcode::scan:
+		{
+			std::size_t const size = request.size;
+			if (size > inline_limit || payload.size() < 2 * size)
+			{
+				throw std::system_error(std::make_error_code(std::errc::bad_message), "malformed pattern");
+			}
+
+			pattern const p{
+				{payload.begin(), payload.begin() + static_cast<std::ptrdiff_t>(size)},
+				{payload.begin() + static_cast<std::ptrdiff_t>(size), payload.begin() + static_cast<std::ptrdiff_t>(2 * size)},
+			};
+
+			// A pattern without a fixed byte matches every address, so that it would build a result as large as the process.
+			if (std::ranges::none_of(p.mask, [](unsigned char m) { return m != 0; }))
+			{
+				throw std::system_error(std::make_error_code(std::errc::invalid_argument), "pattern has no fixed byte");
+			}
+
+			auto const matches = worm::scan(t->h, target_regions(*t, false), p, {.alignment = request.alignment});
+			if (matches.size() > max_transfer_size / sizeof(address_t))
+			{
+				throw std::system_error(std::make_error_code(std::errc::value_too_large), "scan result is too large");
+			}
+
+			auto const out = memory_file::create(matches.size() * sizeof(address_t));
+
+			std::size_t i = 0;
+			for (auto const addr : matches)
+			{
+				std::memcpy(out.data + i++ * sizeof(address_t), &addr, sizeof(address_t));
+			}
+
+			response.count = matches.size();
+			response.size  = out.size;
+
+			send_message(socket, response, {}, out.file.fd);
+			return;
+		}
+		}
+
+		throw std::system_error(std::make_error_code(std::errc::operation_not_supported), "unknown request");
+	}
+
+	/**
+	 * @brief Serve a client until it disconnects.
+	 *
+	 * @param[in] c connection
+	 */
+	auto serve_client(connection& c) -> void
+	{
+		std::vector<unsigned char> buffer(max_message_size);
+
+		try
+		{
+			while (!stopping)
+			{
+				file_descriptor   file;
+				std::size_t const size = receive_message(c.socket.fd, buffer.data(), file);
+
+				if (size < sizeof(request_header))
+				{
+					break;
+				}
+
+				request_header request;
+				std::memcpy(&request, buffer.data(), sizeof(request));
+
+				WORM_PROBE(daemon_request__entry, request.pid, static_cast<std::uint32_t>(request.op), request.size);
+
+				int error = 0;
+
+				try
+				{
+					serve(c.socket.fd, request, {buffer.data() + sizeof(request), size - sizeof(request)}, std::move(file));
+				}
+				catch (std::system_error const& e)
+				{
+					error = e.code().value() ? e.code().value() : EIO;
+				}
+				catch (std::bad_alloc const&)
+				{
+					error = ENOMEM;
+				}
+				catch (std::exception const&)
+				{
+					error = EINVAL;
+				}
+
+				WORM_PROBE(daemon_request__return, request.pid, static_cast<std::uint32_t>(request.op), request.size, error);
+
+				if (error)
+				{
+					send_message(c.socket.fd, response_header{.error = error}, {}, -1);
+				}
+			}
+		}
+		catch (std::exception const&)
+		{}
+
+		c.done = true;
+	}
+};
+#endif
+
+#if defined(WORM_POSIX) && defined(__linux__)
+struct daemon_client::state
+{
+	file_descriptor socket;
+	std::mutex      mutex;
+
+	std::vector<unsigned char> buffer = std::vector<unsigned char>(max_message_size);
+
+	/**
+	 * @brief Send a request and receive its response.
+	 *
+	 * @param[in]  request request header
+	 * @param[in]  payload inline payload
+	 * @param[in]  fd      file descriptor to send, or `-1`
+	 * @param[out] reply   inline payload of the response
+	 * @param[out] file    received memory file, mapped for reading
+	 *
+	 * @throws `std::system_error` on failed request
+	 */
+	auto call(request_header const& request, std::span<unsigned char const> payload, int fd, std::span<unsigned char const>& reply, memory_file& file)
+		-> response_header
+	{
+		send_message(socket.fd, request, payload, fd);
+
+		file_descriptor   received;
+		std::size_t const size = receive_message(socket.fd, buffer.data(), received);
+
+		if (size < sizeof(response_header))
+		{
+			throw std::system_error(std::make_error_code(std::errc::connection_aborted), "daemon disconnected");
+		}
+
+		response_header response;
+		std::memcpy(&response, buffer.data(), sizeof(response));
+
+		if (response.error)
+		{
+			throw std::system_error(response.error, std::system_category(), "daemon request failed");
+		}
+
+		reply = {buffer.data() + sizeof(response), size - sizeof(response)};
+
+		if (received.fd >= 0)
+		{
+			file = memory_file::open(std::move(received), response.size);
+		}
+
+		return response;
+	}
+};
+#else
+struct daemon_server::state
+{
+	std::string path;
+};
+
+struct daemon_client::state
+{};
+#endif
+
+daemon_server::daemon_server(daemon_options const& options)
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	state_ = std::make_unique<state>();
+
+	state_->path       = options.socket_path.empty() ? default_daemon_socket() : options.socket_path;
+	state_->region_ttl = options.region_ttl;
+	state_->target_ttl = options.target_ttl;
+
+	sockaddr_un const address = make_address(state_->path);
+
+	state_->listener = file_descriptor(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+	if (state_->listener.fd < 0)
+	{
+		throw make_system_error("failed to create socket");
+	}
+
+	// A socket file left behind by a daemon that did not exit cleanly would fail binding.
+	unlink(state_->path.c_str());
+
+	if (bind(state_->listener.fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) < 0)
+	{
+		throw make_system_error("failed to bind socket");
+	}
+
+	if (chmod(state_->path.c_str(), options.socket_mode) < 0 || listen(state_->listener.fd, SOMAXCONN) < 0)
+	{
+		auto error = make_system_error("failed to listen on socket");
+		unlink(state_->path.c_str());
+		throw error;
+	}
+#elif defined(WORM_WINDOWS)
+	(void)options;
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "daemons are only supported on Linux");
+#endif
+}
+
+daemon_server::daemon_server(daemon_server&&) noexcept = default;
+
+auto daemon_server::operator=(daemon_server&& other) noexcept -> daemon_server&
+{
+	std::swap(state_, other.state_);
+	return *this;
+}
+
+daemon_server::~daemon_server()
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	if (!state_)
+	{
+		return;
+	}
+
+	stop();
+
+	for (auto& c : state_->connections)
+	{
+		if (c.thread.joinable())
+		{
+			c.thread.join();
+		}
+	}
+
+	unlink(state_->path.c_str());
+#endif
+}
+
+auto daemon_server::socket_path() const noexcept -> std::string const&
+{
+	return state_->path;
+}
+
+auto daemon_server::run() -> void
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	while (!state_->stopping)
+	{
+		int const client = accept4(state_->listener.fd, nullptr, nullptr, SOCK_CLOEXEC);
+		if (client < 0)
+		{
+			if (state_->stopping)
+			{
+				break;
+			}
+
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+
+			throw make_system_error("failed to accept client");
+		}
+
+		std::scoped_lock lock(state_->mutex);
+
+		// Threads of disconnected clients are reaped as new clients arrive.
+		std::erase_if(
+			state_->connections,
+			[](auto& c)
+			{
+				if (!c.done)
+				{
+					return false;
+				}
+
+				c.thread.join();
+				return true;
+			}
+		);
+
+		auto& c  = state_->connections.emplace_back();
+		c.socket = file_descriptor(client);
+		c.thread = std::thread([this, &c] { state_->serve_client(c); });
+	}
+#endif
+}
+
+auto daemon_server::stop() noexcept -> void
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	state_->stopping = true;
+
+	// Shutting sockets down wakes threads blocked on them.
+	shutdown(state_->listener.fd, SHUT_RDWR);
+
+	std::scoped_lock lock(state_->mutex);
+	for (auto& c : state_->connections)
+	{
+		shutdown(c.socket.fd, SHUT_RDWR);
+	}
+#endif
+}
+
+daemon_client::daemon_client(std::string const& socket_path)
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	state_ = std::make_unique<state>();
+
+	sockaddr_un const address = make_address(socket_path);
+
+	state_->socket = file_descriptor(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+	if (state_->socket.fd < 0)
+	{
+		throw make_system_error("failed to create socket");
+	}
+
+	if (connect(state_->socket.fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) < 0)
+	{
+		throw make_system_error("failed to connect to daemon");
+	}
+#elif defined(WORM_WINDOWS)
+	(void)socket_path;
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "daemons are only supported on Linux");
+#endif
+}
+
+daemon_client::daemon_client(daemon_client&&) noexcept = default;
+
+auto daemon_client::operator=(daemon_client&& other) noexcept -> daemon_client&
+{
+	std::swap(state_, other.state_);
+	return *this;
+}
+
+daemon_client::~daemon_client() = default;
+
+auto daemon_client::regions(pid_t pid, bool refresh) const -> std::vector<memory_region>
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	std::scoped_lock lock(state_->mutex);
+
+	std::span<unsigned char const> reply;
+	memory_file                    file;
+
+	auto const response = state_->call({.op = opcode::regions, .flags = refresh ? refresh_flag : 0, .pid = pid}, {}, -1, reply, file);
+
+	return deserialize_regions(file, response.count);
+#else
+	(void)pid;
+	(void)refresh;
+	return {};
+#endif
+}
+
+auto daemon_client::read_bytes(pid_t pid, address_t src, void* dst, std::size_t size) const -> std::size_t
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	std::scoped_lock lock(state_->mutex);
+
+	std::span<unsigned char const> reply;
+	memory_file                    file;
+
+	auto const response = state_->call({.op = opcode::read, .pid = pid, .address = src, .size = size}, {}, -1, reply, file);
+
+	std::size_t const read = std::min<std::size_t>(response.count, file.data ? file.size : reply.size());
+	if (read)
+	{
+		std::memcpy(dst, file.data ? file.data : reply.data(), std::min(read, size));
+	}
+
+	return std::min(read, size);
+#else
+	(void)pid;
+	(void)src;
+	(void)dst;
+	(void)size;
+	return 0;
+#endif
+}
+
+auto daemon_client::read_bytes(pid_t pid, std::span<memory_transfer> transfers) const -> std::size_t
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	if (transfers.empty())
+	{
+		return 0;
+	}
+
+	std::scoped_lock lock(state_->mutex);
+
+	auto const batch = memory_file::create(transfers.size() * 2 * sizeof(std::uint64_t));
+
+	std::size_t total = 0;
+	for (std::size_t i = 0; i < transfers.size(); ++i)
+	{
+		std::uint64_t const entry[2] = {transfers[i].address, transfers[i].size};
+		std::memcpy(batch.data + i * sizeof(entry), entry, sizeof(entry));
+
+		total += transfers[i].size;
+	}
+
+	std::span<unsigned char const> reply;
+	memory_file                    file;
+
+	auto const response = state_->call({.op = opcode::read_batch, .pid = pid, .count = transfers.size()}, {}, batch.file.fd, reply, file);
+
+	std::size_t const header_size = transfers.size() * sizeof(std::uint64_t);
+	if (file.size < header_size + total)
+	{
+		throw std::system_error(std::make_error_code(std::errc::bad_message), "malformed batch response");
+	}
+
+	std::size_t offset = header_size;
+	for (std::size_t i = 0; i < transfers.size(); ++i)
+	{
+		std::uint64_t transferred;
+		std::memcpy(&transferred, file.data + i * sizeof(std::uint64_t), sizeof(transferred));
+
+		transfers[i].transferred = std::min<std::size_t>(transferred, transfers[i].size);
+		if (transfers[i].transferred)
+		{
+			std::memcpy(transfers[i].buffer, file.data + offset, transfers[i].transferred);
+		}
+
+		offset += transfers[i].size;
+	}
+
+	return response.count;
+#else
+	(void)pid;
+	(void)transfers;
+	return 0;
+#endif
+}
+
+auto daemon_client::scan(pid_t pid, pattern const& p, std::size_t alignment) const -> address_set
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	if (p.size() > inline_limit)
+	{
+		throw std::system_error(std::make_error_code(std::errc::message_size), "pattern is too large");
+	}
+
+	std::scoped_lock lock(state_->mutex);
+
+	std::vector<unsigned char> payload(p.bytes);
+	payload.insert(payload.end(), p.mask.begin(), p.mask.end());
+
+	std::span<unsigned char const> reply;
+	memory_file                    file;
+
+	auto const response = state_->call({.op = opcode::scan, .pid = pid, .size = p.size(), .alignment = alignment}, payload, -1, reply, file);
+
+	if (file.size / sizeof(address_t) < response.count)
+	{
+		throw std::system_error(std::make_error_code(std::errc::bad_message), "malformed scan response");
+	}
+
+	std::vector<address_t> addresses(response.count);
+	std::memcpy(addresses.data(), file.data, addresses.size() * sizeof(address_t));
+
+	return address_set(std::move(addresses));
+#else
+	(void)pid;
+	(void)p;
+	(void)alignment;
+	return address_set({});
+#endif
+}
+
+auto default_daemon_socket() -> std::string
+{
+#if defined(WORM_POSIX)
+	if (char const* const runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir)
+	{
+		return std::string(runtime_dir) + "/worm.sock";
+	}
+
+	return "/tmp/worm-" + std::to_string(getuid()) + ".sock";
+#elif defined(WORM_WINDOWS)
+	return {};
+#endif
+}
+}
@@ -0,0 +1,455 @@
+#include "worm/diff.hpp"
+#include "worm/module.hpp"
+#include "worm/region_reader.hpp"
+
+#include "probes.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+namespace worm
+{
+namespace
+{
+/// Readable region attributed to a module.
+struct module_region
+{
+	/// Offset relative to the module base.
+	address_t offset;
+
+	/// Region address.
+	address_t address;
+
+	/// Region size.
+	std::size_t size;
+};
+
+/// Paired chunk of two processes' memory.
+struct diff_chunk
+{
+	/// Module name.
+	std::string_view module;
+
+	/// Offset relative to the module base.
+	address_t offset;
+
+	/// Address in the left-hand side process.
+	address_t lhs_address;
+
+	/// Address in the right-hand side process.
+	address_t rhs_address;
+
+	/// Chunk size.
+	std::size_t size;
+};
+
+/**
+ * @brief Attribute regions with required permissions to modules.
+ *
+ * @param[in] regions  regions sorted by address
+ * @param[in] required required permissions
+ */
+[[nodiscard]]
+auto attribute_regions(std::vector<memory_region> const& regions, memory_permission required = memory_permission::read)
+	-> std::map<std::string, std::vector<module_region>>
+{
+	module_table const modules(regions);
+
+	std::map<std::string, std::vector<module_region>> attributed;
+
+	for (auto const& region : regions)
+	{
+		if ((region.permissions & required) != required || region.range.empty())
+		{
+			continue;
+		}
+
+		if (auto addr = modules.relativize(region.range.front()))
+		{
+			attributed[std::move(addr->module)].push_back({addr->offset, region.range.front(), region.range.size()});
+		}
+	}
+
+	return attributed;
+}
+
+/**
+ * @brief Pair regions of two processes and split them into chunks.
+ *
+ * @param[in] lhs        left-hand side modules
+ * @param[in] rhs        right-hand side modules
+ * @param[in] chunk_size maximum chunk size
+ */
+[[nodiscard]]
+auto pair_regions(
+	std::map<std::string, std::vector<module_region>> const& lhs,
+	std::map<std::string, std::vector<module_region>> const& rhs,
+	std::size_t                                              chunk_size
+) -> std::vector<diff_chunk>
+{
+	std::vector<diff_chunk> chunks;
+
+	for (auto const& [module, lhs_regions] : lhs)
+	{
+		auto const it = rhs.find(module);
+		if (it == rhs.end())
+		{
+			continue;
+		}
+
+		auto const& rhs_regions = it->second;
+
+		for (auto l = lhs_regions.begin(), r = rhs_regions.begin(); l != lhs_regions.end() && r != rhs_regions.end();)
+		{
+			address_t const begin = std::max(l->offset, r->offset);
+			address_t const end   = std::min(l->offset + l->size, r->offset + r->size);
+
+			for (address_t offset = begin; offset < end; offset += chunk_size)
+			{
+				chunks.push_back({
+					module,
+					offset,
+					l->address + (offset - l->offset),
+					r->address + (offset - r->offset),
+					std::min<std::size_t>(chunk_size, end - offset),
+				});
+			}
+
+			if (l->offset + l->size < r->offset + r->size)
+			{
+				++l;
+			}
+			else
+			{
+				++r;
+			}
+		}
+	}
+
+	return chunks;
+}
+
+/**
+ * @brief Append runs of differing bytes of a page.
+ *
+ * @param[in]  chunk       chunk that the page belongs to
+ * @param[in]  page_offset offset of the page in the chunk
+ * @param[in]  lhs         left-hand side page data
+ * @param[in]  rhs         right-hand side page data
+ * @param[in]  size        page size
+ * @param[out] differences differences to append to
+ */
+auto diff_page(
+	diff_chunk const&               chunk,
+	std::size_t                     page_offset,
+	unsigned char const*            lhs,
+	unsigned char const*            rhs,
+	std::size_t                     size,
+	std::vector<memory_difference>& differences
+) -> void
+{
+	for (std::size_t i = 0; i < size;)
+	{
+		if (lhs[i] == rhs[i])
+		{
+			++i;
+			continue;
+		}
+
+		std::size_t const begin = i;
+		while (i < size && lhs[i] != rhs[i])
+		{
+			++i;
+		}
+
+		differences.push_back({std::string(chunk.module), chunk.offset + page_offset + begin, i - begin});
+	}
+}
+
+/**
+ * @brief Sort differences and merge adjacent ones.
+ *
+ * @param[in,out] differences differences to normalize
+ */
+auto normalize(std::vector<memory_difference>& differences) -> void
+{
+	std::ranges::sort(differences, [](auto const& lhs, auto const& rhs) {
+		return std::tie(lhs.module, lhs.offset) < std::tie(rhs.module, rhs.offset);
+	});
+
+	auto out = differences.begin();
+	for (auto it = differences.begin(); it != differences.end(); ++it)
+	{
+		if (out != differences.begin())
+		{
+			auto& last = *std::prev(out);
+			if (last.module == it->module && last.offset + last.size == it->offset)
+			{
+				last.size += it->size;
+				continue;
+			}
+		}
+
+		if (out != it)
+		{
+			*out = std::move(*it);
+		}
+
+		++out;
+	}
+
+	differences.erase(out, differences.end());
+}
+}
+
+template <handle_mode LhsMode, handle_mode RhsMode>
+auto diff(
+	handle<LhsMode> const&            lhs,
+	std::vector<memory_region> const& lhs_regions,
+	handle<RhsMode> const&            rhs,
+	std::vector<memory_region> const& rhs_regions,
+	diff_options const&               options
+) -> std::vector<memory_difference>
+	requires handle<LhsMode>::readable && handle<RhsMode>::readable
+{
+	std::size_t const chunk_size = std::max(options.chunk_size, options.page_size);
+	std::size_t const page_size  = std::max<std::size_t>(options.page_size, 1);
+
+	auto const lhs_modules = attribute_regions(lhs_regions);
+	auto const rhs_modules = attribute_regions(rhs_regions);
+	auto const chunks      = pair_regions(lhs_modules, rhs_modules, chunk_size);
+
+	std::size_t const threads = std::min<std::size_t>(
+		chunks.size(),
+		options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u)
+	);
+
+	std::vector<memory_difference> differences;
+	std::mutex                     differences_mutex;
+	std::exception_ptr             exception;
+
+	// Each worker pipelines its share of chunks through a pair of readers, so
+	// that reading the next chunks overlaps with comparing the current ones.
+	auto const worker = [&](std::size_t first_chunk)
+	{
+		std::vector<memory_difference> local_differences;
+
+		try
+		{
+			std::vector<address_range> lhs_ranges;
+			std::vector<address_range> rhs_ranges;
+
+			for (std::size_t i = first_chunk; i < chunks.size(); i += threads)
+			{
+				lhs_ranges.push_back({chunks[i].lhs_address, chunks[i].lhs_address + chunks[i].size});
+				rhs_ranges.push_back({chunks[i].rhs_address, chunks[i].rhs_address + chunks[i].size});
+			}
+
+			region_reader_options const reader_options{.chunk_size = chunk_size};
+
+			region_reader lhs_reader(lhs, std::move(lhs_ranges), reader_options);
+			region_reader rhs_reader(rhs, std::move(rhs_ranges), reader_options);
+
+			for (std::size_t i = first_chunk; i < chunks.size(); i += threads)
+			{
+				auto const lhs_chunk = lhs_reader.next();
+				auto const rhs_chunk = rhs_reader.next();
+
+				std::size_t const size = std::min(lhs_chunk->data.size(), rhs_chunk->data.size());
+
+				WORM_PROBE(diff_chunk__entry, chunks[i].lhs_address, chunks[i].rhs_address, size);
+
+				std::size_t const differences_before = local_differences.size();
+
+				for (std::size_t page = 0; page < size; page += page_size)
+				{
+					std::size_t const n = std::min(page_size, size - page);
+
+					auto const* const l = lhs_chunk->data.data() + page;
+					auto const* const r = rhs_chunk->data.data() + page;
+
+					if (std::memcmp(l, r, n) != 0)
+					{
+						diff_page(chunks[i], page, l, r, n, local_differences);
+					}
+				}
+
+				WORM_PROBE(diff_chunk__return, chunks[i].lhs_address, chunks[i].rhs_address, size, local_differences.size() - differences_before);
+			}
+		}
+		catch (...)
+		{
+			std::scoped_lock lock(differences_mutex);
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+
+			return;
+		}
+
+		std::scoped_lock lock(differences_mutex);
+		differences.insert(differences.end(), std::make_move_iterator(local_differences.begin()), std::make_move_iterator(local_differences.end()));
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(worker, i);
+	}
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	normalize(differences);
+
+	return differences;
+}
+
+template <handle_mode LhsMode, handle_mode RhsMode>
+auto diff(handle<LhsMode> const& lhs, handle<RhsMode> const& rhs, diff_options const& options) -> std::vector<memory_difference>
+	requires handle<LhsMode>::readable && handle<RhsMode>::readable
+{
+	return diff(lhs, lhs.regions(), rhs, rhs.regions(), options);
+}
+
+template <handle_mode SrcMode, handle_mode DstMode>
+auto clone_memory(
+	handle<SrcMode> const&            src,
+	std::vector<memory_region> const& src_regions,
+	handle<DstMode> const&            dst,
+	std::vector<memory_region> const& dst_regions,
+	clone_options const&              options
+) -> clone_result
+	requires handle<SrcMode>::readable && handle<DstMode>::writable
+{
+	std::size_t const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+
+	auto const src_modules = attribute_regions(src_regions, memory_permission::read);
+	auto const dst_modules = attribute_regions(dst_regions, memory_permission::write);
+	auto const chunks      = pair_regions(src_modules, dst_modules, chunk_size);
+
+	std::size_t const threads = std::min<std::size_t>(
+		chunks.size(),
+		options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u)
+	);
+
+	clone_result       result;
+	std::mutex         result_mutex;
+	std::exception_ptr exception;
+
+	// Each worker pipelines its share of chunks through a reader, so that
+	// reading the next chunks from the source overlaps with writing the current one.
+	auto const worker = [&](std::size_t first_chunk)
+	{
+		clone_result local_result;
+
+		try
+		{
+			std::vector<address_range> ranges;
+
+			for (std::size_t i = first_chunk; i < chunks.size(); i += threads)
+			{
+				ranges.push_back({chunks[i].lhs_address, chunks[i].lhs_address + chunks[i].size});
+			}
+
+			region_reader reader(src, std::move(ranges), {.chunk_size = chunk_size, .depth = std::max<std::size_t>(options.depth, 1)});
+
+			for (std::size_t i = first_chunk; i < chunks.size(); i += threads)
+			{
+				auto const chunk = reader.next();
+
+				WORM_PROBE(clone_chunk__entry, chunks[i].lhs_address, chunks[i].rhs_address, chunk->data.size());
+
+				// The vectored write skips an inaccessible destination rather than failing.
+				memory_transfer transfer{chunks[i].rhs_address, const_cast<unsigned char*>(chunk->data.data()), chunk->data.size()};
+
+				std::size_t const written = chunk->data.empty() ? 0 : dst.write_bytes(std::span(&transfer, 1));
+
+				WORM_PROBE(clone_chunk__return, chunks[i].lhs_address, chunks[i].rhs_address, chunk->data.size(), written);
+
+				local_result.copied  += written;
+				local_result.skipped += chunks[i].size - written;
+			}
+		}
+		catch (...)
+		{
+			std::scoped_lock lock(result_mutex);
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+
+			return;
+		}
+
+		std::scoped_lock lock(result_mutex);
+		result.copied  += local_result.copied;
+		result.skipped += local_result.skipped;
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(worker, i);
+	}
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	return result;
+}
+
+template <handle_mode SrcMode>
+auto clone_memory(handle<SrcMode> const& src, iohandle const& dst, clone_options const& options) -> clone_result
+	requires handle<SrcMode>::readable
+{
+	return clone_memory(src, src.regions(), dst, dst.regions(), options);
+}
+
+template auto diff(handle<handle_mode::in> const&, std::vector<memory_region> const&, handle<handle_mode::in> const&, std::vector<memory_region> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in> const&, std::vector<memory_region> const&, handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, handle<handle_mode::in> const&, std::vector<memory_region> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, diff_options const&) -> std::vector<memory_difference>;
+
+template auto diff(handle<handle_mode::in> const&, handle<handle_mode::in> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in> const&, handle<handle_mode::in | handle_mode::out> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in | handle_mode::out> const&, handle<handle_mode::in> const&, diff_options const&) -> std::vector<memory_difference>;
+template auto diff(handle<handle_mode::in | handle_mode::out> const&, handle<handle_mode::in | handle_mode::out> const&, diff_options const&) -> std::vector<memory_difference>;
+
+template auto clone_memory(handle<handle_mode::in> const&, std::vector<memory_region> const&, handle<handle_mode::out> const&, std::vector<memory_region> const&, clone_options const&) -> clone_result;
+template auto clone_memory(handle<handle_mode::in> const&, std::vector<memory_region> const&, handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, clone_options const&) -> clone_result;
+template auto clone_memory(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, handle<handle_mode::out> const&, std::vector<memory_region> const&, clone_options const&) -> clone_result;
+template auto clone_memory(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, clone_options const&) -> clone_result;
+
+template auto clone_memory(handle<handle_mode::in> const&, iohandle const&, clone_options const&) -> clone_result;
+template auto clone_memory(handle<handle_mode::in | handle_mode::out> const&, iohandle const&, clone_options const&) -> clone_result;
+}
@@ -0,0 +1,516 @@
+#include "platform.hpp"
+
+#include "worm/libstdcxx.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace worm::libstdcxx
+{
+namespace
+{
+/// Size of a pointer in the target.
+constexpr std::size_t word_size = sizeof(address_t);
+
+/// Maximum number of bytes of elements of a container, above which its layout is considered inconsistent.
+constexpr std::size_t max_container_size = std::size_t{1} << 36;
+
+/// Offset of the inline buffer of `std::string`.
+constexpr std::size_t string_buffer_offset = 2 * word_size;
+
+/// Capacity of the inline buffer of `std::string`, without the terminator.
+constexpr std::size_t string_buffer_capacity = 15;
+
+/// Number of bytes in a buffer of `std::deque` with elements of up to this size.
+constexpr std::size_t deque_buffer_size = 512;
+
+/// Size of `std::_Rb_tree_node_base`.
+constexpr std::size_t tree_node_size = 4 * word_size;
+
+/// Offset of `_M_before_begin` of `std::_Hashtable`.
+constexpr std::size_t hashtable_before_begin_offset = 2 * word_size;
+
+[[nodiscard]]
+auto make_layout_error() -> std::system_error
+{
+	return {std::make_error_code(std::errc::bad_message), "container layout is inconsistent"};
+}
+
+[[nodiscard]]
+auto align_up(std::size_t offset, std::size_t alignment) noexcept -> std::size_t
+{
+	alignment = std::max<std::size_t>(alignment, 1);
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Read bytes, failing unless all of them could be read.
+ *
+ * @throws `std::system_error` on failed read attempt
+ */
+template <handle_mode Mode>
+auto read_exact(handle<Mode> const& h, address_t addr, void* dst, std::size_t size) -> void
+{
+	if (size && h.read_bytes(addr, dst, size) != size)
+	{
+		throw std::system_error(std::make_error_code(std::errc::bad_address), "failed to read container");
+	}
+}
+
+/**
+ * @brief Read transfers in batches, failing unless all of them could be read.
+ *
+ * @throws `std::system_error` on failed read attempt
+ */
+template <handle_mode Mode>
+auto read_exact(handle<Mode> const& h, std::span<memory_transfer> transfers) -> void
+{
+	h.read_bytes(transfers);
+
+	for (auto const& t : transfers)
+	{
+		if (t.transferred != t.size)
+		{
+			throw std::system_error(std::make_error_code(std::errc::bad_address), "failed to read container");
+		}
+	}
+}
+
+/**
+ * @brief Check that a range holds a whole number of elements of sane size.
+ *
+ * @throws `std::system_error` if it does not
+ */
+auto check_range(address_t begin, address_t end, std::size_t element_size) -> void
+{
+	if (end < begin || end - begin > max_container_size || (end - begin) % element_size)
+	{
+		throw make_layout_error();
+	}
+}
+
+/**
+ * @brief Read nodes of a linked structure breadth-first.
+ *
+ * Every round reads all nodes found by the previous one in a single batched read.
+ *
+ * @param[in]  h         handle
+ * @param[in]  roots     addresses of the first nodes
+ * @param[in]  node_size number of bytes of a node to read
+ * @param[in]  max_nodes maximum number of nodes
+ * @param[in]  links     offsets of pointers to other nodes
+ * @param[out] nodes     addresses of read nodes
+ * @param[out] staging   bytes of read nodes, one after another
+ *
+ * @throws `std::system_error` on failed read attempt, or if there are more nodes than the maximum
+ */
+template <handle_mode Mode>
+auto read_nodes(
+	handle<Mode> const&         h,
+	std::vector<address_t>      roots,
+	std::size_t                 node_size,
+	std::size_t                 max_nodes,
+	std::span<std::size_t const> links,
+	std::vector<address_t>&     nodes,
+	std::vector<unsigned char>& staging
+) -> void
+{
+	std::unordered_set<address_t> visited;
+	visited.reserve(max_nodes);
+
+	std::vector<address_t>       frontier = std::move(roots);
+	std::vector<address_t>       next;
+	std::vector<memory_transfer> transfers;
+
+	while (!frontier.empty())
+	{
+		std::size_t const first = nodes.size();
+
+		for (auto const node : frontier)
+		{
+			if (visited.insert(node).second)
+			{
+				nodes.push_back(node);
+			}
+		}
+
+		if (nodes.size() > max_nodes)
+		{
+			throw make_layout_error();
+		}
+
+		staging.resize(nodes.size() * node_size);
+
+		transfers.clear();
+		for (std::size_t i = first; i < nodes.size(); ++i)
+		{
+			transfers.push_back({nodes[i], staging.data() + i * node_size, node_size});
+		}
+
+		read_exact(h, std::span(transfers));
+
+		next.clear();
+		for (std::size_t i = first; i < nodes.size(); ++i)
+		{
+			for (auto const offset : links)
+			{
+				address_t link;
+				std::memcpy(&link, staging.data() + i * node_size + offset, sizeof(link));
+
+				if (link && !visited.contains(link))
+				{
+					next.push_back(link);
+				}
+			}
+		}
+
+		std::swap(frontier, next);
+	}
+}
+}
+
+auto container_elements::size() const noexcept -> std::size_t
+{
+	return addresses.size();
+}
+
+template <handle_mode Mode>
+auto vector_elements(handle<Mode> const& h, address_t addr, std::size_t element_size) -> container_elements
+	requires handle<Mode>::readable
+{
+	std::array<address_t, 3> header;
+	read_exact(h, addr, header.data(), sizeof(header));
+
+	address_t const begin = header[0];
+	address_t const end   = header[1];
+	check_range(begin, end, element_size);
+
+	container_elements elements{.element_size = element_size};
+
+	std::size_t const count = (end - begin) / element_size;
+
+	elements.bytes.resize(end - begin);
+	read_exact(h, begin, elements.bytes.data(), elements.bytes.size());
+
+	elements.addresses.resize(count);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		elements.addresses[i] = begin + i * element_size;
+	}
+
+	return elements;
+}
+
+template <handle_mode Mode>
+auto deque_elements(handle<Mode> const& h, address_t addr, std::size_t element_size) -> container_elements
+	requires handle<Mode>::readable
+{
+	// Map, map size, and iterators to the first and past the last element, each of current, first, last and node.
+	std::array<address_t, 10> header;
+	read_exact(h, addr, header.data(), sizeof(header));
+
+	address_t const start_cur   = header[2];
+	address_t const start_last  = header[4];
+	address_t const start_node  = header[5];
+	address_t const finish_cur  = header[6];
+	address_t const finish_node = header[9];
+
+	std::size_t const buffer_size = element_size < deque_buffer_size ? deque_buffer_size / element_size * element_size : element_size;
+
+	if (finish_node < start_node || (finish_node - start_node) % word_size)
+	{
+		throw make_layout_error();
+	}
+
+	std::size_t const buffer_count = (finish_node - start_node) / word_size + 1;
+	if (buffer_count > max_container_size / buffer_size)
+	{
+		throw make_layout_error();
+	}
+
+	std::vector<address_t> buffers(buffer_count);
+
+	read_exact(h, start_node, buffers.data(), buffers.size() * word_size);
+
+	container_elements elements{.element_size = element_size};
+
+	// Ranges of elements in each buffer.
+	std::vector<address_range> ranges;
+	std::size_t                total = 0;
+
+	for (std::size_t i = 0; i < buffers.size(); ++i)
+	{
+		address_t const begin = i == 0 ? start_cur : buffers[i];
+		address_t const end   = i + 1 == buffers.size() ? finish_cur : i == 0 ? start_last : buffers[i] + buffer_size;
+
+		check_range(begin, end, element_size);
+		if (begin < buffers[i] || end > buffers[i] + buffer_size)
+		{
+			throw make_layout_error();
+		}
+
+		ranges.emplace_back(begin, end);
+		total += end - begin;
+	}
+
+	elements.bytes.resize(total);
+
+	std::vector<memory_transfer> transfers;
+	total = 0;
+
+	for (auto const& range : ranges)
+	{
+		if (range.empty())
+		{
+			continue;
+		}
+
+		std::size_t const size = range.size();
+
+		transfers.push_back({range.front(), elements.bytes.data() + total, size});
+		total += size;
+
+		for (address_t element = range.front(); element < *range.end(); element += element_size)
+		{
+			elements.addresses.push_back(element);
+		}
+	}
+
+	read_exact(h, std::span(transfers));
+
+	return elements;
+}
+
+template <handle_mode Mode>
+auto tree_elements(handle<Mode> const& h, address_t addr, std::size_t element_size, std::size_t element_align) -> container_elements
+	requires handle<Mode>::readable
+{
+	// Comparator, then header node of color, root, leftmost and rightmost nodes, then node count.
+	std::array<address_t, 6> header;
+	read_exact(h, addr, header.data(), sizeof(header));
+
+	address_t const   root  = header[2];
+	std::size_t const count = header[5];
+
+	container_elements elements{.element_size = element_size};
+
+	if (!root || !count)
+	{
+		return elements;
+	}
+
+	std::size_t const value_offset = align_up(tree_node_size, element_align);
+	std::size_t const node_size    = value_offset + element_size;
+
+	if (count > max_container_size / node_size)
+	{
+		throw make_layout_error();
+	}
+
+	// Nodes are read breadth-first through their left and right children.
+	static constexpr std::size_t links[] = {2 * word_size, 3 * word_size};
+
+	std::vector<address_t>     nodes;
+	std::vector<unsigned char> staging;
+	read_nodes(h, {root}, node_size, count, links, nodes, staging);
+
+	if (nodes.size() != count)
+	{
+		throw make_layout_error();
+	}
+
+	std::unordered_map<address_t, std::size_t> indices;
+	indices.reserve(nodes.size());
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		indices.emplace(nodes[i], i);
+	}
+
+	auto const link = [&](std::size_t node, std::size_t offset) -> address_t
+	{
+		address_t child;
+		std::memcpy(&child, staging.data() + node * node_size + offset, sizeof(child));
+		return child;
+	};
+
+	elements.addresses.reserve(count);
+	elements.bytes.reserve(count * element_size);
+
+	// Elements are sorted by traversing the tree in order.
+	std::vector<std::size_t> stack;
+	address_t                current = root;
+
+	while (current || !stack.empty())
+	{
+		while (current)
+		{
+			auto const it = indices.find(current);
+			if (it == indices.end() || stack.size() > count)
+			{
+				throw make_layout_error();
+			}
+
+			stack.push_back(it->second);
+			current = link(it->second, links[0]);
+		}
+
+		std::size_t const node = stack.back();
+		stack.pop_back();
+
+		if (elements.addresses.size() == count)
+		{
+			throw make_layout_error();
+		}
+
+		auto const* const value = staging.data() + node * node_size + value_offset;
+
+		elements.addresses.push_back(nodes[node] + value_offset);
+		elements.bytes.insert(elements.bytes.end(), value, value + element_size);
+
+		current = link(node, links[1]);
+	}
+
+	return elements;
+}
+
+template <handle_mode Mode>
+auto hashtable_elements(handle<Mode> const& h, address_t addr, std::size_t element_size, std::size_t element_align) -> container_elements
+	requires handle<Mode>::readable
+{
+	// Buckets, bucket count, first node, and element count.
+	std::array<address_t, 4> header;
+	read_exact(h, addr, header.data(), sizeof(header));
+
+	auto const [buckets, bucket_count, first, count] = header;
+
+	container_elements elements{.element_size = element_size};
+
+	if (!first || !count)
+	{
+		return elements;
+	}
+
+	std::size_t const value_offset = align_up(word_size, element_align);
+	std::size_t const node_size    = value_offset + element_size;
+
+	if (count > max_container_size / node_size || bucket_count > max_container_size / word_size)
+	{
+		throw make_layout_error();
+	}
+
+	// Each bucket points to the node before its first node, so that all of
+	// them start walking the list at once, and chains are only as long as buckets.
+	std::vector<address_t> roots(bucket_count);
+	read_exact(h, buckets, roots.data(), roots.size() * word_size);
+
+	address_t const before_begin = addr + hashtable_before_begin_offset;
+
+	std::erase_if(roots, [&](address_t node) { return !node || node == before_begin; });
+	roots.push_back(first);
+
+	std::ranges::sort(roots);
+	roots.erase(std::ranges::unique(roots).begin(), roots.end());
+
+	static constexpr std::size_t links[] = {0};
+
+	std::vector<address_t>     nodes;
+	std::vector<unsigned char> staging;
+	read_nodes(h, std::move(roots), node_size, count, links, nodes, staging);
+
+	if (nodes.size() != count)
+	{
+		throw make_layout_error();
+	}
+
+	elements.addresses.resize(count);
+	elements.bytes.resize(count * element_size);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		elements.addresses[i] = nodes[i] + value_offset;
+		std::memcpy(elements.bytes.data() + i * element_size, staging.data() + i * node_size + value_offset, element_size);
+	}
+
+	return elements;
+}
+
+template <handle_mode Mode>
+auto read_string(handle<Mode> const& h, address_t addr) -> std::string
+	requires handle<Mode>::readable
+{
+	return std::move(read_strings(h, std::span(&addr, 1)).front());
+}
+
+template <handle_mode Mode>
+auto read_strings(handle<Mode> const& h, std::span<address_t const> addrs) -> std::vector<std::string>
+	requires handle<Mode>::readable
+{
+	// Pointer to characters, length, and inline buffer.
+	std::vector<std::array<address_t, 4>> headers(addrs.size());
+	std::vector<memory_transfer>          transfers;
+
+	for (std::size_t i = 0; i < addrs.size(); ++i)
+	{
+		transfers.push_back({addrs[i], headers[i].data(), sizeof(headers[i])});
+	}
+
+	read_exact(h, std::span(transfers));
+
+	std::vector<std::string> strings(addrs.size());
+	transfers.clear();
+
+	for (std::size_t i = 0; i < addrs.size(); ++i)
+	{
+		address_t const   data   = headers[i][0];
+		std::size_t const length = headers[i][1];
+
+		if (data == addrs[i] + string_buffer_offset)
+		{
+			if (length > string_buffer_capacity)
+			{
+				throw make_layout_error();
+			}
+
+			strings[i].assign(reinterpret_cast<char const*>(headers[i].data()) + string_buffer_offset, length);
+			continue;
+		}
+
+		if (length > max_container_size)
+		{
+			throw make_layout_error();
+		}
+
+		strings[i].resize(length);
+		if (length)
+		{
+			transfers.push_back({data, strings[i].data(), length});
+		}
+	}
+
+	read_exact(h, std::span(transfers));
+
+	return strings;
+}
+
+template auto vector_elements(handle<handle_mode::in> const&, address_t, std::size_t) -> container_elements;
+template auto vector_elements(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t) -> container_elements;
+
+template auto deque_elements(handle<handle_mode::in> const&, address_t, std::size_t) -> container_elements;
+template auto deque_elements(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t) -> container_elements;
+
+template auto tree_elements(handle<handle_mode::in> const&, address_t, std::size_t, std::size_t) -> container_elements;
+template auto tree_elements(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t, std::size_t) -> container_elements;
+
+template auto hashtable_elements(handle<handle_mode::in> const&, address_t, std::size_t, std::size_t) -> container_elements;
+template auto hashtable_elements(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t, std::size_t) -> container_elements;
+
+template auto read_string(handle<handle_mode::in> const&, address_t) -> std::string;
+template auto read_string(handle<handle_mode::in | handle_mode::out> const&, address_t) -> std::string;
+
+template auto read_strings(handle<handle_mode::in> const&, std::span<address_t const>) -> std::vector<std::string>;
+template auto read_strings(handle<handle_mode::in | handle_mode::out> const&, std::span<address_t const>) -> std::vector<std::string>;
+}
@@ -0,0 +1,471 @@
+#include "platform.hpp"
+
+#include "worm/mirror.hpp"
+
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#if defined(WORM_POSIX)
+
+#	include <thread>
+
+#	include <fcntl.h>
+#	include <linux/userfaultfd.h>
+#	include <poll.h>
+#	include <sys/eventfd.h>
+#	include <sys/ioctl.h>
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+
+#elif defined(WORM_WINDOWS)
+
+#	include <sysinfoapi.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+/// Get size of a virtual memory page.
+[[nodiscard]]
+auto page_size() noexcept -> std::size_t
+{
+#if defined(WORM_POSIX)
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(WORM_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#endif
+}
+}
+
+template <handle_mode Mode>
+struct mirror<Mode>::state
+{
+	/// Handle to read remote pages with.
+	handle_type const& h;
+
+	/// Page size.
+	std::size_t const page;
+
+	/// Remote virtual memory address of the first mirrored page.
+	address_t const base;
+
+	/// Number of bytes in mirrored pages.
+	std::size_t const length;
+
+	/// Local address of the first mirrored page.
+	unsigned char* local = nullptr;
+
+#ifdef WORM_POSIX
+	/// Userfaultfd file descriptor.
+	int uffd = -1;
+
+	/// Event file descriptor that stops the handler.
+	int stop = -1;
+
+	/// Fault handler thread.
+	std::thread handler;
+#endif
+
+	state(handle_type const& h, address_t addr, std::size_t size)
+		: h{h}
+		, page{page_size()}
+		, base{addr & ~(page - 1)}
+		, length{((addr + size - base) + page - 1) & ~(page - 1)}
+	{
+#if defined(WORM_POSIX)
+		void* const mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mapping == MAP_FAILED)
+		{
+			throw make_system_error("failed to map a mirror");
+		}
+
+		local = static_cast<unsigned char*>(mapping);
+
+		try
+		{
+			// Kernel-mode faults are handled too if allowed, so that the mirror can be passed to system calls.
+			uffd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK));
+#	ifdef UFFD_USER_MODE_ONLY
+			if (uffd == -1 && errno == EPERM)
+			{
+				uffd = static_cast<int>(syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY));
+			}
+#	endif
+			if (uffd == -1)
+			{
+				throw make_system_error("failed to create a userfaultfd");
+			}
+
+			uffdio_api api{};
+			api.api = UFFD_API;
+
+			if (ioctl(uffd, UFFDIO_API, &api) == -1)
+			{
+				throw make_system_error("failed to negotiate userfaultfd API");
+			}
+
+			uffdio_register reg{};
+			reg.range = {reinterpret_cast<std::uint64_t>(local), length};
+			reg.mode  = UFFDIO_REGISTER_MODE_MISSING;
+
+			if (ioctl(uffd, UFFDIO_REGISTER, &reg) == -1)
+			{
+				throw make_system_error("failed to register a mirror with userfaultfd");
+			}
+
+			stop = eventfd(0, EFD_CLOEXEC);
+			if (stop == -1)
+			{
+				throw make_system_error("failed to create a mirror stop event");
+			}
+
+			handler = std::thread(&state::handle_faults, this);
+		}
+		catch (...)
+		{
+			release();
+			throw;
+		}
+#elif defined(WORM_WINDOWS)
+		local = static_cast<unsigned char*>(VirtualAlloc(nullptr, length, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+		if (!local)
+		{
+			throw make_system_error("failed to map a mirror");
+		}
+
+		fill(0, length);
+#endif
+	}
+
+	state(state const&)                    = delete;
+	auto operator=(state const&) -> state& = delete;
+
+	~state()
+	{
+#ifdef WORM_POSIX
+		if (handler.joinable())
+		{
+			std::uint64_t const value = 1;
+			static_cast<void>(write(stop, &value, sizeof(value)));
+
+			handler.join();
+		}
+#endif
+
+		release();
+	}
+
+	/// Release the mapping and file descriptors.
+	auto release() noexcept -> void
+	{
+#if defined(WORM_POSIX)
+		for (int const fd : {uffd, stop})
+		{
+			if (fd != -1)
+			{
+				close(fd);
+			}
+		}
+
+		munmap(local, length);
+#elif defined(WORM_WINDOWS)
+		VirtualFree(local, 0, MEM_RELEASE);
+#endif
+	}
+
+	/**
+	 * @brief Transfer remote pages into the mirror.
+	 *
+	 * Pages that could not be read are filled with zeros.
+	 *
+	 * @param[in] offset page-aligned offset of the first page
+	 * @param[in] size   page-aligned number of bytes to transfer
+	 */
+	auto fill(std::size_t offset, std::size_t size) noexcept -> void
+	{
+#if defined(WORM_POSIX)
+		auto const buffer = std::unique_ptr<unsigned char[]>(new (std::nothrow) unsigned char[size]);
+		if (!buffer)
+		{
+			zero(offset, size);
+			return;
+		}
+
+		// Everything up to the first unreadable page is read at once, the rest page by page.
+		std::size_t bytes_read = 0;
+		try
+		{
+			bytes_read = h.read_bytes(base + offset, buffer.get(), size);
+		}
+		catch (std::system_error const&)
+		{}
+
+		std::size_t const full_pages = bytes_read & ~(page - 1);
+
+		copy(offset, buffer.get(), full_pages);
+
+		for (std::size_t p = full_pages; p < size; p += page)
+		{
+			std::size_t page_read = 0;
+			try
+			{
+				page_read = h.read_bytes(base + offset + p, buffer.get() + p, page);
+			}
+			catch (std::system_error const&)
+			{}
+
+			std::memset(buffer.get() + p + page_read, 0, page - page_read);
+			copy(offset + p, buffer.get() + p, page);
+		}
+#elif defined(WORM_WINDOWS)
+		for (std::size_t p = 0; p < size; p += page)
+		{
+			std::size_t page_read = 0;
+			try
+			{
+				page_read = h.read_bytes(base + offset + p, local + offset + p, page);
+			}
+			catch (std::system_error const&)
+			{}
+
+			std::memset(local + offset + p + page_read, 0, page - page_read);
+		}
+#endif
+	}
+
+#ifdef WORM_POSIX
+	/**
+	 * @brief Atomically populate missing pages of the mirror and wake up faulting threads.
+	 *
+	 * Pages that have been populated concurrently are skipped, and pages that
+	 * could not be copied are filled with zeros.
+	 *
+	 * @param[in] offset page-aligned offset of the first page
+	 * @param[in] src    source buffer
+	 * @param[in] size   page-aligned number of bytes to copy
+	 */
+	auto copy(std::size_t offset, unsigned char const* src, std::size_t size) noexcept -> void
+	{
+		while (size)
+		{
+			uffdio_copy c{};
+			c.dst = reinterpret_cast<std::uint64_t>(local + offset);
+			c.src = reinterpret_cast<std::uint64_t>(src);
+			c.len = size;
+
+			if (ioctl(uffd, UFFDIO_COPY, &c) == 0)
+			{
+				return;
+			}
+
+			int const error = errno;
+			if (error != EEXIST && error != EAGAIN)
+			{
+				std::size_t const copied = c.copy > 0 ? static_cast<std::size_t>(c.copy) : 0;
+
+				zero(offset + copied, size - std::min(copied, size));
+				return;
+			}
+
+			// A concurrently populated page stops the copy, so it is skipped.
+			std::size_t const copied  = c.copy > 0 ? static_cast<std::size_t>(c.copy) : 0;
+			std::size_t const skipped = copied + (error == EEXIST ? page : 0);
+
+			offset += skipped;
+			src += skipped;
+			size -= std::min(skipped, size);
+		}
+	}
+
+	/**
+	 * @brief Atomically populate missing pages of the mirror with zeros and wake up faulting threads.
+	 *
+	 * It is the fallback of failed copies, so that faulting threads never wait
+	 * forever. If even zeros cannot be placed, the threads are woken up to fault
+	 * again.
+	 *
+	 * @param[in] offset page-aligned offset of the first page
+	 * @param[in] size   page-aligned number of bytes
+	 */
+	auto zero(std::size_t offset, std::size_t size) noexcept -> void
+	{
+		while (size)
+		{
+			uffdio_zeropage z{};
+			z.range = {reinterpret_cast<std::uint64_t>(local + offset), size};
+
+			if (ioctl(uffd, UFFDIO_ZEROPAGE, &z) == 0)
+			{
+				return;
+			}
+
+			int const error = errno;
+			if (error != EEXIST && error != EAGAIN)
+			{
+				uffdio_range wake{reinterpret_cast<std::uint64_t>(local + offset), size};
+				ioctl(uffd, UFFDIO_WAKE, &wake);
+				return;
+			}
+
+			// A concurrently populated page stops zeroing, so it is skipped.
+			std::size_t const zeroed  = z.zeropage > 0 ? static_cast<std::size_t>(z.zeropage) : 0;
+			std::size_t const skipped = zeroed + (error == EEXIST ? page : 0);
+
+			offset += skipped;
+			size -= std::min(skipped, size);
+		}
+	}
+
+	/// Handle page faults until stopped.
+	auto handle_faults() noexcept -> void
+	{
+		pollfd fds[]{
+			{uffd, POLLIN, 0},
+			{stop, POLLIN, 0},
+		};
+
+		while (true)
+		{
+			if (poll(fds, std::size(fds), -1) == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				return;
+			}
+
+			if (fds[1].revents)
+			{
+				return;
+			}
+
+			uffd_msg msg;
+			if (::read(uffd, &msg, sizeof(msg)) != sizeof(msg) || msg.event != UFFD_EVENT_PAGEFAULT)
+			{
+				continue;
+			}
+
+			auto const fault = static_cast<address_t>(msg.arg.pagefault.address);
+
+			fill((fault - reinterpret_cast<address_t>(local)) & ~(page - 1), page);
+		}
+	}
+#endif
+
+	/**
+	 * @brief Convert a remote range to page-aligned offsets in the mirror.
+	 *
+	 * @param[in] addr remote virtual memory address
+	 * @param[in] size number of bytes
+	 *
+	 * @return offset of the first page and number of bytes in the pages
+	 */
+	[[nodiscard]]
+	auto pages(address_t addr, std::size_t size) const noexcept -> std::pair<std::size_t, std::size_t>
+	{
+		address_t const begin = std::max(addr, base) & ~(page - 1);
+		address_t const end   = std::min(addr + size, base + length);
+
+		if (end <= begin)
+		{
+			return {0, 0};
+		}
+
+		return {begin - base, ((end - begin) + page - 1) & ~(page - 1)};
+	}
+
+	/**
+	 * @brief Invalidate pages.
+	 *
+	 * @param[in] offset page-aligned offset of the first page
+	 * @param[in] size   page-aligned number of bytes
+	 */
+	auto invalidate(std::size_t offset, std::size_t size) -> void
+	{
+#if defined(WORM_POSIX)
+		if (size && madvise(local + offset, size, MADV_DONTNEED) == -1)
+		{
+			throw make_system_error("failed to invalidate mirrored pages");
+		}
+#elif defined(WORM_WINDOWS)
+		fill(offset, size);
+#endif
+	}
+};
+
+template <handle_mode Mode>
+mirror<Mode>::mirror(handle_type const& h, address_t addr, std::size_t size)
+	requires(handle_type::readable)
+	: state_{std::make_unique<state>(h, addr, size)}
+	, addr_{addr}
+	, size_{size}
+{}
+
+template <handle_mode Mode>
+mirror<Mode>::mirror(mirror&&) noexcept = default;
+
+template <handle_mode Mode>
+auto mirror<Mode>::operator=(mirror&&) noexcept -> mirror& = default;
+
+template <handle_mode Mode>
+mirror<Mode>::~mirror() = default;
+
+template <handle_mode Mode>
+auto mirror<Mode>::data() const noexcept -> void const*
+{
+	return state_->local + (addr_ - state_->base);
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::address() const noexcept -> address_t
+{
+	return addr_;
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::size() const noexcept -> std::size_t
+{
+	return size_;
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::invalidate(address_t addr, std::size_t size) -> void
+{
+	auto const [offset, length] = state_->pages(addr, size);
+	state_->invalidate(offset, length);
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::invalidate() -> void
+{
+	state_->invalidate(0, state_->length);
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::refresh(address_t addr, std::size_t size) -> void
+{
+	auto const [offset, length] = state_->pages(addr, size);
+
+	state_->invalidate(offset, length);
+#ifdef WORM_POSIX
+	state_->fill(offset, length);
+#endif
+}
+
+template <handle_mode Mode>
+auto mirror<Mode>::refresh() -> void
+{
+	refresh(state_->base, state_->length);
+}
+
+template struct mirror<handle_mode::in>;
+template struct mirror<handle_mode::in | handle_mode::out>;
+}
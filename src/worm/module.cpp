@@ -0,0 +1,177 @@
+#include "worm/module.hpp"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+namespace worm
+{
+namespace
+{
+/**
+ * @brief Check whether a region maps a module file.
+ *
+ * Pseudo-regions such as `[heap]`, `[stack]` and `[anon:name]` are named,
+ * but are not backed by a file.
+ *
+ * @param[in] region memory region
+ */
+[[nodiscard]]
+auto maps_module(memory_region const& region) noexcept -> bool
+{
+	if (region.name.empty() || region.name.starts_with('['))
+	{
+		return false;
+	}
+
+#ifdef WORM_POSIX
+	return region.inode != 0;
+#else
+	return true;
+#endif
+}
+}
+
+module_table::module_table(std::vector<memory_region> const& regions)
+{
+	static constexpr std::size_t no_module = -1;
+
+	std::map<std::string_view, std::size_t> indices;
+
+	std::size_t       module            = no_module;
+	address_t         module_end        = 0;
+	memory_permission module_permission = memory_permission::none;
+
+	for (auto const& region : regions)
+	{
+		address_t const begin = region.range.front();
+		address_t const end   = *region.range.end();
+
+		// Anonymous `.bss` immediately follows a writable mapping of its module with the same permissions.
+		bool const bss = region.name.empty() && module != no_module && module_end == begin && region.permissions == module_permission
+		                 && (module_permission & memory_permission::write) == memory_permission::write;
+
+		if (maps_module(region))
+		{
+			auto const [it, inserted] = indices.try_emplace(region.name, modules_.size());
+			if (inserted)
+			{
+				modules_.push_back({region.name, begin});
+			}
+
+			module = it->second;
+		}
+		else if (!bss)
+		{
+			module = no_module;
+			continue;
+		}
+
+		module_end = end;
+
+		// Only a single anonymous region is taken, rather than a chain of mappings such as a malloc arena or a guard page and a thread stack.
+		module_permission = bss ? memory_permission::none : region.permissions;
+
+		if (!segments_.empty() && segments_.back().module == module && segments_.back().end == begin)
+		{
+			segments_.back().end = end;
+		}
+		else
+		{
+			segments_.push_back({begin, end, module});
+		}
+	}
+
+	std::vector<std::size_t> order(modules_.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::ranges::sort(order, {}, [this](std::size_t i) -> std::string const& { return modules_[i].name; });
+
+	std::vector<std::size_t>   new_indices(modules_.size());
+	std::vector<loaded_module> sorted_modules;
+	sorted_modules.reserve(modules_.size());
+
+	for (std::size_t i = 0; i < order.size(); ++i)
+	{
+		new_indices[order[i]] = i;
+		sorted_modules.push_back(std::move(modules_[order[i]]));
+	}
+
+	modules_ = std::move(sorted_modules);
+
+	for (auto& s : segments_)
+	{
+		s.module = new_indices[s.module];
+	}
+
+	std::ranges::sort(segments_, {}, &segment::begin);
+}
+
+auto module_table::modules() const noexcept -> std::vector<loaded_module> const&
+{
+	return modules_;
+}
+
+auto module_table::find(std::string_view name) const noexcept -> loaded_module const*
+{
+	auto const it = std::ranges::lower_bound(modules_, name, {}, [](loaded_module const& m) -> std::string_view { return m.name; });
+	if (it == modules_.end() || it->name != name)
+	{
+		return nullptr;
+	}
+
+	return &*it;
+}
+
+auto module_table::resolve(module_address const& addr) const noexcept -> std::optional<address_t>
+{
+	if (auto const* const m = find(addr.module))
+	{
+		return m->base + addr.offset;
+	}
+
+	return std::nullopt;
+}
+
+auto module_table::resolve(std::span<module_address const> addrs, std::span<address_t> out) const noexcept -> std::size_t
+{
+	std::size_t resolved = 0;
+
+	// Stored addresses tend to be grouped by module, so the last lookup is reused.
+	loaded_module const* m = nullptr;
+
+	for (std::size_t i = 0; i < addrs.size(); ++i)
+	{
+		auto const& addr = addrs[i];
+
+		if (!m || m->name != addr.module)
+		{
+			m = find(addr.module);
+		}
+
+		if (m)
+		{
+			out[i] = m->base + addr.offset;
+			++resolved;
+		}
+		else
+		{
+			out[i] = 0;
+		}
+	}
+
+	return resolved;
+}
+
+auto module_table::relativize(address_t addr) const -> std::optional<module_address>
+{
+	auto const it = std::ranges::upper_bound(segments_, addr, {}, &segment::begin);
+	if (it == segments_.begin() || addr >= std::prev(it)->end)
+	{
+		return std::nullopt;
+	}
+
+	auto const& m = modules_[std::prev(it)->module];
+
+	return module_address{m.name, addr - m.base};
+}
+}
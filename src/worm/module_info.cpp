@@ -0,0 +1,657 @@
+#include "platform.hpp"
+
+#include "worm/module_info.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <optional>
+#include <span>
+#include <tuple>
+
+#if defined(WORM_POSIX)
+
+#	include <cstring>
+
+#	include <elf.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+#	ifdef __cpp_lib_format
+#		include <format>
+#	else
+#		include <charconv>
+#	endif
+
+#endif
+
+namespace worm
+{
+namespace
+{
+#if defined(WORM_POSIX)
+/**
+ * @brief Make an error of a malformed or unsupported module file.
+ *
+ * @param[in] message error message
+ */
+[[nodiscard]]
+auto make_format_error(char const* message) -> std::system_error
+{
+	return std::system_error(std::make_error_code(std::errc::executable_format_error), message);
+}
+
+#	ifndef __cpp_lib_format
+/**
+ * @brief Format an address as a hexadecimal string.
+ *
+ * @param[in] addr address
+ */
+[[nodiscard]]
+auto to_hex(address_t addr) -> std::string
+{
+	char buffer[2 * sizeof(addr)];
+	return {buffer, std::to_chars(std::begin(buffer), std::end(buffer), addr, 16).ptr};
+}
+#	endif
+
+/// Owned file descriptor.
+struct file_descriptor
+{
+	int fd = -1;
+
+	explicit file_descriptor(int fd) noexcept
+		: fd{fd}
+	{}
+
+	file_descriptor(file_descriptor const&)                    = delete;
+	auto operator=(file_descriptor const&) -> file_descriptor& = delete;
+
+	~file_descriptor()
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+};
+
+/// Read-only mapping of a whole file.
+struct file_image
+{
+	std::span<unsigned char const> data;
+
+	/**
+	 * @brief Map a file.
+	 *
+	 * @param[in] fd file descriptor
+	 *
+	 * @throws `std::system_error` if could not map the file
+	 */
+	explicit file_image(int fd)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == -1)
+		{
+			throw make_system_error("failed to query module file");
+		}
+
+		if (st.st_size == 0)
+		{
+			throw make_format_error("empty module file");
+		}
+
+		void* const addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED)
+		{
+			throw make_system_error("failed to map module file");
+		}
+
+		data = {static_cast<unsigned char const*>(addr), static_cast<std::size_t>(st.st_size)};
+	}
+
+	file_image(file_image const&)                    = delete;
+	auto operator=(file_image const&) -> file_image& = delete;
+
+	~file_image()
+	{
+		munmap(const_cast<unsigned char*>(data.data()), data.size());
+	}
+};
+
+/// Types of 32-bit ELF files.
+struct elf32
+{
+	using ehdr = Elf32_Ehdr;
+	using phdr = Elf32_Phdr;
+	using shdr = Elf32_Shdr;
+	using sym  = Elf32_Sym;
+	using nhdr = Elf32_Nhdr;
+
+	[[nodiscard]]
+	static constexpr auto symbol_type(unsigned char info) noexcept -> unsigned char
+	{
+		return ELF32_ST_TYPE(info);
+	}
+};
+
+/// Types of 64-bit ELF files.
+struct elf64
+{
+	using ehdr = Elf64_Ehdr;
+	using phdr = Elf64_Phdr;
+	using shdr = Elf64_Shdr;
+	using sym  = Elf64_Sym;
+	using nhdr = Elf64_Nhdr;
+
+	[[nodiscard]]
+	static constexpr auto symbol_type(unsigned char info) noexcept -> unsigned char
+	{
+		return ELF64_ST_TYPE(info);
+	}
+};
+#endif
+}
+
+#if defined(WORM_POSIX)
+/// Parser of an ELF image.
+struct module_parser
+{
+	/// Image of the whole file.
+	std::span<unsigned char const> image;
+
+	/**
+	 * @brief Copy a structure out of the image.
+	 *
+	 * @param[in] offset offset of the structure in the image
+	 *
+	 * @throws `std::system_error` if the structure is out of bounds
+	 */
+	template <typename T>
+	[[nodiscard]]
+	auto read(std::size_t offset) const -> T
+	{
+		if (offset > image.size() || image.size() - offset < sizeof(T))
+		{
+			throw make_format_error("truncated ELF file");
+		}
+
+		T value;
+		std::memcpy(&value, image.data() + offset, sizeof(T));
+
+		return value;
+	}
+
+	/**
+	 * @brief Read a null-terminated string out of the image.
+	 *
+	 * @param[in] offset offset of the string in the image
+	 */
+	[[nodiscard]]
+	auto read_string(std::size_t offset) const -> std::string_view
+	{
+		if (offset >= image.size())
+		{
+			throw make_format_error("truncated ELF file");
+		}
+
+		auto const* const begin = reinterpret_cast<char const*>(image.data() + offset);
+		return {begin, strnlen(begin, image.size() - offset)};
+	}
+
+	/**
+	 * @brief Get class of the ELF file.
+	 *
+	 * @throws `std::system_error` if the image is not a supported ELF file
+	 */
+	[[nodiscard]]
+	auto elf_class() const -> unsigned char
+	{
+		auto const ident = read<std::array<unsigned char, EI_NIDENT>>(0);
+
+		if (std::memcmp(ident.data(), ELFMAG, SELFMAG))
+		{
+			throw make_format_error("not an ELF file");
+		}
+
+		if (ident[EI_DATA] != (std::endian::native == std::endian::little ? ELFDATA2LSB : ELFDATA2MSB))
+		{
+			throw make_format_error("unsupported ELF byte order");
+		}
+
+		if (ident[EI_CLASS] != ELFCLASS32 && ident[EI_CLASS] != ELFCLASS64)
+		{
+			throw make_format_error("unsupported ELF class");
+		}
+
+		return ident[EI_CLASS];
+	}
+
+	/**
+	 * @brief Get program headers.
+	 */
+	template <typename Elf>
+	[[nodiscard]]
+	auto program_headers() const -> std::vector<typename Elf::phdr>
+	{
+		auto const header = read<typename Elf::ehdr>(0);
+
+		std::vector<typename Elf::phdr> headers;
+		headers.reserve(header.e_phnum);
+
+		for (std::size_t i = 0; i < header.e_phnum; ++i)
+		{
+			headers.push_back(read<typename Elf::phdr>(header.e_phoff + i * header.e_phentsize));
+		}
+
+		return headers;
+	}
+
+	/**
+	 * @brief Get section headers.
+	 */
+	template <typename Elf>
+	[[nodiscard]]
+	auto section_headers() const -> std::vector<typename Elf::shdr>
+	{
+		auto const header = read<typename Elf::ehdr>(0);
+		if (!header.e_shoff)
+		{
+			return {};
+		}
+
+		// Large section counts are stored in the first section header.
+		std::size_t count = header.e_shnum;
+		if (!count)
+		{
+			count = read<typename Elf::shdr>(header.e_shoff).sh_size;
+		}
+
+		if (count > image.size() / sizeof(typename Elf::shdr))
+		{
+			throw make_format_error("truncated ELF file");
+		}
+
+		std::vector<typename Elf::shdr> headers;
+		headers.reserve(count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			headers.push_back(read<typename Elf::shdr>(header.e_shoff + i * header.e_shentsize));
+		}
+
+		return headers;
+	}
+
+	/**
+	 * @brief Get build ID of the file as a hexadecimal string.
+	 */
+	template <typename Elf>
+	[[nodiscard]]
+	auto build_id() const -> std::string
+	{
+		for (auto const& phdr : program_headers<Elf>())
+		{
+			if (phdr.p_type != PT_NOTE)
+			{
+				continue;
+			}
+
+			std::size_t const align = phdr.p_align == 8 ? 8 : 4;
+			auto const        pad   = [align](std::size_t size) { return (size + align - 1) / align * align; };
+
+			for (std::size_t offset = phdr.p_offset; offset + sizeof(typename Elf::nhdr) <= phdr.p_offset + phdr.p_filesz;)
+			{
+				auto const note = read<typename Elf::nhdr>(offset);
+
+				std::size_t const name_offset = offset + sizeof(note);
+				std::size_t const desc_offset = name_offset + pad(note.n_namesz);
+
+				if (note.n_type == NT_GNU_BUILD_ID && read_string(name_offset) == "GNU" && desc_offset + note.n_descsz <= image.size())
+				{
+					static constexpr char digits[] = "0123456789abcdef";
+
+					std::string id;
+					id.reserve(note.n_descsz * 2);
+
+					for (std::size_t i = 0; i < note.n_descsz; ++i)
+					{
+						id.push_back(digits[image[desc_offset + i] >> 4]);
+						id.push_back(digits[image[desc_offset + i] & 0xf]);
+					}
+
+					return id;
+				}
+
+				offset = desc_offset + pad(note.n_descsz);
+			}
+		}
+
+		return {};
+	}
+
+	/**
+	 * @brief Parse sections and symbols.
+	 *
+	 * @param[out] info metadata to fill in
+	 */
+	template <typename Elf>
+	auto parse(module_info& info) const -> void
+	{
+		info.build_id_ = build_id<Elf>();
+
+		address_t         image_base = -1;
+		std::size_t const page       = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+
+		for (auto const& phdr : program_headers<Elf>())
+		{
+			if (phdr.p_type == PT_LOAD)
+			{
+				image_base = std::min<address_t>(image_base, phdr.p_vaddr & ~static_cast<address_t>(page - 1));
+			}
+		}
+
+		if (image_base == static_cast<address_t>(-1))
+		{
+			image_base = 0;
+		}
+
+		auto const header   = read<typename Elf::ehdr>(0);
+		auto const sections = section_headers<Elf>();
+
+		std::size_t names_index = header.e_shstrndx;
+		if (names_index == SHN_XINDEX && !sections.empty())
+		{
+			names_index = sections.front().sh_link;
+		}
+
+		for (auto const& section : sections)
+		{
+			if (!(section.sh_flags & SHF_ALLOC) || section.sh_addr < image_base || names_index >= sections.size())
+			{
+				continue;
+			}
+
+			info.sections_.push_back({
+				std::string(read_string(sections[names_index].sh_offset + section.sh_name)),
+				section.sh_addr - image_base,
+				section.sh_size,
+			});
+		}
+
+		for (auto const& section : sections)
+		{
+			if ((section.sh_type != SHT_SYMTAB && section.sh_type != SHT_DYNSYM) || section.sh_link >= sections.size())
+			{
+				continue;
+			}
+
+			auto const&       names = sections[section.sh_link];
+			std::size_t const count = section.sh_size / sizeof(typename Elf::sym);
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				auto const symbol = read<typename Elf::sym>(section.sh_offset + i * sizeof(typename Elf::sym));
+
+				unsigned char const type = Elf::symbol_type(symbol.st_info);
+
+				bool const defined = symbol.st_shndx != SHN_UNDEF && symbol.st_shndx != SHN_ABS && symbol.st_value >= image_base;
+				bool const located = type == STT_FUNC || type == STT_OBJECT || type == STT_GNU_IFUNC || type == STT_NOTYPE;
+
+				if (!defined || !located || !symbol.st_name)
+				{
+					continue;
+				}
+
+				info.symbols_.push_back({
+					std::string(read_string(names.sh_offset + symbol.st_name)),
+					symbol.st_value - image_base,
+					symbol.st_size,
+				});
+			}
+		}
+
+		std::ranges::sort(info.sections_, {}, &module_section::offset);
+
+		// Dynamic symbols usually repeat ones of the full symbol table.
+		static constexpr auto key = [](module_symbol const& symbol) { return std::tie(symbol.offset, symbol.name); };
+
+		std::ranges::sort(info.symbols_, {}, key);
+		info.symbols_.erase(
+			std::ranges::unique(info.symbols_, {}, key).begin(),
+			info.symbols_.end()
+		);
+
+		info.symbols_by_name_.resize(info.symbols_.size());
+		for (std::size_t i = 0; i < info.symbols_.size(); ++i)
+		{
+			info.symbols_by_name_[i] = i;
+		}
+
+		std::ranges::stable_sort(info.symbols_by_name_, {}, [&](std::size_t i) -> std::string const& { return info.symbols_[i].name; });
+	}
+
+	/**
+	 * @brief Get build ID of the file as a hexadecimal string.
+	 */
+	[[nodiscard]]
+	auto build_id() const -> std::string
+	{
+		return elf_class() == ELFCLASS64 ? build_id<elf64>() : build_id<elf32>();
+	}
+
+	/**
+	 * @brief Parse metadata of the file.
+	 *
+	 * @param[in] path path to the file
+	 */
+	[[nodiscard]]
+	auto parse(std::string path) const -> module_info
+	{
+		module_info info;
+		info.path_ = std::move(path);
+
+		if (elf_class() == ELFCLASS64)
+		{
+			parse<elf64>(info);
+		}
+		else
+		{
+			parse<elf32>(info);
+		}
+
+		return info;
+	}
+};
+#endif
+
+auto module_info::load(std::string const& path) -> module_info
+{
+#if defined(WORM_POSIX)
+	file_descriptor const file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+	if (file.fd == -1)
+	{
+		throw make_system_error("failed to open module file");
+	}
+
+	file_image const image(file.fd);
+
+	return module_parser{image.data}.parse(path);
+#elif defined(WORM_WINDOWS)
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "module metadata is only supported for ELF files");
+#endif
+}
+
+auto module_info::path() const noexcept -> std::string const&
+{
+	return path_;
+}
+
+auto module_info::build_id() const noexcept -> std::string const&
+{
+	return build_id_;
+}
+
+auto module_info::sections() const noexcept -> std::vector<module_section> const&
+{
+	return sections_;
+}
+
+auto module_info::symbols() const noexcept -> std::vector<module_symbol> const&
+{
+	return symbols_;
+}
+
+auto module_info::find_section(std::string_view name) const noexcept -> module_section const*
+{
+	auto const it = std::ranges::find(sections_, name, &module_section::name);
+	return it == sections_.end() ? nullptr : &*it;
+}
+
+auto module_info::find_symbol(std::string_view name) const noexcept -> module_symbol const*
+{
+	auto const it = std::ranges::lower_bound(symbols_by_name_, name, {}, [this](std::size_t i) -> std::string_view { return symbols_[i].name; });
+	return it == symbols_by_name_.end() || symbols_[*it].name != name ? nullptr : &symbols_[*it];
+}
+
+auto module_info::symbolize(address_t offset) const noexcept -> module_symbol const*
+{
+	auto const it = std::ranges::upper_bound(symbols_, offset, {}, &module_symbol::offset);
+	if (it == symbols_.begin())
+	{
+		return nullptr;
+	}
+
+	auto const& symbol = *std::prev(it);
+	return offset - symbol.offset < std::max<std::size_t>(symbol.size, 1) ? &symbol : nullptr;
+}
+
+auto module_cache::global() noexcept -> module_cache&
+{
+	static module_cache cache;
+	return cache;
+}
+
+auto module_cache::get(pid_t pid, memory_region const& region) -> std::shared_ptr<module_info const>
+{
+#if defined(WORM_POSIX)
+	if (!region.inode || region.name.empty())
+	{
+		throw std::system_error(std::make_error_code(std::errc::invalid_argument), "region is not file-backed");
+	}
+
+	// The path is resolved in the mount namespace of the process, and the
+	// mapped file itself is used if the path now names another file.
+	std::string const paths[]{
+#	ifdef __cpp_lib_format
+		std::format("/proc/{}/root{}", pid, region.name),
+		std::format("/proc/{}/map_files/{:x}-{:x}", pid, region.range.front(), *region.range.end()),
+#	else
+		"/proc/" + std::to_string(pid) + "/root" + region.name,
+		"/proc/" + std::to_string(pid) + "/map_files/" + to_hex(region.range.front()) + '-' + to_hex(*region.range.end()),
+#	endif
+	};
+
+	std::optional<file_descriptor> file;
+	struct stat                    st;
+
+	for (auto const& path : paths)
+	{
+		file.emplace(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+
+		if (file->fd != -1 && fstat(file->fd, &st) != -1 && st.st_ino == region.inode)
+		{
+			break;
+		}
+
+		file.reset();
+	}
+
+	if (!file)
+	{
+		throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), "failed to open module file");
+	}
+
+	file_key const key{region.device, region.inode, st.st_mtim.tv_sec, st.st_mtim.tv_nsec};
+
+	{
+		std::scoped_lock lock(mutex_);
+
+		if (auto const it = by_file_.find(key); it != by_file_.end())
+		{
+			return it->second;
+		}
+	}
+
+	file_image const    image(file->fd);
+	module_parser const parser{image.data};
+
+	std::string build_id = parser.build_id();
+
+	if (!build_id.empty())
+	{
+		std::scoped_lock lock(mutex_);
+
+		if (auto const it = by_build_id_.find(build_id); it != by_build_id_.end())
+		{
+			return by_file_.try_emplace(key, it->second).first->second;
+		}
+	}
+
+	auto info = std::make_shared<module_info const>(parser.parse(region.name));
+
+	std::scoped_lock lock(mutex_);
+
+	// Another thread may have loaded the same file in the meantime.
+	if (!build_id.empty())
+	{
+		info = by_build_id_.try_emplace(std::move(build_id), std::move(info)).first->second;
+	}
+
+	return by_file_.try_emplace(key, std::move(info)).first->second;
+#elif defined(WORM_WINDOWS)
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "module metadata is only supported for ELF files");
+#endif
+}
+
+auto module_cache::get(pid_t pid, std::vector<memory_region> const& regions) -> std::map<std::string, std::shared_ptr<module_info const>, std::less<>>
+{
+	std::map<std::string, std::shared_ptr<module_info const>, std::less<>> infos;
+
+	for (auto const& region : regions)
+	{
+		if (!region.inode || region.name.empty() || infos.contains(region.name))
+		{
+			continue;
+		}
+
+		try
+		{
+			infos.emplace(region.name, get(pid, region));
+		}
+		catch (std::system_error const&)
+		{
+			infos.emplace(region.name, nullptr);
+		}
+	}
+
+	std::erase_if(infos, [](auto const& entry) { return !entry.second; });
+
+	return infos;
+}
+
+auto module_cache::size() const -> std::size_t
+{
+	std::scoped_lock lock(mutex_);
+	return by_file_.size();
+}
+
+auto module_cache::clear() -> void
+{
+	std::scoped_lock lock(mutex_);
+	by_file_.clear();
+	by_build_id_.clear();
+}
+}
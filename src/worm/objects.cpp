@@ -0,0 +1,481 @@
+#include "platform.hpp"
+#include "probes.hpp"
+
+#include "worm/module_info.hpp"
+#include "worm/objects.hpp"
+#include "worm/region_reader.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+#if __has_include(<cxxabi.h>)
+#	include <cxxabi.h>
+#	define WORM_HAVE_CXXABI
+#endif
+
+namespace worm
+{
+namespace
+{
+/// Size of a vtable slot.
+constexpr std::size_t word_size = sizeof(address_t);
+
+/// Sections that vtables are placed into.
+constexpr std::string_view vtable_sections[] = {".data.rel.ro", ".data.rel.ro.local", ".rodata"};
+
+/// Maximum number of bytes in a type name.
+constexpr std::size_t max_name_size = 256;
+
+/// Maximum number of bytes of a vtable symbol searched for its address point.
+constexpr std::size_t max_vtable_size = 1 << 12;
+
+/// Set of address ranges.
+struct range_set
+{
+	/// Sorted non-overlapping ranges.
+	std::vector<address_range> ranges;
+
+	/**
+	 * @brief Collect ranges of regions with a permission.
+	 *
+	 * @param[in] regions    memory regions sorted by address
+	 * @param[in] permission required permission
+	 */
+	range_set(std::vector<memory_region> const& regions, memory_permission permission)
+	{
+		for (auto const& region : regions)
+		{
+			if (static_cast<bool>(region.permissions & permission) && !region.range.empty())
+			{
+				ranges.push_back(region.range);
+			}
+		}
+	}
+
+	[[nodiscard]]
+	auto contains(address_t addr) const noexcept -> bool
+	{
+		auto const it = std::ranges::upper_bound(ranges, addr, {}, [](auto const& r) { return r.front(); });
+		return it != ranges.begin() && addr < *std::prev(it)->end();
+	}
+};
+
+/// Vtable found in a module.
+struct vtable
+{
+	/// Address point.
+	address_t address_point;
+
+	/// Address of type information, or `0` if the module has none.
+	address_t typeinfo;
+
+	/// Name of the vtable symbol, or an empty string if it is unknown.
+	std::string symbol;
+
+	/// Demangled type name, or an empty string if it is unknown.
+	std::string name;
+};
+
+/**
+ * @brief Demangle a type name.
+ *
+ * @param[in] name mangled type name, as in `std::type_info::name`
+ *
+ * @return demangled name, or the mangled one if it could not be demangled
+ */
+[[nodiscard]]
+auto demangle(std::string_view name) -> std::string
+{
+	// Types with internal linkage are marked to be compared by address.
+	if (name.starts_with('*'))
+	{
+		name.remove_prefix(1);
+	}
+
+	std::string mangled(name);
+
+#ifdef WORM_HAVE_CXXABI
+	int status = 0;
+
+	std::unique_ptr<char, decltype(&std::free)> const demangled{
+		abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status),
+		&std::free,
+	};
+
+	if (status == 0 && demangled)
+	{
+		return demangled.get();
+	}
+#endif
+
+	return mangled;
+}
+
+/**
+ * @brief Check whether a string looks like a mangled type name.
+ *
+ * @param[in] name string
+ */
+[[nodiscard]]
+auto is_type_name(std::string_view name) noexcept -> bool
+{
+	if (name.starts_with('*'))
+	{
+		name.remove_prefix(1);
+	}
+
+	return !name.empty() && std::ranges::all_of(
+		name,
+		[](char c) { return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '.' || c == '$'; }
+	);
+}
+
+/**
+ * @brief Find address points of vtables by their layout.
+ *
+ * @param[in]  words      words of a section
+ * @param[in]  base       address of the first word
+ * @param[in]  executable executable ranges
+ * @param[in]  readable   readable ranges
+ * @param[in]  rtti       whether to only look for vtables with type information
+ * @param[out] out        found vtables
+ */
+auto find_address_points(
+	std::span<address_t const> words,
+	address_t                  base,
+	range_set const&           executable,
+	range_set const&           readable,
+	bool                       rtti,
+	std::vector<vtable>&       out
+) -> void
+{
+	for (std::size_t i = 0; i + 3 <= words.size(); ++i)
+	{
+		address_t const offset_to_top = words[i];
+		address_t const typeinfo      = words[i + 1];
+		address_t const function      = words[i + 2];
+
+		if (offset_to_top != 0 || ((rtti || typeinfo) && !readable.contains(typeinfo)) || !executable.contains(function))
+		{
+			continue;
+		}
+
+		out.push_back({base + (i + 2) * word_size, typeinfo, {}, {}});
+	}
+}
+
+/**
+ * @brief Read type information of vtables, and drop vtables whose type information is not genuine.
+ *
+ * @param[in]     h             handle
+ * @param[in]     readable      readable ranges
+ * @param[in]     resolve_names whether to read type names
+ * @param[in,out] vtables       vtables
+ */
+template <handle_mode Mode>
+auto resolve_typeinfo(handle<Mode> const& h, range_set const& readable, bool resolve_names, std::vector<vtable>& vtables) -> void
+{
+	// Type information starts with a vtable pointer and a pointer to the type name.
+	std::vector<std::array<address_t, 2>> heads(vtables.size());
+	std::vector<memory_transfer>          transfers;
+
+	for (std::size_t i = 0; i < vtables.size(); ++i)
+	{
+		transfers.push_back({vtables[i].typeinfo, heads[i].data(), vtables[i].typeinfo ? sizeof(heads[i]) : 0});
+	}
+
+	h.read_bytes(transfers);
+
+	std::vector<bool> genuine(vtables.size());
+	for (std::size_t i = 0; i < vtables.size(); ++i)
+	{
+		genuine[i] = vtables[i].typeinfo == 0 || (transfers[i].transferred == sizeof(heads[i]) && readable.contains(heads[i][0]) && readable.contains(heads[i][1]));
+	}
+
+	if (resolve_names)
+	{
+		std::vector<char> names(vtables.size() * max_name_size);
+
+		transfers.clear();
+		for (std::size_t i = 0; i < vtables.size(); ++i)
+		{
+			transfers.push_back({genuine[i] && vtables[i].typeinfo ? heads[i][1] : 0, names.data() + i * max_name_size, genuine[i] && vtables[i].typeinfo ? max_name_size : 0});
+		}
+
+		h.read_bytes(transfers);
+
+		for (std::size_t i = 0; i < vtables.size(); ++i)
+		{
+			if (!vtables[i].typeinfo)
+			{
+				if (vtables[i].symbol.starts_with("_ZTV"))
+				{
+					vtables[i].name = demangle(std::string_view(vtables[i].symbol).substr(4));
+				}
+
+				continue;
+			}
+
+			std::string_view const raw(names.data() + i * max_name_size, transfers[i].transferred);
+			std::string_view const name = raw.substr(0, raw.find('\0'));
+
+			if (name.size() == raw.size() || !is_type_name(name))
+			{
+				genuine[i] = false;
+				continue;
+			}
+
+			vtables[i].name = demangle(name);
+		}
+	}
+
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < vtables.size(); ++i)
+	{
+		if (genuine[i] && kept++ != i)
+		{
+			vtables[kept - 1] = std::move(vtables[i]);
+		}
+	}
+
+	vtables.resize(kept);
+}
+
+/**
+ * @brief Find vtables of loaded modules.
+ *
+ * @param[in] h             handle
+ * @param[in] regions       memory regions sorted by address
+ * @param[in] table         module table
+ * @param[in] resolve_names whether to read type names
+ *
+ * @return vtables sorted by address point
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto find_vtables(handle<Mode> const& h, std::vector<memory_region> const& regions, module_table const& table, bool resolve_names)
+	-> std::vector<vtable>
+{
+	range_set const executable(regions, memory_permission::execute);
+	range_set const readable(regions, memory_permission::read);
+
+	std::vector<vtable>    vtables;
+	std::vector<address_t> words;
+
+	for (auto const& [name, info] : module_cache::global().get(h.pid(), regions))
+	{
+		auto const* module = table.find(name);
+		if (!module)
+		{
+			continue;
+		}
+
+		for (auto const section_name : vtable_sections)
+		{
+			auto const* section = info->find_section(section_name);
+			if (!section)
+			{
+				continue;
+			}
+
+			// Sections are read from memory rather than from the file, so that pointers are relocated.
+			address_t const begin = (module->base + section->offset + word_size - 1) / word_size * word_size;
+			address_t const end   = module->base + section->offset + section->size;
+			if (end <= begin)
+			{
+				continue;
+			}
+
+			words.resize((end - begin) / word_size);
+
+			std::size_t read = 0;
+			try
+			{
+				read = h.read_bytes(begin, words.data(), words.size() * word_size);
+			}
+			catch (std::system_error const&)
+			{
+				continue;
+			}
+
+			find_address_points({words.data(), read / word_size}, begin, executable, readable, true, vtables);
+		}
+
+		// Vtables of modules built without type information can only be told apart by their symbols.
+		std::vector<module_symbol const*> symbols;
+		for (auto const& symbol : info->symbols())
+		{
+			if (symbol.name.starts_with("_ZTV") && symbol.size >= 3 * word_size)
+			{
+				symbols.push_back(&symbol);
+			}
+		}
+
+		std::vector<memory_transfer> transfers;
+		std::size_t                  total = 0;
+
+		for (auto const* symbol : symbols)
+		{
+			total += std::min(symbol->size, max_vtable_size) / word_size;
+		}
+
+		words.resize(total);
+		total = 0;
+
+		for (auto const* symbol : symbols)
+		{
+			std::size_t const size = std::min(symbol->size, max_vtable_size) / word_size;
+
+			transfers.push_back({module->base + symbol->offset, words.data() + total, size * word_size});
+			total += size;
+		}
+
+		h.read_bytes(transfers);
+
+		std::vector<vtable> found;
+		total = 0;
+
+		for (std::size_t i = 0; i < symbols.size(); ++i)
+		{
+			found.clear();
+			find_address_points(
+				{words.data() + total, transfers[i].transferred / word_size},
+				transfers[i].address,
+				executable,
+				readable,
+				false,
+				found
+			);
+
+			total += transfers[i].size / word_size;
+
+			if (!found.empty())
+			{
+				found.front().symbol = symbols[i]->name;
+				vtables.push_back(std::move(found.front()));
+			}
+		}
+	}
+
+	std::ranges::sort(vtables, {}, &vtable::address_point);
+	vtables.erase(std::ranges::unique(vtables, {}, &vtable::address_point).begin(), vtables.end());
+
+	resolve_typeinfo(h, readable, resolve_names, vtables);
+
+	return vtables;
+}
+}
+
+template <handle_mode Mode>
+auto find_objects(handle<Mode> const& h, std::vector<memory_region> const& regions, object_scan_options const& options)
+	-> std::vector<object_group>
+	requires handle<Mode>::readable
+{
+	module_table const table(regions);
+
+	auto vtables = find_vtables(h, regions, table, options.resolve_names);
+	if (vtables.empty())
+	{
+		return {};
+	}
+
+	std::vector<address_t> points;
+	points.reserve(vtables.size());
+
+	for (auto const& v : vtables)
+	{
+		points.push_back(v.address_point);
+	}
+
+	address_t const lowest  = points.front();
+	address_t const highest = points.back();
+
+	std::vector<address_range> ranges;
+	for (auto const& region : regions)
+	{
+		bool const readable = static_cast<bool>(region.permissions & memory_permission::read);
+		bool const writable = static_cast<bool>(region.permissions & memory_permission::write);
+
+		if (readable && (writable || !options.writable_only) && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	std::vector<std::vector<address_t>> objects(vtables.size());
+
+	region_reader<Mode> reader(h, std::move(ranges), {.chunk_size = std::max(options.chunk_size / word_size * word_size, word_size)});
+
+	while (auto const chunk = reader.next())
+	{
+		WORM_PROBE(object_chunk__entry, h.pid(), chunk->address, chunk->data.size());
+
+		std::size_t matches = 0;
+
+		// Regions are page-aligned, and so are chunks, so that words are aligned.
+		std::size_t const count = chunk->data.size() / word_size;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			address_t word;
+			std::memcpy(&word, chunk->data.data() + i * word_size, word_size);
+
+			// Almost all words are outside of the span of vtables.
+			if (word - lowest > highest - lowest)
+			{
+				continue;
+			}
+
+			auto const it = std::ranges::lower_bound(points, word);
+			if (*it == word)
+			{
+				objects[static_cast<std::size_t>(it - points.begin())].push_back(chunk->address + i * word_size);
+				++matches;
+			}
+		}
+
+		WORM_PROBE(object_chunk__return, h.pid(), chunk->address, chunk->data.size(), matches);
+	}
+
+	std::vector<object_group> groups;
+
+	for (std::size_t i = 0; i < vtables.size(); ++i)
+	{
+		if (objects[i].empty())
+		{
+			continue;
+		}
+
+		groups.push_back({
+			.vtable   = vtables[i].address_point,
+			.location = table.relativize(vtables[i].address_point).value_or(module_address{}),
+			.name     = std::move(vtables[i].name),
+			.objects  = std::move(objects[i]),
+		});
+	}
+
+	return groups;
+}
+
+template <handle_mode Mode>
+auto find_objects(handle<Mode> const& h, object_scan_options const& options) -> std::vector<object_group>
+	requires handle<Mode>::readable
+{
+	return find_objects(h, h.regions(), options);
+}
+
+template auto find_objects(handle<handle_mode::in> const&, std::vector<memory_region> const&, object_scan_options const&) -> std::vector<object_group>;
+template auto find_objects(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, object_scan_options const&)
+	-> std::vector<object_group>;
+
+template auto find_objects(handle<handle_mode::in> const&, object_scan_options const&) -> std::vector<object_group>;
+template auto find_objects(handle<handle_mode::in | handle_mode::out> const&, object_scan_options const&) -> std::vector<object_group>;
+}
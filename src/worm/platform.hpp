@@ -0,0 +1,129 @@
+#ifndef WORM_PLATFORM_HPP
+#define WORM_PLATFORM_HPP
+
+#if !defined(WORM_POSIX) && !defined(WORM_WINDOWS)
+
+#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
+#	define WORM_POSIX
+#elif defined(_WIN32)
+#	define WORM_WINDOWS
+#else
+#	error unsupported target operating system
+#endif
+
+#endif
+
+#include "worm/worm.hpp"
+
+#include <algorithm>
+#include <system_error>
+
+#if defined(WORM_POSIX)
+
+#	define WORM_ERRNO (errno)
+
+#	include <cerrno>
+#	include <charconv>
+#	include <string_view>
+
+#	include <sys/uio.h>
+
+#elif defined(WORM_WINDOWS)
+
+#	define WORM_ERRNO (static_cast<int>(GetLastError()))
+
+#	define WIN32_LEAN_AND_MEAN
+
+#	include <processthreadsapi.h>
+#	include <errhandlingapi.h>
+#	include <stringapiset.h>
+#	include <libloaderapi.h>
+#	include <handleapi.h>
+#	include <memoryapi.h>
+#	include <minwindef.h>
+#	include <winnls.h>
+#	include <psapi.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+[[nodiscard]]
+inline auto make_system_error(char const* what_arg) noexcept -> std::system_error
+{
+	return {
+		{WORM_ERRNO, std::system_category()},
+		what_arg
+	};
+}
+
+#ifdef WORM_POSIX
+/**
+ * @brief Extract next whitespace-delimited column from a row.
+ *
+ * @param[in,out] row row to extract the column from, advanced past the column
+ */
+[[nodiscard]]
+inline auto next_column(std::string_view& row) noexcept -> std::string_view
+{
+	static constexpr char column_delim = ' ';
+
+	row.remove_prefix(std::min(row.find_first_not_of(column_delim), row.size()));
+
+	std::string_view const column = row.substr(0, row.find(column_delim));
+	row.remove_prefix(column.size());
+
+	return column;
+}
+
+/**
+ * @brief Parse a hexadecimal address.
+ *
+ * @param[in] str string to parse
+ */
+[[nodiscard]]
+inline auto parse_address(std::string_view str) noexcept -> address_t
+{
+	address_t addr = 0;
+	std::from_chars(str.data(), str.data() + str.size(), addr, 16);
+	return addr;
+}
+#endif
+}
+
+template <handle_mode Mode>
+struct handle<Mode>::system_handle
+{
+	using handle_type = handle<Mode>;
+
+#ifdef WORM_WINDOWS
+	void* handle{};
+
+	explicit system_handle(pid_t pid)
+		: handle{OpenProcess(
+			  (handle_type::readable ? PROCESS_VM_READ | PROCESS_QUERY_LIMITED_INFORMATION : 0) |
+				  (handle_type::writable ? PROCESS_VM_OPERATION | PROCESS_VM_WRITE : 0),
+			  false,
+			  pid
+		  )}
+	{
+		if (!handle)
+		{
+			throw make_system_error("failed to open a process handle");
+		}
+	}
+
+	~system_handle()
+	{
+		CloseHandle(handle);
+	}
+#elif defined(WORM_POSIX)
+	explicit system_handle(pid_t) noexcept
+	{}
+#endif
+};
+}
+
+#endif
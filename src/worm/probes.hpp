@@ -0,0 +1,33 @@
+#ifndef WORM_PROBES_HPP
+#define WORM_PROBES_HPP
+
+/**
+ * @brief Fire a USDT probe of the `worm` provider.
+ *
+ * Probes are compiled into ELF notes and cost a single `nop` unless attached
+ * to, for example with `perf` or `bpftrace`. Without `WORM_USDT` they are
+ * compiled out entirely.
+ *
+ * @param name probe name, which is stored as written, e.g. `read_bytes__entry`
+ * @param ...  integer or pointer probe arguments
+ */
+#ifdef WORM_USDT
+#	include <sys/sdt.h>
+#	define WORM_PROBE(name, ...) STAP_PROBEV(worm, name, __VA_ARGS__)
+#else
+#	define WORM_PROBE(name, ...) ::worm::ignore_probe(__VA_ARGS__)
+#endif
+
+namespace worm
+{
+/**
+ * @brief Discard arguments of a compiled out probe.
+ *
+ * It keeps arguments that are computed only for probes used.
+ */
+template <typename... Args>
+constexpr auto ignore_probe(Args const&...) noexcept -> void
+{}
+}
+
+#endif
@@ -0,0 +1,325 @@
+#include "platform.hpp"
+#include "probes.hpp"
+
+#include "worm/read_planner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+#if defined(WORM_POSIX)
+#	include <climits>
+#endif
+
+namespace worm
+{
+namespace
+{
+/// Gap threshold used when it could not be measured.
+constexpr std::size_t default_gap_threshold = 1 << 10;
+
+/// Bounds of a measured gap threshold.
+constexpr std::size_t min_gap_threshold = 1 << 6;
+constexpr std::size_t max_gap_threshold = 1 << 16;
+
+/// Number of pieces read to measure the cost of a vector element.
+constexpr std::size_t calibration_pieces = 256;
+
+/// Number of bytes between pieces read to measure the cost of a vector element.
+constexpr std::size_t calibration_stride = 1 << 10;
+
+/// Number of repetitions of each measurement, of which the fastest is taken.
+constexpr std::size_t calibration_rounds = 5;
+
+/// Sentinel for transfers outside of known regions.
+constexpr std::size_t no_range = static_cast<std::size_t>(-1);
+
+/**
+ * @brief Get maximum number of transfers in a single system call.
+ */
+[[nodiscard]]
+constexpr auto max_batch() noexcept -> std::size_t
+{
+#if defined(WORM_POSIX)
+	return IOV_MAX;
+#else
+	return 1;
+#endif
+}
+
+/**
+ * @brief Get ranges of readable regions.
+ *
+ * @param[in] regions memory regions
+ */
+[[nodiscard]]
+auto readable_ranges(std::vector<memory_region> const& regions) -> std::vector<address_range>
+{
+	std::vector<address_range> ranges;
+
+	for (auto const& region : regions)
+	{
+		if (static_cast<bool>(region.permissions & memory_permission::read) && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	std::ranges::sort(ranges, {}, [](auto const& r) { return r.front(); });
+
+	return ranges;
+}
+
+/**
+ * @brief Measure the gap that costs as much to read through as another vector element.
+ *
+ * @param[in] h      handle
+ * @param[in] ranges readable ranges
+ */
+template <handle_mode Mode>
+[[nodiscard]]
+auto measure_gap_threshold(handle<Mode> const& h, std::vector<address_range> const& ranges) -> std::size_t
+{
+	using clock = std::chrono::steady_clock;
+
+	std::size_t const span = calibration_pieces * calibration_stride;
+
+	auto const largest = std::ranges::max_element(ranges, {}, [](auto const& r) { return r.size(); });
+	if (largest == ranges.end() || largest->size() < span)
+	{
+		return default_gap_threshold;
+	}
+
+	address_t const base = largest->front();
+
+	std::vector<unsigned char>   buffer(span);
+	std::vector<memory_transfer> pieces;
+
+	for (std::size_t i = 0; i < calibration_pieces; ++i)
+	{
+		pieces.push_back({base + i * calibration_stride, buffer.data() + i * sizeof(address_t), sizeof(address_t)});
+	}
+
+	auto sparse = clock::duration::max();
+	auto dense  = clock::duration::max();
+
+	try
+	{
+		for (std::size_t round = 0; round < calibration_rounds; ++round)
+		{
+			auto const start = clock::now();
+			if (h.read_bytes(pieces) != calibration_pieces * sizeof(address_t))
+			{
+				return default_gap_threshold;
+			}
+
+			auto const middle = clock::now();
+			if (h.read_bytes(base, buffer.data(), span) != span)
+			{
+				return default_gap_threshold;
+			}
+
+			auto const end = clock::now();
+
+			sparse = std::min(sparse, middle - start);
+			dense  = std::min(dense, end - middle);
+		}
+	}
+	catch (std::system_error const&)
+	{
+		return default_gap_threshold;
+	}
+
+	// Gap at which an element costs as much as the bytes it skips.
+	double const per_piece = std::chrono::duration<double>(sparse).count() / calibration_pieces;
+	double const per_byte  = std::chrono::duration<double>(dense).count() / span;
+
+	if (per_byte <= 0)
+	{
+		return max_gap_threshold;
+	}
+
+	return std::clamp(static_cast<std::size_t>(per_piece / per_byte), min_gap_threshold, max_gap_threshold);
+}
+}
+
+template <handle_mode Mode>
+read_planner<Mode>::read_planner(handle_type const& h, std::vector<memory_region> const& regions, read_planner_options const& options)
+	requires(handle_type::readable)
+	: h_{&h}
+	, gap_threshold_{0}
+	, max_read_size_{std::max<std::size_t>(options.max_read_size, 1)}
+	, ranges_{readable_ranges(regions)}
+{
+	gap_threshold_ = options.gap_threshold ? *options.gap_threshold : measure_gap_threshold(h, ranges_);
+}
+
+template <handle_mode Mode>
+read_planner<Mode>::read_planner(handle_type const& h, read_planner_options const& options)
+	requires(handle_type::readable)
+	: read_planner(h, h.regions(), options)
+{}
+
+template <handle_mode Mode>
+auto read_planner<Mode>::update_regions(std::vector<memory_region> const& regions) -> void
+{
+	ranges_ = readable_ranges(regions);
+}
+
+template <handle_mode Mode>
+auto read_planner<Mode>::gap_threshold() const noexcept -> std::size_t
+{
+	return gap_threshold_;
+}
+
+template <handle_mode Mode>
+auto read_planner<Mode>::plan(std::span<memory_transfer const> transfers) const -> read_plan
+{
+	read_plan plan;
+
+	plan.order.resize(transfers.size());
+	std::iota(plan.order.begin(), plan.order.end(), std::size_t{0});
+
+	std::ranges::sort(plan.order, {}, [&](std::size_t i) { return transfers[i].address; });
+
+	// Index of the range that wholly contains a transfer.
+	auto const range_of = [&](memory_transfer const& t) -> std::size_t
+	{
+		auto const it = std::ranges::upper_bound(ranges_, t.address, {}, [](auto const& r) { return r.front(); });
+		if (it == ranges_.begin())
+		{
+			return no_range;
+		}
+
+		auto const& range = *std::prev(it);
+		return t.address + t.size <= *range.end() ? static_cast<std::size_t>(std::prev(it) - ranges_.begin()) : no_range;
+	};
+
+	std::size_t current_range = no_range;
+
+	for (std::size_t k = 0; k < plan.order.size(); ++k)
+	{
+		auto const& t = transfers[plan.order[k]];
+
+		std::size_t const range = range_of(t);
+		address_t const   end   = t.address + t.size;
+
+		if (!plan.reads.empty() && range != no_range && range == current_range)
+		{
+			auto& read = plan.reads.back();
+
+			address_t const read_end   = read.address + read.size;
+			address_t const merged_end = std::max(read_end, end);
+
+			if (t.address <= read_end + gap_threshold_ && merged_end - read.address <= max_read_size_)
+			{
+				read.size = merged_end - read.address;
+				++read.count;
+				continue;
+			}
+		}
+
+		plan.reads.push_back({t.address, t.size, k, 1});
+		current_range = range;
+	}
+
+	for (auto const& read : plan.reads)
+	{
+		plan.bytes += read.size;
+	}
+
+	plan.calls = (plan.reads.size() + max_batch() - 1) / max_batch();
+
+	return plan;
+}
+
+template <handle_mode Mode>
+auto read_planner<Mode>::read(read_plan const& plan, std::span<memory_transfer> transfers) const -> std::size_t
+{
+	WORM_PROBE(read_plan__entry, h_->pid(), transfers.size(), plan.reads.size(), plan.bytes);
+
+	// Merged reads go through a staging buffer, while single ones go straight into their transfers.
+	std::size_t staging_size = 0;
+	for (auto const& read : plan.reads)
+	{
+		if (read.count > 1)
+		{
+			staging_size += read.size;
+		}
+	}
+
+	std::vector<unsigned char>   staging(staging_size);
+	std::vector<memory_transfer> reads;
+	reads.reserve(plan.reads.size());
+
+	std::size_t offset = 0;
+
+	for (auto const& read : plan.reads)
+	{
+		if (read.count == 1)
+		{
+			auto const& t = transfers[plan.order[read.first]];
+			reads.push_back({t.address, t.buffer, t.size});
+		}
+		else
+		{
+			reads.push_back({read.address, staging.data() + offset, read.size});
+			offset += read.size;
+		}
+	}
+
+	try
+	{
+		h_->read_bytes(reads);
+	}
+	catch (std::system_error const&)
+	{
+		WORM_PROBE(read_plan__return, h_->pid(), transfers.size(), plan.reads.size(), -1);
+
+		throw;
+	}
+
+	std::size_t total = 0;
+	offset            = 0;
+
+	for (std::size_t r = 0; r < plan.reads.size(); ++r)
+	{
+		auto const& read = plan.reads[r];
+
+		if (read.count == 1)
+		{
+			transfers[plan.order[read.first]].transferred = reads[r].transferred;
+			total += reads[r].transferred;
+			continue;
+		}
+
+		for (std::size_t k = read.first; k < read.first + read.count; ++k)
+		{
+			auto& t = transfers[plan.order[k]];
+
+			std::size_t const start = t.address - read.address;
+
+			t.transferred = reads[r].transferred > start ? std::min(t.size, reads[r].transferred - start) : 0;
+			std::memcpy(t.buffer, staging.data() + offset + start, t.transferred);
+
+			total += t.transferred;
+		}
+
+		offset += read.size;
+	}
+
+	WORM_PROBE(read_plan__return, h_->pid(), transfers.size(), plan.reads.size(), total);
+
+	return total;
+}
+
+template <handle_mode Mode>
+auto read_planner<Mode>::read(std::span<memory_transfer> transfers) const -> std::size_t
+{
+	return read(plan(transfers), transfers);
+}
+
+template struct read_planner<handle_mode::in>;
+template struct read_planner<handle_mode::in | handle_mode::out>;
+}
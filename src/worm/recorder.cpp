@@ -0,0 +1,589 @@
+#include "worm/recorder.hpp"
+
+#include "platform.hpp"
+#include "probes.hpp"
+#include "simd.hpp"
+#include "soft_dirty.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(WORM_POSIX) && defined(__linux__)
+
+#	include <atomic>
+#	include <condition_variable>
+#	include <mutex>
+#	include <shared_mutex>
+#	include <thread>
+#	include <unordered_map>
+
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+/// Header of a log.
+struct log_header
+{
+	/// Magic bytes, `WORMREC` followed by a version byte.
+	char          magic[8];
+	std::uint64_t page_size;
+};
+
+/// Header of a frame in a log, followed by its pages.
+struct frame_header
+{
+	/// Time of the capture in nanoseconds since the epoch.
+	std::int64_t  time;
+	std::uint64_t frame;
+	std::uint64_t pages;
+};
+
+/// Header of a page in a log, followed by its contents.
+struct page_header
+{
+	std::uint64_t address;
+};
+
+/// Magic bytes of a log.
+constexpr char log_magic[8] = {'W', 'O', 'R', 'M', 'R', 'E', 'C', 1};
+
+/// Maximum number of pages read at once.
+constexpr std::size_t batch_pages = 256;
+
+/// Logged version of a page.
+struct page_version
+{
+	/// Index of the frame that logged the version.
+	std::uint64_t frame;
+
+	/// Offset of the contents in the log.
+	std::uint64_t offset;
+};
+#endif
+}
+
+#if defined(WORM_POSIX) && defined(__linux__)
+template <handle_mode Mode>
+struct recorder<Mode>::state
+{
+	state(handle_type const& h, std::vector<memory_region> const& regions, recorder_options const& options)
+		: h{h}
+		, interval{options.interval}
+		, resync_frames{options.resync_frames}
+		, page_size{soft_dirty_tracker::page_size()}
+	{
+		for (auto const& region : regions)
+		{
+			if (static_cast<bool>(region.permissions & memory_permission::read) && !region.range.empty())
+			{
+				address_t const begin = region.range.front() / page_size * page_size;
+				address_t const end   = (region.range.back() / page_size + 1) * page_size;
+
+				ranges.push_back({begin, end});
+			}
+		}
+
+		if (options.soft_dirty)
+		{
+			try
+			{
+				tracker.emplace(h.pid());
+				soft_dirty = true;
+			}
+			catch (std::system_error const&)
+			{}
+		}
+
+		open_log(options.path, options.capacity);
+
+		try
+		{
+			capture();
+		}
+		catch (...)
+		{
+			close_log();
+			throw;
+		}
+
+		if (interval.count() > 0)
+		{
+			capturer = std::thread(&state::run, this);
+		}
+	}
+
+	state(state const&)                    = delete;
+	auto operator=(state const&) -> state& = delete;
+
+	~state()
+	{
+		{
+			std::scoped_lock lock(stop_mutex);
+			stopped = true;
+		}
+
+		stop_cv.notify_all();
+
+		if (capturer.joinable())
+		{
+			capturer.join();
+		}
+
+		close_log();
+	}
+
+	/**
+	 * @brief Create and map a log.
+	 *
+	 * @param[in] path     path of the log file, or an empty string for a memory file
+	 * @param[in] capacity maximum number of bytes in the log
+	 *
+	 * @throws `std::system_error` if could not create or map the log
+	 */
+	auto open_log(std::string const& path, std::size_t capacity) -> void
+	{
+		capacity = std::max(capacity, sizeof(log_header)) + page_size - 1;
+		capacity = capacity / page_size * page_size;
+
+		fd = path.empty() ? memfd_create("worm-recording", MFD_CLOEXEC) : open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+		if (fd < 0)
+		{
+			throw make_system_error("failed to create recording log");
+		}
+
+		// The file is sparse, so that the capacity is only reserved.
+		if (ftruncate(fd, static_cast<off_t>(capacity)) < 0)
+		{
+			close(fd);
+			throw make_system_error("failed to resize recording log");
+		}
+
+		void* const mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			close(fd);
+			throw make_system_error("failed to map recording log");
+		}
+
+		log      = static_cast<unsigned char*>(mapping);
+		log_end  = capacity;
+		log_used = sizeof(log_header);
+
+		log_header header{};
+		std::memcpy(header.magic, log_magic, sizeof(log_magic));
+		header.page_size = page_size;
+		std::memcpy(log, &header, sizeof(header));
+	}
+
+	/**
+	 * @brief Unmap a log, and truncate its file to the used bytes.
+	 */
+	auto close_log() noexcept -> void
+	{
+		munmap(log, log_end);
+
+		if (ftruncate(fd, static_cast<off_t>(log_used)) < 0)
+		{}
+
+		close(fd);
+	}
+
+	/// Capture frames until stopped or the log is full.
+	auto run() noexcept -> void
+	{
+		auto deadline = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			// Deadlines advance by whole intervals, so that captures do not drift, and missed ones are skipped.
+			auto const now = std::chrono::steady_clock::now();
+			do
+			{
+				deadline += interval;
+			} while (deadline <= now);
+
+			{
+				std::unique_lock lock(stop_mutex);
+				if (stop_cv.wait_until(lock, deadline, [this] { return stopped; }))
+				{
+					return;
+				}
+			}
+
+			try
+			{
+				capture();
+			}
+			catch (std::system_error const& e)
+			{
+				if (e.code() == std::errc::no_space_on_device)
+				{
+					return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Find candidate pages of a frame.
+	 *
+	 * Soft-dirty bits are cleared before pages are read, so that writes during
+	 * the capture are seen by the next one.
+	 */
+	auto candidate_pages() -> void
+	{
+		candidates.clear();
+
+		// Resyncs record pages whose writes the bits missed.
+		bool const all = frame_count == 0 || !tracker || (resync_frames && frame_count % resync_frames == 0);
+
+		if (tracker)
+		{
+			for (auto const& [begin, end] : ranges)
+			{
+				tracker->dirty_pages(begin, end - begin, candidates);
+			}
+		}
+
+		// Pages are dirty when first touched, so that none being dirty at first means that the kernel does not set the bits.
+		if (frame_count == 0 && tracker && candidates.empty() && !ranges.empty())
+		{
+			tracker.reset();
+			soft_dirty = false;
+		}
+
+		if (all)
+		{
+			candidates.clear();
+		}
+
+		if (tracker)
+		{
+			try
+			{
+				tracker->clear();
+			}
+			catch (std::system_error const&)
+			{
+				// Without clearing, bits would stay set, so that every page is hashed from now on.
+				tracker.reset();
+				soft_dirty = false;
+			}
+		}
+
+		if (all)
+		{
+			for (auto const& [begin, end] : ranges)
+			{
+				for (address_t page = begin; page < end; page += page_size)
+				{
+					candidates.push_back(page);
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Capture a frame.
+	 *
+	 * @throws `std::system_error` if the log is full, or on failed read attempt other than an inaccessible address
+	 */
+	auto capture() -> std::size_t
+	{
+		std::scoped_lock lock(capture_mutex);
+
+		if (full || log_used + sizeof(frame_header) > log_end)
+		{
+			full = true;
+			throw std::system_error(std::make_error_code(std::errc::no_space_on_device), "recording log is full");
+		}
+
+		auto const time = std::chrono::system_clock::now();
+
+		candidate_pages();
+
+		WORM_PROBE(record_frame__entry, h.pid(), frame_count, candidates.size());
+
+		std::size_t const entry_size = sizeof(page_header) + page_size;
+		std::size_t       cursor     = log_used + sizeof(frame_header);
+
+		changed.clear();
+		buffer.resize(batch_pages * page_size);
+
+		try
+		{
+			for (std::size_t first = 0; first < candidates.size(); first += batch_pages)
+			{
+				std::size_t const count = std::min(batch_pages, candidates.size() - first);
+
+				transfers.clear();
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					transfers.push_back({candidates[first + i], buffer.data() + i * page_size, page_size});
+				}
+
+				h.read_bytes(transfers);
+
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					auto const& t = transfers[i];
+					if (t.transferred != page_size)
+					{
+						continue;
+					}
+
+					auto const data = static_cast<unsigned char const*>(t.buffer);
+					auto const hash = simd::hash_page(data, page_size);
+
+					auto const [it, inserted] = hashes.try_emplace(t.address, hash);
+					if (!inserted)
+					{
+						if (it->second == hash)
+						{
+							continue;
+						}
+
+						it->second = hash;
+					}
+
+					if (cursor + entry_size > log_end)
+					{
+						full = true;
+						throw std::system_error(std::make_error_code(std::errc::no_space_on_device), "recording log is full");
+					}
+
+					page_header const header{t.address};
+					std::memcpy(log + cursor, &header, sizeof(header));
+					std::memcpy(log + cursor + sizeof(header), data, page_size);
+
+					changed.push_back({t.address, cursor + sizeof(header)});
+					cursor += entry_size;
+				}
+			}
+		}
+		catch (std::system_error const&)
+		{
+			WORM_PROBE(record_frame__return, h.pid(), frame_count, candidates.size(), -1);
+
+			// Hashes of pages that were not published would hide their changes from the next frames.
+			for (auto const& [address, offset] : changed)
+			{
+				hashes.erase(address);
+			}
+
+			throw;
+		}
+
+		frame_header const header{
+			std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(),
+			frame_count,
+			changed.size(),
+		};
+		std::memcpy(log + log_used, &header, sizeof(header));
+
+		{
+			std::unique_lock index_lock(index_mutex);
+
+			for (auto const& [address, offset] : changed)
+			{
+				index[address].push_back({frame_count, offset});
+			}
+
+			frames.push_back({time, changed.size()});
+			log_used = cursor;
+		}
+
+		WORM_PROBE(record_frame__return, h.pid(), frame_count, candidates.size(), changed.size());
+
+		++frame_count;
+
+		return changed.size();
+	}
+
+	/**
+	 * @brief Reconstruct bytes as of a frame.
+	 */
+	auto read_bytes(std::size_t frame, address_t src, void* dst, std::size_t size) const -> std::size_t
+	{
+		std::shared_lock lock(index_mutex);
+
+		if (frame >= frames.size())
+		{
+			throw std::out_of_range("frame was not captured");
+		}
+
+		auto* const out  = static_cast<unsigned char*>(dst);
+		std::size_t done = 0;
+
+		while (done < size)
+		{
+			address_t const   addr   = src + done;
+			address_t const   page   = addr / page_size * page_size;
+			std::size_t const offset = addr - page;
+			std::size_t const n      = std::min(size - done, page_size - offset);
+
+			auto const it = index.find(page);
+			if (it == index.end())
+			{
+				break;
+			}
+
+			// The page as of the frame is its latest version logged by the frame or before it.
+			auto const& versions = it->second;
+			auto const  version  = std::ranges::upper_bound(versions, std::uint64_t{frame}, {}, &page_version::frame);
+			if (version == versions.begin())
+			{
+				break;
+			}
+
+			std::memcpy(out + done, log + std::prev(version)->offset + offset, n);
+			done += n;
+		}
+
+		return done;
+	}
+
+	handle_type const&       h;
+	std::chrono::nanoseconds interval;
+	std::size_t              resync_frames;
+	std::size_t              page_size;
+
+	/// Page-aligned address ranges of recorded regions.
+	std::vector<std::pair<address_t, address_t>> ranges;
+
+	std::optional<soft_dirty_tracker> tracker;
+
+	/// Whether or not the tracker is used, which is read without taking the capture lock.
+	std::atomic<bool> soft_dirty = false;
+
+	int            fd       = -1;
+	unsigned char* log      = nullptr;
+	std::size_t    log_end  = 0;
+	std::size_t    log_used = 0;
+
+	/// Serializes captures.
+	std::mutex capture_mutex;
+
+	/// Whether or not the log ran out of space.
+	bool full = false;
+
+	std::uint64_t frame_count = 0;
+
+	/// Hashes of the latest logged versions of pages, which only captures access.
+	std::unordered_map<address_t, std::uint64_t> hashes;
+
+	std::vector<address_t>                         candidates;
+	std::vector<unsigned char>                     buffer;
+	std::vector<memory_transfer>                   transfers;
+	std::vector<std::pair<address_t, std::size_t>> changed;
+
+	/// Guards the page index, frames and the used size of the log against readers.
+	mutable std::shared_mutex index_mutex;
+
+	/// Logged versions of pages, in order of frames.
+	std::unordered_map<address_t, std::vector<page_version>> index;
+
+	std::vector<recorded_frame> frames;
+
+	std::mutex              stop_mutex;
+	std::condition_variable stop_cv;
+
+	/// Whether or not the capturer thread has to stop.
+	bool stopped = false;
+
+	/// Capturer thread.
+	std::thread capturer;
+};
+#else
+template <handle_mode Mode>
+struct recorder<Mode>::state
+{};
+#endif
+
+template <handle_mode Mode>
+recorder<Mode>::recorder(
+	[[maybe_unused]] handle_type const&                h,
+	[[maybe_unused]] std::vector<memory_region> const& regions,
+	[[maybe_unused]] recorder_options const&           options
+)
+	requires handle_type::readable
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	state_ = std::make_unique<state>(h, regions, options);
+#else
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "recording is only supported on Linux");
+#endif
+}
+
+template <handle_mode Mode>
+recorder<Mode>::~recorder() = default;
+
+template <handle_mode Mode>
+auto recorder<Mode>::capture() -> std::size_t
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	return state_->capture();
+#else
+	return 0;
+#endif
+}
+
+template <handle_mode Mode>
+auto recorder<Mode>::frames() const -> std::vector<recorded_frame>
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	std::shared_lock lock(state_->index_mutex);
+	return state_->frames;
+#else
+	return {};
+#endif
+}
+
+template <handle_mode Mode>
+auto recorder<Mode>::read_bytes([[maybe_unused]] std::size_t frame, [[maybe_unused]] address_t src, [[maybe_unused]] void* dst, [[maybe_unused]] std::size_t size)
+	const -> std::size_t
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	return state_->read_bytes(frame, src, dst, size);
+#else
+	return 0;
+#endif
+}
+
+template <handle_mode Mode>
+auto recorder<Mode>::log_size() const -> std::size_t
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	std::shared_lock lock(state_->index_mutex);
+	return state_->log_used;
+#else
+	return 0;
+#endif
+}
+
+template <handle_mode Mode>
+auto recorder<Mode>::soft_dirty() const noexcept -> bool
+{
+#if defined(WORM_POSIX) && defined(__linux__)
+	return state_->soft_dirty.load(std::memory_order::relaxed);
+#else
+	return false;
+#endif
+}
+
+template struct recorder<handle_mode::in>;
+template struct recorder<handle_mode::in | handle_mode::out>;
+}
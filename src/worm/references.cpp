@@ -0,0 +1,179 @@
+#include "worm/references.hpp"
+#include "worm/region_reader.hpp"
+
+#include "probes.hpp"
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace worm
+{
+namespace
+{
+/// Number of bytes in a pointer.
+constexpr std::size_t word_size = sizeof(address_t);
+}
+
+template <handle_mode Mode>
+auto find_references(handle<Mode> const& h, std::vector<memory_region> const& regions, address_range target, reference_options const& options)
+	-> std::vector<reference>
+	requires handle<Mode>::readable
+{
+	std::size_t const alignment = std::max<std::size_t>(options.alignment, 1);
+	if (word_size % alignment && alignment % word_size)
+	{
+		throw std::invalid_argument("alignment neither divides nor is a multiple of the size of an address");
+	}
+
+	if (target.empty())
+	{
+		return {};
+	}
+
+	// Words of every phase within an address are compared, e.g. two for an
+	// alignment of four, and words of the last phase may cross into the next
+	// chunk.
+	std::size_t const phases     = alignment < word_size ? word_size / alignment : 1;
+	std::size_t const overlap    = alignment < word_size ? word_size - alignment : 0;
+	std::size_t const step       = std::max(alignment, word_size);
+	std::size_t const chunk_size = std::max(options.chunk_size / step * step, step);
+
+	std::vector<address_range> ranges;
+	for (auto const& region : regions)
+	{
+		if (static_cast<bool>(region.permissions & memory_permission::read) && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	std::vector<address_range> units;
+	for (auto const& range : ranges)
+	{
+		address_t const end = *range.end();
+
+		for (address_t addr = range.front(); addr < end; addr += chunk_size)
+		{
+			units.push_back({addr, std::min<address_t>(addr + chunk_size + overlap, end)});
+		}
+	}
+
+	std::size_t const threads = std::min<std::size_t>(units.size(), options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u));
+
+	address_t const lo   = target.front();
+	address_t const size = target.size();
+
+	std::vector<reference> references;
+	std::mutex             references_mutex;
+	std::exception_ptr     exception;
+
+	auto const worker = [&](std::size_t first_unit)
+	{
+		std::vector<reference>   local_references;
+		std::vector<std::size_t> offsets((chunk_size + overlap) / word_size + 1);
+
+		try
+		{
+			std::vector<address_range> worker_units;
+
+			for (std::size_t i = first_unit; i < units.size(); i += threads)
+			{
+				worker_units.push_back(units[i]);
+			}
+
+			region_reader<Mode> reader(h, std::move(worker_units), {.chunk_size = chunk_size + overlap});
+
+			while (auto const chunk = reader.next())
+			{
+				WORM_PROBE(reference_chunk__entry, h.pid(), chunk->address, chunk->data.size());
+
+				std::size_t const first = local_references.size();
+
+				for (std::size_t phase = 0; phase < phases; ++phase)
+				{
+					std::size_t const skip = phase * alignment;
+					if (skip >= chunk->data.size())
+					{
+						break;
+					}
+
+					std::size_t const count = simd::find_in_range(chunk->data.subspan(skip), lo, size, offsets.data());
+
+					for (std::size_t k = 0; k < count; ++k)
+					{
+						std::size_t const offset = skip + offsets[k];
+
+						// Words starting in the overlap are left to the next chunk.
+						if (offset >= chunk_size || (chunk->address + offset) % alignment)
+						{
+							continue;
+						}
+
+						address_t value;
+						std::memcpy(&value, chunk->data.data() + offset, word_size);
+
+						local_references.push_back({chunk->address + offset, static_cast<std::size_t>(value - lo)});
+					}
+				}
+
+				WORM_PROBE(reference_chunk__return, h.pid(), chunk->address, chunk->data.size(), local_references.size() - first);
+			}
+		}
+		catch (...)
+		{
+			std::scoped_lock lock(references_mutex);
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+
+			return;
+		}
+
+		std::scoped_lock lock(references_mutex);
+		references.insert(references.end(), local_references.begin(), local_references.end());
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(worker, i);
+	}
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	std::ranges::sort(references, {}, &reference::address);
+
+	return references;
+}
+
+template <handle_mode Mode>
+auto find_references(handle<Mode> const& h, address_range target, reference_options const& options) -> std::vector<reference>
+	requires handle<Mode>::readable
+{
+	return find_references(h, h.regions(), target, options);
+}
+
+template auto find_references(handle<handle_mode::in> const&, std::vector<memory_region> const&, address_range, reference_options const&)
+	-> std::vector<reference>;
+template auto find_references(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, address_range, reference_options const&)
+	-> std::vector<reference>;
+
+template auto find_references(handle<handle_mode::in> const&, address_range, reference_options const&) -> std::vector<reference>;
+template auto find_references(handle<handle_mode::in | handle_mode::out> const&, address_range, reference_options const&) -> std::vector<reference>;
+}
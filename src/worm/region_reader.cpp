@@ -0,0 +1,242 @@
+#include "worm/region_reader.hpp"
+
+#include "probes.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace worm
+{
+template <handle_mode Mode>
+struct region_reader<Mode>::state
+{
+	/// Chunk to be read.
+	struct task
+	{
+		/// Remote virtual memory address of the first byte.
+		address_t address;
+
+		/// Number of bytes to read.
+		std::size_t size;
+	};
+
+	/// Buffer that a chunk is read into.
+	struct buffer
+	{
+		/// Buffer data.
+		std::unique_ptr<unsigned char[]> data;
+
+		/// Read chunk.
+		memory_chunk chunk;
+	};
+
+	/// Handle to read chunks with.
+	handle_type const& h;
+
+	/// Chunks to be read, in order.
+	std::vector<task> tasks;
+
+	/// Chunk buffers, one of which is held by the consumer.
+	std::vector<buffer> buffers;
+
+	std::mutex              mutex;
+	std::condition_variable filled_cv;
+	std::condition_variable free_cv;
+
+	/// Indices of read buffers, in order.
+	std::deque<std::size_t> filled;
+
+	/// Indices of buffers that can be read into.
+	std::vector<std::size_t> free;
+
+	/// Index of the buffer held by the consumer.
+	std::optional<std::size_t> held;
+
+	/// Number of delivered chunks.
+	std::size_t delivered = 0;
+
+	/// Whether or not the reader thread has to stop.
+	bool stopped = false;
+
+	/// Exception thrown by the reader thread.
+	std::exception_ptr exception;
+
+	/// Reader thread.
+	std::thread reader;
+
+	state(handle_type const& h, std::vector<address_range> const& ranges, region_reader_options const& options)
+		: h{h}
+	{
+		std::size_t const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+		std::size_t const step       = chunk_size - std::min(options.overlap, chunk_size - 1);
+
+		for (auto const& range : ranges)
+		{
+			for (address_t addr = range.front(); addr < *range.end(); addr += step)
+			{
+				std::size_t const size = std::min<std::size_t>(chunk_size, *range.end() - addr);
+				tasks.push_back({addr, size});
+
+				if (size < chunk_size || addr + size == *range.end())
+				{
+					break;
+				}
+			}
+		}
+
+		std::size_t const buffer_count = std::min(options.depth, tasks.size()) + 1;
+
+		buffers.resize(buffer_count);
+		for (std::size_t i = 0; i < buffer_count; ++i)
+		{
+			buffers[i].data = std::make_unique<unsigned char[]>(chunk_size);
+			free.push_back(i);
+		}
+
+		reader = std::thread(&state::run, this);
+	}
+
+	state(state const&)                    = delete;
+	auto operator=(state const&) -> state& = delete;
+
+	~state()
+	{
+		{
+			std::scoped_lock lock(mutex);
+			stopped = true;
+		}
+
+		free_cv.notify_all();
+		reader.join();
+	}
+
+	/// Read chunks until all are read or stopped.
+	auto run() noexcept -> void
+	{
+		for (auto const& t : tasks)
+		{
+			std::size_t index;
+			{
+				std::unique_lock lock(mutex);
+				free_cv.wait(lock, [this] { return stopped || !free.empty(); });
+
+				if (stopped)
+				{
+					return;
+				}
+
+				index = free.back();
+				free.pop_back();
+			}
+
+			auto& b = buffers[index];
+
+			WORM_PROBE(reader_chunk__entry, h.pid(), t.address, t.size);
+
+			std::size_t size = 0;
+			try
+			{
+				size = h.read_bytes(t.address, b.data.get(), t.size);
+			}
+			catch (std::system_error const&)
+			{}
+			catch (...)
+			{
+				std::scoped_lock lock(mutex);
+				exception = std::current_exception();
+				filled_cv.notify_one();
+				return;
+			}
+
+			WORM_PROBE(reader_chunk__return, h.pid(), t.address, t.size, size);
+
+			b.chunk = {t.address, {b.data.get(), size}};
+
+			{
+				std::scoped_lock lock(mutex);
+				filled.push_back(index);
+			}
+
+			filled_cv.notify_one();
+		}
+	}
+
+	/// Get the next chunk.
+	auto next() -> std::optional<memory_chunk>
+	{
+		std::unique_lock lock(mutex);
+
+		if (held)
+		{
+			free.push_back(*held);
+			held.reset();
+			free_cv.notify_one();
+		}
+
+		filled_cv.wait(lock, [this] { return !filled.empty() || exception || delivered == tasks.size(); });
+
+		if (!filled.empty())
+		{
+			held = filled.front();
+			filled.pop_front();
+			++delivered;
+
+			return buffers[*held].chunk;
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+
+		return std::nullopt;
+	}
+};
+
+template <handle_mode Mode>
+region_reader<Mode>::region_reader(handle_type const& h, std::vector<address_range> ranges, region_reader_options const& options)
+	requires(handle_type::readable)
+	: state_{std::make_unique<state>(h, ranges, options)}
+{}
+
+template <handle_mode Mode>
+region_reader<Mode>::region_reader(handle_type const& h, std::vector<memory_region> const& regions, region_reader_options const& options)
+	requires(handle_type::readable)
+	: state_{}
+{
+	std::vector<address_range> ranges;
+
+	for (auto const& region : regions)
+	{
+		if (static_cast<bool>(region.permissions & memory_permission::read) && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	state_ = std::make_unique<state>(h, ranges, options);
+}
+
+template <handle_mode Mode>
+region_reader<Mode>::region_reader(region_reader&&) noexcept = default;
+
+template <handle_mode Mode>
+auto region_reader<Mode>::operator=(region_reader&&) noexcept -> region_reader& = default;
+
+template <handle_mode Mode>
+region_reader<Mode>::~region_reader() = default;
+
+template <handle_mode Mode>
+auto region_reader<Mode>::next() -> std::optional<memory_chunk>
+{
+	return state_->next();
+}
+
+template struct region_reader<handle_mode::in>;
+template struct region_reader<handle_mode::in | handle_mode::out>;
+}
@@ -0,0 +1,804 @@
+#include "worm/scan.hpp"
+#include "worm/region_reader.hpp"
+
+#include "probes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace worm
+{
+namespace
+{
+/// Chunk of a range that is matched as a whole.
+struct scan_unit
+{
+	/// Remote virtual memory address of the first byte.
+	address_t address;
+
+	/// Number of bytes, including the overlap with the next unit.
+	std::size_t size;
+
+	/// Index of the range that the unit belongs to.
+	std::size_t range;
+};
+
+/// Pattern prepared for matching.
+struct matcher
+{
+	/**
+	 * @brief Prepare a pattern for matching.
+	 *
+	 * @param[in] p         pattern, which must outlive the matcher
+	 * @param[in] alignment alignment of matched addresses
+	 */
+	matcher(pattern const& p, std::size_t alignment) noexcept
+		: p_{p}
+		, alignment_{std::max<std::size_t>(alignment, 1)}
+	{
+		// The least common looking byte that has to match is searched for
+		// first, as zeroes and ones are abundant in memory.
+		static constexpr auto commonness = [](unsigned char byte) { return byte == 0x00 ? 2 : byte == 0xff ? 1 : 0; };
+
+		for (std::size_t i = 0; i < p_.size(); ++i)
+		{
+			if (p_.mask[i] && (!anchor_ || commonness(p_.bytes[i]) < commonness(p_.bytes[*anchor_])))
+			{
+				anchor_ = i;
+			}
+		}
+
+		// Aligned patterns that fit in a word are compared word by word.
+		std::size_t const n = p_.size();
+		if (alignment_ > 1 && (n == 1 || n == 2 || n == 4 || n == 8))
+		{
+			std::memcpy(&word_, p_.bytes.data(), n);
+			std::memcpy(&word_mask_, p_.mask.data(), n);
+			word_ &= word_mask_;
+		}
+	}
+
+	/**
+	 * @brief Find matches in a chunk.
+	 *
+	 * @param[in] data     chunk data
+	 * @param[in] address  remote virtual memory address of the chunk
+	 * @param[in] on_match function called with the address of each match, in ascending order
+	 *
+	 * @return number of matches
+	 */
+	template <typename F>
+	auto find(std::span<unsigned char const> data, address_t address, F&& on_match) const -> std::size_t
+	{
+		std::size_t const n = p_.size();
+		if (!n || data.size() < n)
+		{
+			return 0;
+		}
+
+		std::size_t const last = data.size() - n;
+
+		if (word_mask_)
+		{
+			switch (n)
+			{
+			case 1:
+				return find_words<std::uint8_t>(data.data(), last, address, on_match);
+			case 2:
+				return find_words<std::uint16_t>(data.data(), last, address, on_match);
+			case 4:
+				return find_words<std::uint32_t>(data.data(), last, address, on_match);
+			default:
+				return find_words<std::uint64_t>(data.data(), last, address, on_match);
+			}
+		}
+
+		std::size_t count = 0;
+
+		if (!anchor_)
+		{
+			for (std::size_t i = first_aligned(address); i <= last; i += alignment_)
+			{
+				on_match(address + i);
+				++count;
+			}
+
+			return count;
+		}
+
+		std::size_t const   anchor = *anchor_;
+		unsigned char const byte   = p_.bytes[anchor];
+
+		for (std::size_t i = anchor; i <= last + anchor;)
+		{
+			auto const* const hit = static_cast<unsigned char const*>(std::memchr(data.data() + i, byte, last + anchor + 1 - i));
+			if (!hit)
+			{
+				break;
+			}
+
+			std::size_t const start = static_cast<std::size_t>(hit - data.data()) - anchor;
+			if ((address + start) % alignment_ == 0 && matches(data.data() + start))
+			{
+				on_match(address + start);
+				++count;
+			}
+
+			i = start + anchor + 1;
+		}
+
+		return count;
+	}
+
+private:
+	/**
+	 * @brief Get offset of the first aligned address of a chunk.
+	 *
+	 * @param[in] address remote virtual memory address of the chunk
+	 */
+	[[nodiscard]]
+	auto first_aligned(address_t address) const noexcept -> std::size_t
+	{
+		return (alignment_ - address % alignment_) % alignment_;
+	}
+
+	/**
+	 * @brief Check whether the pattern matches at a position.
+	 *
+	 * @param[in] data position, followed by at least as many bytes as there are in the pattern
+	 */
+	[[nodiscard]]
+	auto matches(unsigned char const* data) const noexcept -> bool
+	{
+		for (std::size_t i = 0; i < p_.size(); ++i)
+		{
+			if ((data[i] ^ p_.bytes[i]) & p_.mask[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	template <typename Word, typename F>
+	auto find_words(unsigned char const* data, std::size_t last, address_t address, F& on_match) const -> std::size_t
+	{
+		auto const word = static_cast<Word>(word_);
+		auto const mask = static_cast<Word>(word_mask_);
+
+		std::size_t count = 0;
+		for (std::size_t i = first_aligned(address); i <= last; i += alignment_)
+		{
+			Word w;
+			std::memcpy(&w, data + i, sizeof(w));
+
+			if ((w & mask) == word)
+			{
+				on_match(address + i);
+				++count;
+			}
+		}
+
+		return count;
+	}
+
+	pattern const&             p_;
+	std::size_t                alignment_;
+	std::optional<std::size_t> anchor_;
+	std::uint64_t              word_      = 0;
+	std::uint64_t              word_mask_ = 0;
+};
+
+/**
+ * @brief Get ranges of readable regions.
+ *
+ * @param[in] regions memory regions
+ */
+[[nodiscard]]
+auto readable_ranges(std::vector<memory_region> const& regions) -> std::vector<address_range>
+{
+	std::vector<address_range> ranges;
+
+	for (auto const& region : regions)
+	{
+		if (static_cast<bool>(region.permissions & memory_permission::read) && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	return ranges;
+}
+
+/**
+ * @brief Split ranges into units.
+ *
+ * @param[in] ranges     address ranges
+ * @param[in] chunk_size number of bytes that each unit starts
+ * @param[in] overlap    number of bytes that each unit shares with the next one
+ */
+[[nodiscard]]
+auto split_ranges(std::vector<address_range> const& ranges, std::size_t chunk_size, std::size_t overlap) -> std::vector<scan_unit>
+{
+	std::vector<scan_unit> units;
+
+	for (std::size_t r = 0; r < ranges.size(); ++r)
+	{
+		address_t const end = *ranges[r].end();
+
+		for (address_t addr = ranges[r].front(); addr < end; addr += chunk_size)
+		{
+			units.push_back({addr, static_cast<std::size_t>(std::min<address_t>(addr + chunk_size + overlap, end) - addr), r});
+		}
+	}
+
+	return units;
+}
+
+/**
+ * @brief Get number of worker threads.
+ *
+ * @param[in] options scan options
+ */
+[[nodiscard]]
+auto thread_count(scan_options const& options) noexcept -> std::size_t
+{
+	return options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/// Number of bytes that a step of an incremental scan reads at least, and before its throughput is known.
+constexpr std::size_t min_step_read = 1 << 12;
+}
+
+auto pattern::text(std::string_view str) -> pattern
+{
+	return {{str.begin(), str.end()}, std::vector<unsigned char>(str.size(), 0xff)};
+}
+
+auto pattern::signature(std::string_view signature) -> pattern
+{
+	pattern p;
+
+	static constexpr auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)); };
+	static constexpr auto digit    = [](char c) -> int
+	{
+		if (c >= '0' && c <= '9')
+		{
+			return c - '0';
+		}
+
+		c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+	};
+
+	for (std::size_t i = 0; i < signature.size();)
+	{
+		if (is_space(signature[i]))
+		{
+			++i;
+			continue;
+		}
+
+		std::size_t const begin = i;
+		while (i < signature.size() && !is_space(signature[i]))
+		{
+			++i;
+		}
+
+		std::string_view const token = signature.substr(begin, i - begin);
+
+		if (token == "?" || token == "??")
+		{
+			p.bytes.push_back(0);
+			p.mask.push_back(0);
+			continue;
+		}
+
+		if (token.size() != 2 || digit(token[0]) < 0 || digit(token[1]) < 0)
+		{
+			throw std::invalid_argument("malformed signature byte");
+		}
+
+		p.bytes.push_back(static_cast<unsigned char>(digit(token[0]) << 4 | digit(token[1])));
+		p.mask.push_back(0xff);
+	}
+
+	if (p.bytes.empty())
+	{
+		throw std::invalid_argument("empty signature");
+	}
+
+	return p;
+}
+
+auto pattern::size() const noexcept -> std::size_t
+{
+	return std::min(bytes.size(), mask.size());
+}
+
+template <handle_mode Mode>
+auto estimate_scan(handle<Mode> const& h, std::vector<memory_region> const& regions, pattern const& p, scan_options const& options) -> scan_estimate
+	requires handle<Mode>::readable
+{
+	auto const ranges = readable_ranges(regions);
+
+	// Cumulative sizes of ranges, which samples are drawn from.
+	std::vector<std::size_t> ends;
+	ends.reserve(ranges.size());
+
+	std::size_t bytes = 0;
+	for (auto const& range : ranges)
+	{
+		bytes += range.size();
+		ends.push_back(bytes);
+	}
+
+	std::size_t const alignment   = std::max<std::size_t>(options.alignment, 1);
+	std::size_t const sample_size = std::max(options.sample_size, p.size());
+
+	matcher const m(p, alignment);
+
+	std::vector<unsigned char> buffer(sample_size);
+
+	std::size_t sampled_bytes = 0;
+	std::size_t sampled_hits  = 0;
+	std::size_t attempted     = 0;
+
+	auto const sample = [&](std::size_t offset)
+	{
+		std::size_t const r     = static_cast<std::size_t>(std::ranges::upper_bound(ends, offset) - ends.begin());
+		std::size_t const begin = ends[r] - ranges[r].size();
+
+		// Samples are aligned to their size within a range, so that they do
+		// not overlap.
+		std::size_t const local = (offset - begin) / sample_size * sample_size;
+		std::size_t const size  = std::min(sample_size, ranges[r].size() - local);
+
+		address_t const addr = ranges[r].front() + local;
+
+		std::size_t read = 0;
+		try
+		{
+			read = h.read_bytes(addr, buffer.data(), size);
+		}
+		catch (std::system_error const&)
+		{}
+
+		attempted += size;
+		sampled_bytes += read;
+		sampled_hits += m.find({buffer.data(), read}, addr, [](address_t) {});
+	};
+
+	auto const started = std::chrono::steady_clock::now();
+
+	if (bytes <= options.samples * sample_size)
+	{
+		for (std::size_t offset = 0; offset < bytes; offset = std::min(ends[std::ranges::upper_bound(ends, offset) - ends.begin()], offset + sample_size))
+		{
+			sample(offset);
+		}
+	}
+	else
+	{
+		std::mt19937_64                            engine(std::random_device{}());
+		std::uniform_int_distribution<std::size_t> distribution(0, bytes - 1);
+
+		for (std::size_t i = 0; i < options.samples; ++i)
+		{
+			sample(distribution(engine));
+		}
+	}
+
+	auto const elapsed = std::chrono::steady_clock::now() - started;
+
+	scan_estimate estimate{
+		.bytes         = bytes,
+		.sampled_bytes = sampled_bytes,
+		.sampled_hits  = sampled_hits,
+		.hit_density   = sampled_bytes ? static_cast<double>(sampled_hits) / static_cast<double>(sampled_bytes) : 0.0,
+	};
+
+	estimate.expected_hits = static_cast<std::size_t>(std::llround(estimate.hit_density * static_cast<double>(bytes)));
+
+	// Samples are read one by one, so the per-byte cost includes more system
+	// call overhead than chunked reads have, which errs on the expensive side.
+	std::size_t const threads     = thread_count(options);
+	double const      ns_per_byte = attempted ? static_cast<double>(std::chrono::nanoseconds(elapsed).count()) / static_cast<double>(attempted) : 0.0;
+
+	estimate.expected_duration = std::chrono::nanoseconds(std::llround(ns_per_byte * static_cast<double>(bytes) / static_cast<double>(threads)));
+
+	std::size_t const list_size   = estimate.expected_hits * sizeof(address_t);
+	std::size_t const bitmap_size = (bytes / alignment + 7) / 8;
+
+	estimate.representation       = bitmap_size < list_size ? set_representation::bitmap : set_representation::list;
+	estimate.expected_result_size = std::min(list_size, bitmap_size);
+
+	// Pipelining only pays off once workers have more than a chunk each.
+	estimate.strategy = bytes <= std::max<std::size_t>(options.chunk_size, 1) * threads ? scan_strategy::direct : scan_strategy::streaming;
+
+	return estimate;
+}
+
+template <handle_mode Mode>
+auto scan(handle<Mode> const& h, std::vector<memory_region> const& regions, pattern const& p, scan_options const& options) -> address_set
+	requires handle<Mode>::readable
+{
+	auto representation = options.representation;
+	auto strategy       = options.strategy;
+
+	if (!representation || !strategy)
+	{
+		auto const estimate = estimate_scan(h, regions, p, options);
+
+		representation = representation.value_or(estimate.representation);
+		strategy       = strategy.value_or(estimate.strategy);
+	}
+
+	std::size_t const alignment  = std::max<std::size_t>(options.alignment, 1);
+	std::size_t const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+	std::size_t const overlap    = p.size() ? p.size() - 1 : 0;
+
+	auto const ranges = readable_ranges(regions);
+	auto const units  = split_ranges(ranges, chunk_size, overlap);
+
+	std::size_t const threads = std::min(units.size(), thread_count(options));
+
+	matcher const m(p, alignment);
+
+	std::vector<address_set::bitmap_segment> segments;
+
+	if (*representation == set_representation::bitmap)
+	{
+		segments.reserve(ranges.size());
+
+		for (auto const& range : ranges)
+		{
+			address_t const   base = range.front() - range.front() % alignment;
+			std::size_t const size = (*range.end() - base + alignment - 1) / alignment;
+
+			segments.push_back({base, size, std::vector<std::uint64_t>((size + 63) / 64)});
+		}
+	}
+
+	std::vector<address_t> addresses;
+	std::mutex             addresses_mutex;
+	std::exception_ptr     exception;
+
+	auto const worker = [&](std::size_t first_unit)
+	{
+		std::vector<address_t> local_addresses;
+
+		auto const match = [&](scan_unit const& unit, std::span<unsigned char const> data)
+		{
+			WORM_PROBE(scan_chunk__entry, h.pid(), unit.address, data.size());
+
+			std::size_t hits;
+
+			if (*representation == set_representation::bitmap)
+			{
+				// Neighbouring units may be matched by different workers and
+				// share words of the bitmap.
+				auto& segment = segments[unit.range];
+
+				hits = m.find(data, unit.address, [&](address_t addr) {
+					std::size_t const bit = (addr - segment.base) / alignment;
+					std::atomic_ref(segment.bits[bit / 64]).fetch_or(std::uint64_t{1} << (bit % 64), std::memory_order::relaxed);
+				});
+			}
+			else
+			{
+				hits = m.find(data, unit.address, [&](address_t addr) { local_addresses.push_back(addr); });
+			}
+
+			WORM_PROBE(scan_chunk__return, h.pid(), unit.address, data.size(), hits);
+		};
+
+		try
+		{
+			if (*strategy == scan_strategy::direct)
+			{
+				std::vector<unsigned char> buffer(chunk_size + overlap);
+
+				for (std::size_t i = first_unit; i < units.size(); i += threads)
+				{
+					std::size_t size = 0;
+					try
+					{
+						size = h.read_bytes(units[i].address, buffer.data(), units[i].size);
+					}
+					catch (std::system_error const&)
+					{}
+
+					match(units[i], {buffer.data(), size});
+				}
+			}
+			else
+			{
+				std::vector<address_range> unit_ranges;
+
+				for (std::size_t i = first_unit; i < units.size(); i += threads)
+				{
+					unit_ranges.push_back({units[i].address, units[i].address + units[i].size});
+				}
+
+				region_reader reader(h, std::move(unit_ranges), {.chunk_size = chunk_size + overlap});
+
+				for (std::size_t i = first_unit; i < units.size(); i += threads)
+				{
+					match(units[i], reader.next()->data);
+				}
+			}
+		}
+		catch (...)
+		{
+			std::scoped_lock lock(addresses_mutex);
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+
+			return;
+		}
+
+		std::scoped_lock lock(addresses_mutex);
+		addresses.insert(addresses.end(), local_addresses.begin(), local_addresses.end());
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(worker, i);
+	}
+
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+
+	if (*representation == set_representation::bitmap)
+	{
+		return address_set(std::move(segments), alignment);
+	}
+
+	return address_set(std::move(addresses));
+}
+
+template <handle_mode Mode>
+auto scan(handle<Mode> const& h, pattern const& p, scan_options const& options) -> address_set
+	requires handle<Mode>::readable
+{
+	return scan(h, h.regions(), p, options);
+}
+
+template auto estimate_scan(handle<handle_mode::in> const&, std::vector<memory_region> const&, pattern const&, scan_options const&) -> scan_estimate;
+template auto estimate_scan(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, pattern const&, scan_options const&) -> scan_estimate;
+
+template auto scan(handle<handle_mode::in> const&, std::vector<memory_region> const&, pattern const&, scan_options const&) -> address_set;
+template auto scan(handle<handle_mode::in | handle_mode::out> const&, std::vector<memory_region> const&, pattern const&, scan_options const&) -> address_set;
+
+template auto scan(handle<handle_mode::in> const&, pattern const&, scan_options const&) -> address_set;
+template auto scan(handle<handle_mode::in | handle_mode::out> const&, pattern const&, scan_options const&) -> address_set;
+
+template <handle_mode Mode>
+struct incremental_scan<Mode>::state
+{
+	state(handle_type const& h, std::vector<memory_region> const& regions, pattern p, scan_options const& options)
+		: h{h}
+		, p{std::move(p)}
+		, m{this->p, options.alignment}
+		, chunk_size{std::max<std::size_t>(options.chunk_size, 1)}
+		, overlap{this->p.size() ? this->p.size() - 1 : 0}
+		, ranges{readable_ranges(regions)}
+	{
+		// Ranges are scanned in order, so that matches are found in ascending order.
+		std::ranges::sort(ranges, {}, [](auto const& r) { return r.front(); });
+
+		for (auto const& range : ranges)
+		{
+			total_bytes += range.size();
+		}
+	}
+
+	handle_type const& h;
+
+	pattern     p;
+	matcher     m;
+	std::size_t chunk_size;
+	std::size_t overlap;
+
+	std::vector<address_range> ranges;
+	std::vector<address_t>     addresses;
+	std::vector<unsigned char> buffer;
+
+	/// Index of the current range and offset of the next byte to scan in it.
+	std::size_t range  = 0;
+	std::size_t offset = 0;
+
+	std::size_t scanned_bytes = 0;
+	std::size_t total_bytes   = 0;
+
+	/// Measured number of bytes scanned per nanosecond, or `0` if not measured yet.
+	double throughput = 0;
+
+	/**
+	 * @brief Scan the next bytes of the current range.
+	 *
+	 * @param[in] size maximum number of bytes to scan
+	 */
+	auto advance(std::size_t size) -> void
+	{
+		auto const& current = ranges[range];
+
+		size = std::min(size, current.size() - offset);
+
+		address_t const   addr = current.front() + offset;
+		std::size_t const read = std::min(size + overlap, current.size() - offset);
+
+		buffer.resize(std::max(buffer.size(), read));
+
+		WORM_PROBE(scan_chunk__entry, h.pid(), addr, read);
+
+		std::size_t transferred = 0;
+		try
+		{
+			transferred = h.read_bytes(addr, buffer.data(), read);
+		}
+		catch (std::system_error const&)
+		{}
+
+		// Matches starting in the overlap are left to the next read.
+		std::size_t const hits = m.find({buffer.data(), transferred}, addr, [&](address_t match) {
+			if (match - addr < size)
+			{
+				addresses.push_back(match);
+			}
+		});
+
+		WORM_PROBE(scan_chunk__return, h.pid(), addr, read, hits);
+
+		offset += size;
+		scanned_bytes += size;
+
+		if (offset == current.size())
+		{
+			++range;
+			offset = 0;
+		}
+	}
+
+	[[nodiscard]]
+	auto done() const noexcept -> bool
+	{
+		return range == ranges.size();
+	}
+
+	[[nodiscard]]
+	auto progress() const noexcept -> scan_progress
+	{
+		return {scanned_bytes, total_bytes, addresses.size(), done()};
+	}
+};
+
+template <handle_mode Mode>
+incremental_scan<Mode>::incremental_scan(handle_type const& h, std::vector<memory_region> const& regions, pattern p, scan_options const& options)
+	requires(handle_type::readable)
+	: state_{std::make_unique<state>(h, regions, std::move(p), options)}
+{}
+
+template <handle_mode Mode>
+incremental_scan<Mode>::incremental_scan(handle_type const& h, pattern p, scan_options const& options)
+	requires(handle_type::readable)
+	: incremental_scan(h, h.regions(), std::move(p), options)
+{}
+
+template <handle_mode Mode>
+incremental_scan<Mode>::incremental_scan(incremental_scan&&) noexcept = default;
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::operator=(incremental_scan&&) noexcept -> incremental_scan& = default;
+
+template <handle_mode Mode>
+incremental_scan<Mode>::~incremental_scan() = default;
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::step(scan_budget const& budget) -> scan_progress
+{
+	using clock = std::chrono::steady_clock;
+
+	auto& s = *state_;
+
+	auto const started   = clock::now();
+	std::size_t remaining = budget.bytes.value_or(static_cast<std::size_t>(-1));
+
+	for (bool first = true; !s.done(); first = false)
+	{
+		std::size_t size = std::min(s.chunk_size, remaining);
+
+		if (budget.time)
+		{
+			auto const left = *budget.time - std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - started);
+			if (!first && left.count() <= 0)
+			{
+				break;
+			}
+
+			// Reads are sized to fit in the time left at the measured throughput.
+			double const affordable = s.throughput * static_cast<double>(left.count());
+			size = std::min(size, s.throughput > 0 ? static_cast<std::size_t>(std::min(affordable, static_cast<double>(s.chunk_size))) : min_step_read);
+		}
+
+		if (!first && size == 0)
+		{
+			break;
+		}
+
+		// Every step makes progress, however small its budget.
+		size = std::max(size, std::min(min_step_read, s.chunk_size));
+
+		std::size_t const before = s.scanned_bytes;
+		auto const        start  = clock::now();
+
+		s.advance(size);
+
+		std::size_t const scanned = s.scanned_bytes - before;
+		auto const        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+		if (elapsed > 0)
+		{
+			double const measured = static_cast<double>(scanned) / static_cast<double>(elapsed);
+			s.throughput          = s.throughput > 0 ? (s.throughput + measured) / 2 : measured;
+		}
+
+		remaining -= std::min(remaining, scanned);
+	}
+
+	return s.progress();
+}
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::progress() const noexcept -> scan_progress
+{
+	return state_->progress();
+}
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::done() const noexcept -> bool
+{
+	return state_->done();
+}
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::hits() const noexcept -> std::span<address_t const>
+{
+	return state_->addresses;
+}
+
+template <handle_mode Mode>
+auto incremental_scan<Mode>::result() const -> address_set
+{
+	return address_set(std::vector<address_t>(state_->addresses));
+}
+
+template struct incremental_scan<handle_mode::in>;
+template struct incremental_scan<handle_mode::in | handle_mode::out>;
+}
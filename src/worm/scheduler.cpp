@@ -0,0 +1,438 @@
+#include "worm/scheduler.hpp"
+
+#include "probes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace worm
+{
+namespace
+{
+/// Kind of a job.
+enum struct job_kind
+{
+	call,
+	read,
+	write,
+};
+
+/// Scheduled job.
+template <handle_mode Mode>
+struct job
+{
+	job_kind kind;
+
+	/// Handle of a read or write.
+	handle<Mode> const* h = nullptr;
+
+	/// Remote virtual memory address of a read or write.
+	address_t address = 0;
+
+	/// Buffer of a read, or bytes of a write.
+	std::vector<unsigned char> bytes;
+
+	/// Function of a call.
+	std::function<void()> call;
+
+	/// Function called after a read.
+	std::function<void(std::span<unsigned char const>, std::size_t)> on_read;
+
+	/// Period in ticks.
+	std::uint64_t period = 1;
+
+	/// Tick that the job is due at next.
+	std::uint64_t due = 0;
+
+	std::atomic<bool> running   = false;
+	std::atomic<bool> cancelled = false;
+};
+}
+
+template <handle_mode Mode>
+struct scheduler<Mode>::state
+{
+	using job_ptr = std::shared_ptr<job<Mode>>;
+
+	explicit state(scheduler_options const& options)
+		: tick{std::max(options.tick, std::chrono::nanoseconds(1))}
+		, start{std::chrono::steady_clock::now()}
+		, wheel(std::max<std::size_t>(options.slots, 1))
+	{
+		timer = std::thread([this] { run_timer(); });
+
+		for (std::size_t i = 0; i < std::max<std::size_t>(options.threads, 1); ++i)
+		{
+			workers.emplace_back([this] { run_worker(); });
+		}
+	}
+
+	~state()
+	{
+		{
+			std::scoped_lock lock(mutex, queue_mutex);
+			stopping = true;
+		}
+
+		timer_wake.notify_all();
+		queue_ready.notify_all();
+
+		timer.join();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	/**
+	 * @brief Add a job to the wheel.
+	 *
+	 * @param[in] j      job
+	 * @param[in] period interval between runs
+	 */
+	auto add(job_ptr j, std::chrono::nanoseconds period) -> job_id
+	{
+		j->period = std::max<std::uint64_t>(static_cast<std::uint64_t>((period + tick - std::chrono::nanoseconds(1)) / tick), 1);
+
+		std::scoped_lock lock(mutex);
+
+		// The next tick to process is a tick in the future, so the first run is a period from now.
+		j->due = current_tick + j->period - 1;
+		wheel[j->due % wheel.size()].push_back(j);
+
+		job_id const id = next_id++;
+		jobs.emplace(id, std::move(j));
+
+		return id;
+	}
+
+	/**
+	 * @brief Advance the wheel every tick, and queue due jobs.
+	 */
+	auto run_timer() -> void
+	{
+		std::unique_lock lock(mutex);
+
+		std::vector<job_ptr> due;
+
+		while (!stopping)
+		{
+			if (timer_wake.wait_until(lock, start + tick * current_tick, [&] { return stopping; }))
+			{
+				break;
+			}
+
+			auto const          now      = std::chrono::steady_clock::now();
+			std::uint64_t const now_tick = static_cast<std::uint64_t>((now - start) / tick);
+
+			// Ticks that were missed while the thread was late are caught up on.
+			for (; current_tick <= now_tick; ++current_tick)
+			{
+				auto& slot = wheel[current_tick % wheel.size()];
+
+				for (std::size_t i = 0; i < slot.size();)
+				{
+					auto const j = slot[i];
+
+					if (j->cancelled)
+					{
+						slot[i] = std::move(slot.back());
+						slot.pop_back();
+						continue;
+					}
+
+					if (j->due != current_tick)
+					{
+						++i;
+						continue;
+					}
+
+					due.push_back(j);
+
+					// Occurrences missed entirely are skipped rather than run late in a burst.
+					for (j->due += j->period; j->due <= now_tick; j->due += j->period)
+					{
+						skipped.fetch_add(1, std::memory_order::relaxed);
+					}
+
+					if (j->due % wheel.size() != current_tick % wheel.size())
+					{
+						wheel[j->due % wheel.size()].push_back(j);
+
+						slot[i] = std::move(slot.back());
+						slot.pop_back();
+						continue;
+					}
+
+					++i;
+				}
+			}
+
+			lock.unlock();
+			dispatch(due);
+			due.clear();
+			lock.lock();
+		}
+	}
+
+	/**
+	 * @brief Group due jobs by handle and kind, and queue the groups for workers.
+	 *
+	 * @param[in] due due jobs
+	 */
+	auto dispatch(std::vector<job_ptr> const& due) -> void
+	{
+		std::map<std::pair<handle<Mode> const*, job_kind>, std::vector<job_ptr>> groups;
+
+		for (auto const& j : due)
+		{
+			if (j->running.exchange(true))
+			{
+				skipped.fetch_add(1, std::memory_order::relaxed);
+				continue;
+			}
+
+			if (j->kind == job_kind::call)
+			{
+				std::scoped_lock lock(queue_mutex);
+				queue.push_back({j});
+				continue;
+			}
+
+			groups[{j->h, j->kind}].push_back(j);
+		}
+
+		{
+			std::scoped_lock lock(queue_mutex);
+
+			for (auto& [key, group] : groups)
+			{
+				queue.push_back(std::move(group));
+			}
+		}
+
+		queue_ready.notify_all();
+	}
+
+	/**
+	 * @brief Run queued groups of jobs until stopped.
+	 */
+	auto run_worker() -> void
+	{
+		std::vector<memory_transfer> transfers;
+
+		while (true)
+		{
+			std::vector<job_ptr> group;
+
+			{
+				std::unique_lock lock(queue_mutex);
+				queue_ready.wait(lock, [&] { return stopping || !queue.empty(); });
+
+				if (stopping)
+				{
+					return;
+				}
+
+				group = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			run(group, transfers);
+
+			for (auto const& j : group)
+			{
+				j->running = false;
+			}
+		}
+	}
+
+	/**
+	 * @brief Run a group of jobs.
+	 *
+	 * Exceptions thrown by jobs are discarded, so that they do not stop the worker.
+	 *
+	 * @param[in]     group     jobs of the same kind against the same handle
+	 * @param[in,out] transfers reused transfer buffer
+	 */
+	auto run(std::vector<job_ptr> const& group, std::vector<memory_transfer>& transfers) -> void
+	{
+		auto const& first = *group.front();
+
+		if (first.kind == job_kind::call)
+		{
+			try
+			{
+				first.call();
+			}
+			catch (...)
+			{}
+
+			return;
+		}
+
+		transfers.clear();
+		for (auto const& j : group)
+		{
+			transfers.push_back({j->address, j->bytes.data(), j->bytes.size()});
+		}
+
+		WORM_PROBE(scheduler_group__entry, first.h->pid(), static_cast<int>(first.kind), transfers.size());
+
+		try
+		{
+			std::size_t transferred = 0;
+
+			if constexpr (handle_type::readable)
+			{
+				if (first.kind == job_kind::read)
+				{
+					transferred = first.h->read_bytes(transfers);
+				}
+			}
+
+			if constexpr (handle_type::writable)
+			{
+				if (first.kind == job_kind::write)
+				{
+					transferred = first.h->write_bytes(transfers);
+				}
+			}
+
+			WORM_PROBE(scheduler_group__return, first.h->pid(), static_cast<int>(first.kind), transfers.size(), transferred);
+		}
+		catch (std::system_error const&)
+		{
+			WORM_PROBE(scheduler_group__return, first.h->pid(), static_cast<int>(first.kind), transfers.size(), -1);
+
+			for (auto& t : transfers)
+			{
+				t.transferred = 0;
+			}
+		}
+
+		if (first.kind != job_kind::read)
+		{
+			return;
+		}
+
+		for (std::size_t i = 0; i < group.size(); ++i)
+		{
+			if (group[i]->cancelled)
+			{
+				continue;
+			}
+
+			try
+			{
+				group[i]->on_read(group[i]->bytes, transfers[i].transferred);
+			}
+			catch (...)
+			{}
+		}
+	}
+
+	std::chrono::nanoseconds              tick;
+	std::chrono::steady_clock::time_point start;
+
+	std::mutex                           mutex;
+	std::condition_variable              timer_wake;
+	std::vector<std::vector<job_ptr>>    wheel;
+	std::unordered_map<job_id, job_ptr>  jobs;
+	std::uint64_t                        current_tick = 1;
+	job_id                               next_id      = 1;
+	bool                                 stopping     = false;
+
+	std::mutex                       queue_mutex;
+	std::condition_variable          queue_ready;
+	std::deque<std::vector<job_ptr>> queue;
+
+	std::atomic<std::size_t> skipped = 0;
+
+	std::thread              timer;
+	std::vector<std::thread> workers;
+};
+
+template <handle_mode Mode>
+scheduler<Mode>::scheduler(scheduler_options const& options)
+	: state_{std::make_unique<state>(options)}
+{}
+
+template <handle_mode Mode>
+scheduler<Mode>::~scheduler() = default;
+
+template <handle_mode Mode>
+auto scheduler<Mode>::schedule(std::chrono::nanoseconds period, std::function<void()> job) -> job_id
+{
+	auto j  = std::make_shared<worm::job<Mode>>();
+	j->kind = job_kind::call;
+	j->call = std::move(job);
+
+	return state_->add(std::move(j), period);
+}
+
+template <handle_mode Mode>
+auto scheduler<Mode>::schedule_read(handle_type const& h, address_t addr, std::size_t size, std::chrono::nanoseconds period, read_callback on_read)
+	-> job_id
+	requires handle_type::readable
+{
+	auto j     = std::make_shared<job<Mode>>();
+	j->kind    = job_kind::read;
+	j->h       = &h;
+	j->address = addr;
+	j->bytes.resize(size);
+	j->on_read = std::move(on_read);
+
+	return state_->add(std::move(j), period);
+}
+
+template <handle_mode Mode>
+auto scheduler<Mode>::schedule_write(handle_type const& h, address_t addr, std::vector<unsigned char> bytes, std::chrono::nanoseconds period) -> job_id
+	requires handle_type::writable
+{
+	auto j     = std::make_shared<job<Mode>>();
+	j->kind    = job_kind::write;
+	j->h       = &h;
+	j->address = addr;
+	j->bytes   = std::move(bytes);
+
+	return state_->add(std::move(j), period);
+}
+
+template <handle_mode Mode>
+auto scheduler<Mode>::cancel(job_id id) -> bool
+{
+	std::scoped_lock lock(state_->mutex);
+
+	auto const it = state_->jobs.find(id);
+	if (it == state_->jobs.end())
+	{
+		return false;
+	}
+
+	// Jobs are removed from the wheel lazily, when their slot comes up.
+	it->second->cancelled = true;
+	state_->jobs.erase(it);
+
+	return true;
+}
+
+template <handle_mode Mode>
+auto scheduler<Mode>::skipped() const noexcept -> std::size_t
+{
+	return state_->skipped.load(std::memory_order::relaxed);
+}
+
+template struct scheduler<handle_mode::in>;
+template struct scheduler<handle_mode::out>;
+template struct scheduler<handle_mode::in | handle_mode::out>;
+}
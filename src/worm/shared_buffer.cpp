@@ -0,0 +1,570 @@
+#include "platform.hpp"
+
+#include "worm/shared_buffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+
+#if defined(WORM_POSIX)
+
+#	include <filesystem>
+#	include <optional>
+#	include <string>
+#	include <vector>
+
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/ptrace.h>
+#	include <sys/syscall.h>
+#	include <sys/user.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+
+#	ifdef __cpp_lib_format
+#		include <format>
+#	endif
+
+#elif defined(WORM_WINDOWS)
+
+#	include <sysinfoapi.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+/// Get size of a virtual memory page.
+[[nodiscard]]
+auto page_size() noexcept -> std::size_t
+{
+#if defined(WORM_POSIX)
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(WORM_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#endif
+}
+
+#if defined(WORM_POSIX) && defined(__x86_64__)
+/// Thread stopped by a tracer.
+struct stopped_thread
+{
+	/// Thread ID.
+	::pid_t tid;
+
+	/// Signal that was pending when the thread stopped, to be delivered on detach.
+	int pending_signal = 0;
+};
+
+/**
+ * @brief Seize and stop a thread.
+ *
+ * @param[in] tid thread ID
+ *
+ * @return stopped thread, or `std::nullopt` if the thread exited
+ *
+ * @throws `std::system_error` on failure to attach to a live thread
+ */
+[[nodiscard]]
+auto stop_thread(::pid_t tid) -> std::optional<stopped_thread>
+{
+	if (ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) == -1)
+	{
+		if (errno == ESRCH)
+		{
+			return std::nullopt;
+		}
+
+		throw make_system_error("failed to attach to the process");
+	}
+
+	int status;
+	if (ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) == -1 || waitpid(tid, &status, __WALL) != tid)
+	{
+		auto error = make_system_error("failed to stop the process");
+		ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+		throw error;
+	}
+
+	if (!WIFSTOPPED(status))
+	{
+		return std::nullopt;
+	}
+
+	stopped_thread thread{tid};
+
+	// The thread may stop for a signal before the interrupt takes effect.
+	if (status >> 16 == 0 && WSTOPSIG(status) != SIGTRAP)
+	{
+		thread.pending_signal = WSTOPSIG(status);
+	}
+
+	return thread;
+}
+
+/**
+ * @brief Injector of system calls into a process.
+ *
+ * It stops every thread of the process for its lifetime, and executes system
+ * calls on behalf of the main thread by temporarily placing a `syscall`
+ * instruction at its instruction pointer. Other threads are stopped so that
+ * none of them runs the injected code, which usually lies in shared code such
+ * as a system call wrapper.
+ */
+struct syscall_injector
+{
+	/// Traced thread ID.
+	::pid_t const tid;
+
+	/// Stopped threads, the first of which is the traced one.
+	std::vector<stopped_thread> threads;
+
+	/// Registers of the thread before injection.
+	user_regs_struct saved_regs{};
+
+	/// Instruction bytes replaced by the injected code.
+	long saved_code = 0;
+
+	/**
+	 * @brief Attach to a process and prepare it for injection.
+	 *
+	 * @param[in] pid process ID
+	 *
+	 * @throws `std::system_error` on failure to attach
+	 */
+	explicit syscall_injector(::pid_t pid)
+		: tid{pid}
+	{
+		if (auto thread = stop_thread(tid))
+		{
+			threads.push_back(*thread);
+		}
+		else
+		{
+			throw std::system_error(std::make_error_code(std::errc::no_such_process), "failed to attach to the process");
+		}
+
+		try
+		{
+			stop_other_threads();
+		}
+		catch (...)
+		{
+			detach();
+			throw;
+		}
+
+		if (ptrace(PTRACE_GETREGS, tid, nullptr, &saved_regs) == -1)
+		{
+			auto error = make_system_error("failed to get registers of the process");
+			detach();
+			throw error;
+		}
+
+		errno      = 0;
+		saved_code = ptrace(PTRACE_PEEKTEXT, tid, saved_regs.rip, nullptr);
+
+		// `syscall`, followed by a name for memory file descriptors.
+		static constexpr unsigned char code[sizeof(long)]{0x0f, 0x05, 'w', 'o', 'r', 'm', 0, 0};
+
+		long code_word;
+		std::memcpy(&code_word, code, sizeof(code_word));
+
+		if (errno || ptrace(PTRACE_POKETEXT, tid, saved_regs.rip, code_word) == -1)
+		{
+			auto error = make_system_error("failed to inject code into the process");
+			detach();
+			throw error;
+		}
+	}
+
+	syscall_injector(syscall_injector const&)                    = delete;
+	auto operator=(syscall_injector const&) -> syscall_injector& = delete;
+
+	/**
+	 * @brief Restore the process and detach from it.
+	 */
+	~syscall_injector()
+	{
+		ptrace(PTRACE_POKETEXT, tid, saved_regs.rip, saved_code);
+		ptrace(PTRACE_SETREGS, tid, nullptr, &saved_regs);
+		detach();
+	}
+
+	/**
+	 * @brief Stop all threads of the process other than the traced one.
+	 *
+	 * Threads are listed again until no new ones appear, since threads that are
+	 * still running may spawn more of them.
+	 *
+	 * @throws `std::system_error` on failure to list or stop threads
+	 */
+	auto stop_other_threads() -> void
+	{
+		std::string const task_path = "/proc/" + std::to_string(tid) + "/task";
+
+		for (bool found = true; found;)
+		{
+			found = false;
+
+			std::error_code                     ec;
+			std::filesystem::directory_iterator tasks(task_path, ec);
+
+			if (ec)
+			{
+				throw std::system_error(ec, "failed to list threads of the process");
+			}
+
+			for (auto const& task : tasks)
+			{
+				::pid_t const other = static_cast<::pid_t>(std::stol(task.path().filename().string()));
+
+				if (std::ranges::any_of(threads, [&](auto const& t) { return t.tid == other; }))
+				{
+					continue;
+				}
+
+				if (auto thread = stop_thread(other))
+				{
+					threads.push_back(*thread);
+					found = true;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Resume all stopped threads, delivering their pending signals.
+	 */
+	auto detach() noexcept -> void
+	{
+		for (auto const& thread : threads)
+		{
+			ptrace(PTRACE_DETACH, thread.tid, nullptr, thread.pending_signal);
+		}
+
+		threads.clear();
+	}
+
+	/**
+	 * @brief Get remote address of the name for memory file descriptors.
+	 */
+	[[nodiscard]]
+	auto name() const noexcept -> address_t
+	{
+		return saved_regs.rip + 2;
+	}
+
+	/**
+	 * @brief Execute a system call in the process.
+	 *
+	 * @param[in] number system call number
+	 * @param[in] args   system call arguments
+	 *
+	 * @throws `std::system_error` on failure to execute the system call, or if it failed
+	 *
+	 * @return result of the system call
+	 */
+	auto call(long number, std::initializer_list<unsigned long long> args) -> unsigned long long
+	{
+		user_regs_struct regs = saved_regs;
+
+		// The thread may have been stopped in a system call, which must not be
+		// restarted in place of the injected one.
+		regs.orig_rax = static_cast<unsigned long long>(-1);
+		regs.rax      = static_cast<unsigned long long>(number);
+
+		unsigned long long* const arg_regs[]{&regs.rdi, &regs.rsi, &regs.rdx, &regs.r10, &regs.r8, &regs.r9};
+
+		std::size_t i = 0;
+		for (auto const arg : args)
+		{
+			*arg_regs[i++] = arg;
+		}
+
+		if (ptrace(PTRACE_SETREGS, tid, nullptr, &regs) == -1)
+		{
+			throw make_system_error("failed to inject a system call into the process");
+		}
+
+		// A signal may stop the thread before the step completes, in which case
+		// it is kept for delivery on detach and the step is retried.
+		while (true)
+		{
+			int status;
+			if (ptrace(PTRACE_SINGLESTEP, tid, nullptr, nullptr) == -1 || waitpid(tid, &status, __WALL) != tid)
+			{
+				throw make_system_error("failed to inject a system call into the process");
+			}
+
+			if (!WIFSTOPPED(status))
+			{
+				threads.erase(threads.begin());
+				throw std::system_error(std::make_error_code(std::errc::no_such_process), "process exited during an injected system call");
+			}
+
+			if (WSTOPSIG(status) == SIGTRAP)
+			{
+				break;
+			}
+
+			if (status >> 16 == 0 && !threads.front().pending_signal)
+			{
+				threads.front().pending_signal = WSTOPSIG(status);
+			}
+		}
+
+		if (ptrace(PTRACE_GETREGS, tid, nullptr, &regs) == -1)
+		{
+			throw make_system_error("failed to inject a system call into the process");
+		}
+
+		// Anything other than a step over the injected instruction leaves the result meaningless.
+		if (regs.rip != saved_regs.rip + 2)
+		{
+			throw std::system_error(std::make_error_code(std::errc::interrupted), "injected system call did not complete");
+		}
+
+		auto const result = static_cast<long long>(regs.rax);
+		if (result < 0 && result >= -4095)
+		{
+			throw std::system_error(static_cast<int>(-result), std::system_category(), "injected system call failed");
+		}
+
+		return regs.rax;
+	}
+};
+#endif
+}
+
+template <handle_mode Mode>
+struct shared_buffer<Mode>::state
+{
+	/// Process ID.
+	pid_t const pid;
+
+	/// Number of bytes in shared pages.
+	std::size_t const length;
+
+	/// Local address of the first shared page.
+	unsigned char* local = nullptr;
+
+	/// Remote virtual memory address of the first shared page.
+	address_t remote = 0;
+
+#ifdef WORM_WINDOWS
+	/// File mapping handle.
+	void* mapping{};
+
+	/// Process handle.
+	void* process{};
+#endif
+
+	state(handle_type const& h, std::size_t size)
+		: pid{h.pid()}
+		, length{(std::max<std::size_t>(size, 1) + page_size() - 1) & ~(page_size() - 1)}
+	{
+#if defined(WORM_POSIX) && defined(__x86_64__)
+		auto const remote_pid = static_cast<::pid_t>(pid);
+
+		syscall_injector injector(remote_pid);
+
+		auto const remote_fd = injector.call(SYS_memfd_create, {injector.name(), MFD_CLOEXEC});
+
+		// The memory file is opened locally through the remote descriptor, so
+		// that it is sized and mapped without further injection.
+		int const local_fd = open(
+#	ifdef __cpp_lib_format
+			std::format("/proc/{}/fd/{}", pid, remote_fd).c_str(),
+#	else
+			("/proc/" + std::to_string(pid) + "/fd/" + std::to_string(remote_fd)).c_str(),
+#	endif
+			O_RDWR | O_CLOEXEC
+		);
+
+		if (local_fd == -1 || ftruncate(local_fd, static_cast<off_t>(length)) == -1)
+		{
+			auto error = make_system_error("failed to open the shared memory file");
+			if (local_fd != -1)
+			{
+				close(local_fd);
+			}
+
+			injector.call(SYS_close, {remote_fd});
+			throw error;
+		}
+
+		void* const addr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, local_fd, 0);
+		close(local_fd);
+
+		if (addr == MAP_FAILED)
+		{
+			auto error = make_system_error("failed to map a shared buffer");
+			injector.call(SYS_close, {remote_fd});
+			throw error;
+		}
+
+		local = static_cast<unsigned char*>(addr);
+
+		try
+		{
+			remote = injector.call(SYS_mmap, {0, length, PROT_READ | PROT_WRITE, MAP_SHARED, remote_fd, 0});
+		}
+		catch (...)
+		{
+			munmap(local, length);
+			injector.call(SYS_close, {remote_fd});
+			throw;
+		}
+
+		// The mapping keeps the memory file alive in the process, so failing to
+		// close the descriptor only leaks it.
+		try
+		{
+			injector.call(SYS_close, {remote_fd});
+		}
+		catch (std::system_error const&)
+		{}
+#elif defined(WORM_POSIX)
+		throw std::system_error(std::make_error_code(std::errc::function_not_supported), "shared buffers are only supported on x86-64");
+#elif defined(WORM_WINDOWS)
+		mapping = CreateFileMappingW(
+			INVALID_HANDLE_VALUE,
+			nullptr,
+			PAGE_READWRITE,
+			static_cast<DWORD>(static_cast<std::uint64_t>(length) >> 32),
+			static_cast<DWORD>(length),
+			nullptr
+		);
+
+		if (!mapping)
+		{
+			throw make_system_error("failed to create a file mapping");
+		}
+
+		local   = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, length));
+		process = OpenProcess(PROCESS_VM_OPERATION, false, static_cast<DWORD>(pid));
+
+		if (!local || !process)
+		{
+			auto error = make_system_error("failed to map a shared buffer");
+			release();
+			throw error;
+		}
+
+		remote = reinterpret_cast<address_t>(MapViewOfFile2(mapping, process, 0, nullptr, 0, 0, PAGE_READWRITE));
+
+		if (!remote)
+		{
+			auto error = make_system_error("failed to map a shared buffer into the process");
+			release();
+			throw error;
+		}
+#endif
+	}
+
+	state(state const&)                    = delete;
+	auto operator=(state const&) -> state& = delete;
+
+	~state()
+	{
+		release();
+	}
+
+	/// Release the local and the remote mapping.
+	auto release() noexcept -> void
+	{
+#if defined(WORM_POSIX) && defined(__x86_64__)
+		if (remote)
+		{
+			try
+			{
+				syscall_injector injector(static_cast<::pid_t>(pid));
+				injector.call(SYS_munmap, {remote, length});
+			}
+			catch (std::system_error const&)
+			{}
+		}
+
+		if (local)
+		{
+			munmap(local, length);
+		}
+#elif defined(WORM_WINDOWS)
+		if (remote)
+		{
+			UnmapViewOfFile2(process, reinterpret_cast<void*>(remote), 0);
+		}
+
+		if (local)
+		{
+			UnmapViewOfFile(local);
+		}
+
+		if (process)
+		{
+			CloseHandle(process);
+		}
+
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+#endif
+	}
+};
+
+template <handle_mode Mode>
+shared_buffer<Mode>::shared_buffer(handle_type const& h, std::size_t size)
+	requires(handle_type::readable && handle_type::writable)
+	: state_{std::make_unique<state>(h, size)}
+	, addr_{state_->remote}
+	, size_{state_->length}
+{}
+
+template <handle_mode Mode>
+shared_buffer<Mode>::shared_buffer(shared_buffer&&) noexcept = default;
+
+template <handle_mode Mode>
+auto shared_buffer<Mode>::operator=(shared_buffer&&) noexcept -> shared_buffer& = default;
+
+template <handle_mode Mode>
+shared_buffer<Mode>::~shared_buffer() = default;
+
+template <handle_mode Mode>
+auto shared_buffer<Mode>::data() const noexcept -> void*
+{
+	return state_->local;
+}
+
+template <handle_mode Mode>
+auto shared_buffer<Mode>::address() const noexcept -> address_t
+{
+	return addr_;
+}
+
+template <handle_mode Mode>
+auto shared_buffer<Mode>::size() const noexcept -> std::size_t
+{
+	return size_;
+}
+
+template <handle_mode Mode>
+auto shared_buffer<Mode>::remote(void const* ptr) const noexcept -> address_t
+{
+	auto const* const p = static_cast<unsigned char const*>(ptr);
+	if (p < state_->local || static_cast<std::size_t>(p - state_->local) >= size_)
+	{
+		return 0;
+	}
+
+	return addr_ + static_cast<address_t>(p - state_->local);
+}
+
+template struct shared_buffer<handle_mode::in | handle_mode::out>;
+}
@@ -0,0 +1,410 @@
+#include "simd.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace worm::simd
+{
+namespace
+{
+#if defined(__GNUC__) || defined(__clang__)
+#	define WORM_HAVE_LANES
+
+/// Four addresses compared at once.
+using lanes = address_t __attribute__((vector_size(4 * sizeof(address_t))));
+#endif
+
+/// Ratio of sequence sizes above which galloping through the larger one is faster than merging.
+constexpr std::size_t gallop_ratio = 32;
+
+/**
+ * @brief Find the first element that is not less than a value by galloping.
+ *
+ * @param[in] s     sorted sequence
+ * @param[in] from  index to start from
+ * @param[in] value value
+ */
+[[nodiscard]]
+auto gallop(std::span<address_t const> s, std::size_t from, address_t value) noexcept -> std::size_t
+{
+	std::size_t lo   = from;
+	std::size_t hi   = from;
+	std::size_t step = 1;
+
+	while (hi < s.size() && s[hi] < value)
+	{
+		lo = hi + 1;
+		hi += step;
+		step <<= 1;
+	}
+
+	return static_cast<std::size_t>(std::lower_bound(s.data() + lo, s.data() + std::min(hi, s.size()), value) - s.data());
+}
+
+/**
+ * @brief Filter a sorted sequence by membership in another one.
+ *
+ * Blocks of four addresses of both sequences are compared all against all,
+ * and the block with the lower last address is advanced.
+ *
+ * @tparam Keep whether to keep members or non-members
+ *
+ * @param[in]  lhs filtered sequence
+ * @param[in]  rhs sequence to test membership in
+ * @param[out] out output
+ *
+ * @return number of written addresses
+ */
+template <bool Keep>
+[[gnu::always_inline]]
+inline auto filter(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t
+{
+	std::size_t i = 0;
+	std::size_t j = 0;
+	std::size_t n = 0;
+
+	// Members of the current left-hand side block found so far.
+	unsigned    found = 0;
+	std::size_t block = 0;
+
+#ifdef WORM_HAVE_LANES
+	while (i + 4 <= lhs.size() && j + 4 <= rhs.size())
+	{
+		lanes l;
+		std::memcpy(&l, lhs.data() + i, sizeof(l));
+
+		auto const eq = (l == rhs[j]) | (l == rhs[j + 1]) | (l == rhs[j + 2]) | (l == rhs[j + 3]);
+
+		found |= (eq[0] ? 1u : 0u) | (eq[1] ? 2u : 0u) | (eq[2] ? 4u : 0u) | (eq[3] ? 8u : 0u);
+
+		address_t const lhs_last = lhs[i + 3];
+		address_t const rhs_last = rhs[j + 3];
+
+		if (lhs_last <= rhs_last)
+		{
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				if (static_cast<bool>((found >> k) & 1) == Keep)
+				{
+					out[n++] = lhs[i + k];
+				}
+			}
+
+			found = 0;
+			i += 4;
+			block = i;
+		}
+
+		if (rhs_last <= lhs_last)
+		{
+			j += 4;
+		}
+	}
+#endif
+
+	for (; i < lhs.size(); ++i)
+	{
+		while (j < rhs.size() && rhs[j] < lhs[i])
+		{
+			++j;
+		}
+
+		bool const carried = i - block < 4 && ((found >> (i - block)) & 1);
+		bool const member  = carried || (j < rhs.size() && rhs[j] == lhs[i]);
+
+		if (member == Keep)
+		{
+			out[n++] = lhs[i];
+		}
+	}
+
+	return n;
+}
+}
+
+WORM_SIMD_CLONES
+auto intersect(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t
+{
+	if (lhs.size() > rhs.size())
+	{
+		std::swap(lhs, rhs);
+	}
+
+	if (lhs.size() * gallop_ratio < rhs.size())
+	{
+		std::size_t n = 0;
+		std::size_t j = 0;
+
+		for (auto const addr : lhs)
+		{
+			j = gallop(rhs, j, addr);
+			if (j == rhs.size())
+			{
+				break;
+			}
+
+			if (rhs[j] == addr)
+			{
+				out[n++] = addr;
+			}
+		}
+
+		return n;
+	}
+
+	return filter<true>(lhs, rhs, out);
+}
+
+WORM_SIMD_CLONES
+auto subtract(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t
+{
+	if (rhs.size() * gallop_ratio < lhs.size())
+	{
+		// Runs of the left-hand side between subtracted addresses are copied whole.
+		std::size_t n = 0;
+		std::size_t i = 0;
+
+		for (auto const addr : rhs)
+		{
+			std::size_t const k = gallop(lhs, i, addr);
+
+			std::copy(lhs.data() + i, lhs.data() + k, out + n);
+			n += k - i;
+
+			i = k < lhs.size() && lhs[k] == addr ? k + 1 : k;
+		}
+
+		std::copy(lhs.data() + i, lhs.data() + lhs.size(), out + n);
+		return n + (lhs.size() - i);
+	}
+
+	if (lhs.size() * gallop_ratio < rhs.size())
+	{
+		std::size_t n = 0;
+		std::size_t j = 0;
+
+		for (auto const addr : lhs)
+		{
+			j = gallop(rhs, j, addr);
+			if (j == rhs.size() || rhs[j] != addr)
+			{
+				out[n++] = addr;
+			}
+		}
+
+		return n;
+	}
+
+	return filter<false>(lhs, rhs, out);
+}
+
+WORM_SIMD_CLONES
+auto unite(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t
+{
+	std::size_t i = 0;
+	std::size_t j = 0;
+	std::size_t n = 0;
+
+	// Both sequences advance past equal addresses, so the merge needs no branches.
+	while (i < lhs.size() && j < rhs.size())
+	{
+		address_t const l = lhs[i];
+		address_t const r = rhs[j];
+
+		out[n++] = std::min(l, r);
+		i += l <= r;
+		j += r <= l;
+	}
+
+	n = static_cast<std::size_t>(std::copy(lhs.data() + i, lhs.data() + lhs.size(), out + n) - out);
+	n = static_cast<std::size_t>(std::copy(rhs.data() + j, rhs.data() + rhs.size(), out + n) - out);
+
+	return n;
+}
+
+WORM_SIMD_CLONES
+auto and_words(std::uint64_t* dst, std::uint64_t const* src, std::size_t n) noexcept -> void
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		dst[i] &= src[i];
+	}
+}
+
+WORM_SIMD_CLONES
+auto andnot_words(std::uint64_t* dst, std::uint64_t const* src, std::size_t n) noexcept -> void
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		dst[i] &= ~src[i];
+	}
+}
+
+WORM_SIMD_CLONES
+auto popcount(std::uint64_t const* words, std::size_t n) noexcept -> std::size_t
+{
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		count += static_cast<std::size_t>(std::popcount(words[i]));
+	}
+
+	return count;
+}
+
+auto extract_bits(std::span<std::uint64_t const> src, std::size_t first, std::size_t count, std::uint64_t* dst) noexcept -> void
+{
+	std::size_t const words = (count + 63) / 64;
+	std::size_t const word  = first / 64;
+	std::size_t const shift = first % 64;
+
+	for (std::size_t k = 0; k < words; ++k)
+	{
+		std::uint64_t const lo = word + k < src.size() ? src[word + k] >> shift : 0;
+		std::uint64_t const hi = shift && word + k + 1 < src.size() ? src[word + k + 1] << (64 - shift) : 0;
+
+		dst[k] = lo | hi;
+	}
+
+	if (count % 64)
+	{
+		dst[words - 1] &= (std::uint64_t{1} << (count % 64)) - 1;
+	}
+}
+
+auto deposit_bits(std::span<std::uint64_t> dst, std::size_t first, std::uint64_t const* src, std::size_t count) noexcept -> void
+{
+	std::size_t const words = (count + 63) / 64;
+	std::size_t const word  = first / 64;
+	std::size_t const shift = first % 64;
+
+	for (std::size_t k = 0; k < words && word + k < dst.size(); ++k)
+	{
+		std::uint64_t bits = src[k];
+		if (k + 1 == words && count % 64)
+		{
+			bits &= (std::uint64_t{1} << (count % 64)) - 1;
+		}
+
+		dst[word + k] |= bits << shift;
+
+		if (shift && word + k + 1 < dst.size())
+		{
+			dst[word + k + 1] |= bits >> (64 - shift);
+		}
+	}
+}
+
+WORM_SIMD_CLONES
+auto find_in_range(std::span<unsigned char const> data, address_t lo, address_t size, std::size_t* out) noexcept -> std::size_t
+{
+	std::size_t const words = data.size() / sizeof(address_t);
+
+	std::size_t i = 0;
+	std::size_t n = 0;
+
+	// A single unsigned comparison of the distance from the least address
+	// tests both bounds.
+#ifdef WORM_HAVE_LANES
+	for (; i + 4 <= words; i += 4)
+	{
+		lanes w;
+		std::memcpy(&w, data.data() + i * sizeof(address_t), sizeof(w));
+
+		auto const in = (w - lo) < size;
+
+		// Hits are rare, so blocks without any are skipped with one branch.
+		if (in[0] | in[1] | in[2] | in[3])
+		{
+			for (std::size_t k = 0; k < 4; ++k)
+			{
+				out[n] = (i + k) * sizeof(address_t);
+				n += in[k] ? 1 : 0;
+			}
+		}
+	}
+#endif
+
+	for (; i < words; ++i)
+	{
+		address_t w;
+		std::memcpy(&w, data.data() + i * sizeof(address_t), sizeof(w));
+
+		out[n] = i * sizeof(address_t);
+		n += w - lo < size ? 1 : 0;
+	}
+
+	return n;
+}
+
+WORM_SIMD_CLONES
+auto contained(std::span<address_t const> begins, std::span<address_t const> ends, std::span<address_t const> addrs, std::uint64_t* bits) noexcept
+	-> void
+{
+	// Addresses are searched for in blocks, so that the loads of independent
+	// searches overlap, and every search takes the same number of steps.
+	constexpr std::size_t block = 8;
+
+	std::fill_n(bits, (addrs.size() + 63) / 64, std::uint64_t{0});
+
+	if (begins.empty())
+	{
+		return;
+	}
+
+	for (std::size_t i = 0; i < addrs.size(); i += block)
+	{
+		std::size_t const count = std::min(block, addrs.size() - i);
+
+		std::size_t base[block] = {};
+
+		for (std::size_t n = begins.size(); n > 1; n -= n / 2)
+		{
+			std::size_t const half = n / 2;
+
+			for (std::size_t k = 0; k < count; ++k)
+			{
+				base[k] = begins[base[k] + half] <= addrs[i + k] ? base[k] + half : base[k];
+			}
+		}
+
+		for (std::size_t k = 0; k < count; ++k)
+		{
+			address_t const addr = addrs[i + k];
+			bool const      in   = begins[base[k]] <= addr && addr < ends[base[k]];
+
+			bits[(i + k) / 64] |= std::uint64_t{in} << ((i + k) % 64);
+		}
+	}
+}
+
+auto hash_page(unsigned char const* data, std::size_t size) noexcept -> std::uint64_t
+{
+	static constexpr std::uint64_t multiplier = 0x9e37'79b9'7f4a'7c15;
+
+	// Independent lanes let the multiplications overlap.
+	std::uint64_t lanes[4]{size, ~size, multiplier, ~multiplier};
+
+	std::size_t i = 0;
+	for (; i + sizeof(lanes) <= size; i += sizeof(lanes))
+	{
+		for (std::size_t lane = 0; lane < std::size(lanes); ++lane)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, data + i + lane * sizeof(word), sizeof(word));
+
+			lanes[lane] = (lanes[lane] ^ word) * multiplier;
+			lanes[lane] ^= lanes[lane] >> 29;
+		}
+	}
+
+	std::uint64_t hash = lanes[0] ^ (lanes[1] << 1) ^ (lanes[2] << 2) ^ (lanes[3] << 3);
+	for (; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * multiplier;
+	}
+
+	return hash ^ (hash >> 31);
+}
+}
@@ -0,0 +1,144 @@
+#ifndef WORM_SIMD_HPP
+#define WORM_SIMD_HPP
+
+#include "worm/worm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Compile a kernel for several instruction sets, one of which is picked at load time.
+ *
+ * It relies on indirect functions, so it is only enabled for glibc on x86-64.
+ */
+#if defined(__x86_64__) && defined(__GLIBC__) && (defined(__GNUC__) || defined(__clang__))
+#	define WORM_SIMD_CLONES [[gnu::target_clones("avx2", "default")]]
+#else
+#	define WORM_SIMD_CLONES
+#endif
+
+/**
+ * @brief Kernels of set operations, memory scans and hashing.
+ *
+ * Sorted sequences must be strictly ascending. Output buffers must not alias inputs.
+ */
+namespace worm::simd
+{
+/**
+ * @brief Intersect sorted sequences.
+ *
+ * @param[in]  lhs left-hand side sequence
+ * @param[in]  rhs right-hand side sequence
+ * @param[out] out output, at least as large as the smaller sequence
+ *
+ * @return number of written addresses
+ */
+auto intersect(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t;
+
+/**
+ * @brief Subtract a sorted sequence from another one.
+ *
+ * @param[in]  lhs left-hand side sequence
+ * @param[in]  rhs right-hand side sequence
+ * @param[out] out output, at least as large as the left-hand side sequence
+ *
+ * @return number of written addresses
+ */
+auto subtract(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t;
+
+/**
+ * @brief Unite sorted sequences.
+ *
+ * @param[in]  lhs left-hand side sequence
+ * @param[in]  rhs right-hand side sequence
+ * @param[out] out output, at least as large as both sequences together
+ *
+ * @return number of written addresses
+ */
+auto unite(std::span<address_t const> lhs, std::span<address_t const> rhs, address_t* out) noexcept -> std::size_t;
+
+/**
+ * @brief Bitwise AND words into destination words.
+ *
+ * @param[in,out] dst destination words
+ * @param[in]     src source words
+ * @param[in]     n   number of words
+ */
+auto and_words(std::uint64_t* dst, std::uint64_t const* src, std::size_t n) noexcept -> void;
+
+/**
+ * @brief Clear bits of destination words that are set in source words.
+ *
+ * @param[in,out] dst destination words
+ * @param[in]     src source words
+ * @param[in]     n   number of words
+ */
+auto andnot_words(std::uint64_t* dst, std::uint64_t const* src, std::size_t n) noexcept -> void;
+
+/**
+ * @brief Count set bits of words.
+ *
+ * @param[in] words words
+ * @param[in] n     number of words
+ */
+[[nodiscard]]
+auto popcount(std::uint64_t const* words, std::size_t n) noexcept -> std::size_t;
+
+/**
+ * @brief Copy bits starting at an arbitrary bit into words.
+ *
+ * @param[in]  src   source words
+ * @param[in]  first index of the first copied bit
+ * @param[in]  count number of bits to copy
+ * @param[out] dst   destination words, at least `(count + 63) / 64` large, of which unused bits are cleared
+ */
+auto extract_bits(std::span<std::uint64_t const> src, std::size_t first, std::size_t count, std::uint64_t* dst) noexcept -> void;
+
+/**
+ * @brief Bitwise OR words into destination words starting at an arbitrary bit.
+ *
+ * @param[in,out] dst   destination words
+ * @param[in]     first index of the first destination bit
+ * @param[in]     src   source words
+ * @param[in]     count number of bits to OR
+ */
+auto deposit_bits(std::span<std::uint64_t> dst, std::size_t first, std::uint64_t const* src, std::size_t count) noexcept -> void;
+
+/**
+ * @brief Find addresses within a range among consecutive words of bytes.
+ *
+ * Words need not be aligned in memory. Trailing bytes that do not make up a
+ * whole word are ignored.
+ *
+ * @param[in]  data bytes
+ * @param[in]  lo   least address of the range
+ * @param[in]  size number of addresses in the range
+ * @param[out] out  byte offsets of words within the range, at least as many as there are words
+ *
+ * @return number of written offsets
+ */
+auto find_in_range(std::span<unsigned char const> data, address_t lo, address_t size, std::size_t* out) noexcept -> std::size_t;
+
+/**
+ * @brief Check which addresses lie in any of disjoint ranges.
+ *
+ * @param[in]  begins first addresses of ranges, strictly ascending
+ * @param[in]  ends   past-the-end addresses of ranges
+ * @param[in]  addrs  addresses to check
+ * @param[out] bits   bitmap with a bit per address, at least `(addrs.size() + 63) / 64` words large, which is overwritten
+ */
+auto contained(std::span<address_t const> begins, std::span<address_t const> ends, std::span<address_t const> addrs, std::uint64_t* bits) noexcept
+	-> void;
+
+/**
+ * @brief Hash a page.
+ *
+ * @param[in] data page data
+ * @param[in] size page size
+ */
+[[nodiscard]]
+auto hash_page(unsigned char const* data, std::size_t size) noexcept -> std::uint64_t;
+}
+
+#endif
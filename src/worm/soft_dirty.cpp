@@ -0,0 +1,188 @@
+#include "soft_dirty.hpp"
+
+#include "platform.hpp"
+
+#include <utility>
+
+#if defined(WORM_POSIX)
+
+#	include <string>
+
+#	include <fcntl.h>
+#	include <unistd.h>
+
+#	ifdef __cpp_lib_format
+#		include <format>
+#	endif
+
+#endif
+
+namespace worm
+{
+namespace
+{
+#ifdef WORM_POSIX
+/// Soft-dirty bit of a pagemap entry.
+constexpr std::uint64_t soft_dirty_bit = std::uint64_t{1} << 55;
+
+/**
+ * @brief Open a file of a process in procfs.
+ *
+ * @param[in] pid   process id
+ * @param[in] name  file name
+ * @param[in] flags open flags
+ *
+ * @throws `std::system_error` on failure to open the file
+ */
+[[nodiscard]]
+auto open_proc(pid_t pid, char const* name, int flags) -> int
+{
+	int const fd = open(
+#	ifdef __cpp_lib_format
+		std::format("/proc/{}/{}", pid, name).c_str(),
+#	else
+		("/proc/" + std::to_string(pid) + "/" + name).c_str(),
+#	endif
+		flags | O_CLOEXEC
+	);
+
+	if (fd < 0)
+	{
+		throw make_system_error("failed to open soft-dirty bits");
+	}
+
+	return fd;
+}
+#endif
+}
+
+soft_dirty_tracker::soft_dirty_tracker([[maybe_unused]] pid_t pid)
+{
+#if defined(WORM_POSIX)
+	clear_refs_ = open_proc(pid, "clear_refs", O_WRONLY);
+
+	try
+	{
+		pagemap_ = open_proc(pid, "pagemap", O_RDONLY);
+	}
+	catch (std::system_error const&)
+	{
+		close(clear_refs_);
+		throw;
+	}
+#elif defined(WORM_WINDOWS)
+	throw std::system_error(std::make_error_code(std::errc::function_not_supported), "soft-dirty bits are only supported on Linux");
+#endif
+}
+
+soft_dirty_tracker::soft_dirty_tracker(soft_dirty_tracker&& other) noexcept
+	: clear_refs_{std::exchange(other.clear_refs_, -1)}
+	, pagemap_{std::exchange(other.pagemap_, -1)}
+	, entries_{std::move(other.entries_)}
+{}
+
+auto soft_dirty_tracker::operator=(soft_dirty_tracker&& other) noexcept -> soft_dirty_tracker&
+{
+	std::swap(clear_refs_, other.clear_refs_);
+	std::swap(pagemap_, other.pagemap_);
+	std::swap(entries_, other.entries_);
+
+	return *this;
+}
+
+soft_dirty_tracker::~soft_dirty_tracker()
+{
+#ifdef WORM_POSIX
+	if (clear_refs_ >= 0)
+	{
+		close(clear_refs_);
+	}
+
+	if (pagemap_ >= 0)
+	{
+		close(pagemap_);
+	}
+#endif
+}
+
+auto soft_dirty_tracker::page_size() noexcept -> std::size_t
+{
+#ifdef WORM_POSIX
+	static std::size_t const size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	return size;
+#else
+	return 4096;
+#endif
+}
+
+auto soft_dirty_tracker::clear() -> void
+{
+#ifdef WORM_POSIX
+	static constexpr char command[] = "4";
+
+	if (pwrite(clear_refs_, command, sizeof(command) - 1, 0) < 0)
+	{
+		throw make_system_error("failed to clear soft-dirty bits");
+	}
+#endif
+}
+
+auto soft_dirty_tracker::dirty(address_t addr, std::size_t size) -> bool
+{
+#ifdef WORM_POSIX
+	if (!read_entries(addr, size))
+	{
+		return true;
+	}
+
+	for (auto const entry : entries_)
+	{
+		if (entry & soft_dirty_bit)
+		{
+			return true;
+		}
+	}
+
+	return false;
+#else
+	return true;
+#endif
+}
+
+auto soft_dirty_tracker::dirty_pages(address_t addr, std::size_t size, std::vector<address_t>& pages) -> void
+{
+	std::size_t const page  = page_size();
+	address_t const   first = addr / page * page;
+
+	bool const known = read_entries(addr, size);
+
+	for (std::size_t i = 0; i < entries_.size(); ++i)
+	{
+#ifdef WORM_POSIX
+		if (known && !(entries_[i] & soft_dirty_bit))
+		{
+			continue;
+		}
+#endif
+
+		pages.push_back(first + i * page);
+	}
+}
+
+auto soft_dirty_tracker::read_entries(address_t addr, std::size_t size) -> bool
+{
+	std::size_t const page  = page_size();
+	std::size_t const first = addr / page;
+	std::size_t const last  = size ? (addr + size - 1) / page : first;
+
+	entries_.assign(size ? last - first + 1 : 0, 0);
+
+#ifdef WORM_POSIX
+	std::size_t const bytes = entries_.size() * sizeof(std::uint64_t);
+
+	return static_cast<std::size_t>(pread(pagemap_, entries_.data(), bytes, static_cast<off_t>(first * sizeof(std::uint64_t)))) == bytes;
+#else
+	return false;
+#endif
+}
+}
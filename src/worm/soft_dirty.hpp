@@ -0,0 +1,91 @@
+#ifndef WORM_SOFT_DIRTY_HPP
+#define WORM_SOFT_DIRTY_HPP
+
+#include "worm/worm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace worm
+{
+/**
+ * @brief Tracker of pages written by a process.
+ *
+ * It relies on soft-dirty bits of page table entries, which the kernel sets
+ * on every write to a page after they were cleared through
+ * `/proc/<pid>/clear_refs` and which are read from `/proc/<pid>/pagemap`.
+ *
+ * Clearing affects the whole process, so that trackers of the same process
+ * interfere with each other. Kernels built without `CONFIG_MEM_SOFT_DIRTY`
+ * never report dirty pages, so that checks must only be used as hints.
+ */
+struct soft_dirty_tracker
+{
+	/**
+	 * @brief Construct a tracker.
+	 *
+	 * @param[in] pid process id
+	 *
+	 * @throws `std::system_error` if soft-dirty bits are not accessible
+	 */
+	explicit soft_dirty_tracker(pid_t pid);
+
+	soft_dirty_tracker(soft_dirty_tracker&&) noexcept;
+	auto operator=(soft_dirty_tracker&&) noexcept -> soft_dirty_tracker&;
+
+	~soft_dirty_tracker();
+
+	/**
+	 * @brief Get size of a page.
+	 */
+	[[nodiscard]]
+	static auto page_size() noexcept -> std::size_t;
+
+	/**
+	 * @brief Clear soft-dirty bits of all pages of the process.
+	 *
+	 * @throws `std::system_error` on failure to clear bits
+	 */
+	auto clear() -> void;
+
+	/**
+	 * @brief Check whether any page of a range was written since the last clear.
+	 *
+	 * Pages whose bits could not be read are reported as written.
+	 *
+	 * @param[in] addr first address of the range
+	 * @param[in] size number of bytes in the range
+	 */
+	[[nodiscard]]
+	auto dirty(address_t addr, std::size_t size) -> bool;
+
+	/**
+	 * @brief Find pages of a range written since the last clear.
+	 *
+	 * Pages whose bits could not be read are reported as written.
+	 *
+	 * @param[in]  addr  first address of the range
+	 * @param[in]  size  number of bytes in the range
+	 * @param[out] pages addresses of written pages, appended in ascending order
+	 */
+	auto dirty_pages(address_t addr, std::size_t size, std::vector<address_t>& pages) -> void;
+
+private:
+	/**
+	 * @brief Read page table entries of a range.
+	 *
+	 * @param[in] addr first address of the range
+	 * @param[in] size number of bytes in the range
+	 *
+	 * @return whether or not all entries could be read into the entry buffer
+	 */
+	auto read_entries(address_t addr, std::size_t size) -> bool;
+
+	int                        clear_refs_ = -1;
+	int                        pagemap_    = -1;
+	std::vector<std::uint64_t> entries_;
+};
+}
+
+#endif
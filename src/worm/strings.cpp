@@ -0,0 +1,168 @@
+#include "worm/strings.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <system_error>
+
+namespace worm
+{
+namespace
+{
+/// Smallest page size, which mappings are aligned to.
+constexpr std::size_t page_size = 1 << 12;
+
+/// Number of bytes of a string read at first, which most strings fit in.
+constexpr std::size_t min_chunk_size = 1 << 8;
+
+/// Maximum number of bytes of a string read at once.
+constexpr std::size_t max_chunk_size = 1 << 16;
+
+/**
+ * @brief Read NUL-terminated strings in rounds of batched reads.
+ *
+ * Every round reads the next chunk of each unterminated string, which is cut
+ * short at a page boundary, and chunks double in size every round.
+ * Terminators are searched for with `std::char_traits`, which uses vectorized
+ * `memchr` and `wmemchr`.
+ *
+ * @tparam CharT character type
+ *
+ * @param[in] h          handle
+ * @param[in] addrs      remote virtual memory addresses of the first characters
+ * @param[in] max_length maximum number of characters of a string
+ */
+template <typename CharT, handle_mode Mode>
+[[nodiscard]]
+auto read_terminated(handle<Mode> const& h, std::span<address_t const> addrs, std::size_t max_length)
+	-> std::vector<std::optional<std::basic_string<CharT>>>
+{
+	using traits = std::char_traits<CharT>;
+
+	constexpr std::size_t char_size = sizeof(CharT);
+
+	std::vector<std::optional<std::basic_string<CharT>>> strings(addrs.size(), std::basic_string<CharT>());
+
+	// Indices of strings that are not terminated yet.
+	std::vector<std::size_t> pending(max_length ? addrs.size() : 0);
+	std::iota(pending.begin(), pending.end(), std::size_t{0});
+
+	std::vector<memory_transfer> transfers;
+
+	for (std::size_t chunk = min_chunk_size; !pending.empty(); chunk = std::min(chunk * 2, max_chunk_size))
+	{
+		transfers.clear();
+
+		for (std::size_t const i : pending)
+		{
+			auto& s = *strings[i];
+
+			address_t const next     = addrs[i] + s.size() * char_size;
+			address_t const boundary = (next + chunk) / page_size * page_size;
+			address_t const end      = boundary > next ? boundary : next + chunk;
+
+			// A character that straddles a page boundary is read whole.
+			std::size_t const count = std::min(std::max<std::size_t>((end - next) / char_size, 1), max_length - s.size());
+			std::size_t const size  = s.size();
+
+			s.resize(size + count);
+			transfers.push_back({next, s.data() + size, count * char_size});
+		}
+
+		h.read_bytes(transfers);
+
+		std::size_t kept = 0;
+
+		for (std::size_t k = 0; k < pending.size(); ++k)
+		{
+			std::size_t const i = pending[k];
+			auto&             s = *strings[i];
+
+			std::size_t const requested = transfers[k].size / char_size;
+			std::size_t const read      = transfers[k].transferred / char_size;
+			std::size_t const size      = s.size() - requested;
+
+			if (auto const terminator = traits::find(s.data() + size, read, CharT{}))
+			{
+				s.resize(static_cast<std::size_t>(terminator - s.data()));
+			}
+			else if (read < requested)
+			{
+				strings[i].reset();
+			}
+			else if (s.size() < max_length)
+			{
+				pending[kept++] = i;
+			}
+		}
+
+		pending.resize(kept);
+	}
+
+	return strings;
+}
+
+/**
+ * @brief Read a NUL-terminated string.
+ *
+ * @tparam CharT character type
+ *
+ * @param[in] h          handle
+ * @param[in] addr       remote virtual memory address of the first character
+ * @param[in] max_length maximum number of characters
+ */
+template <typename CharT, handle_mode Mode>
+[[nodiscard]]
+auto read_terminated(handle<Mode> const& h, address_t addr, std::size_t max_length) -> std::basic_string<CharT>
+{
+	auto strings = read_terminated<CharT>(h, std::span(&addr, 1), max_length);
+	if (!strings.front())
+	{
+		throw std::system_error(std::make_error_code(std::errc::bad_address), "memory ends before the terminator");
+	}
+
+	return std::move(*strings.front());
+}
+}
+
+template <handle_mode Mode>
+auto read_cstring(handle<Mode> const& h, address_t addr, std::size_t max_length) -> std::string
+	requires handle<Mode>::readable
+{
+	return read_terminated<char>(h, addr, max_length);
+}
+
+template <handle_mode Mode>
+auto read_wstring(handle<Mode> const& h, address_t addr, std::size_t max_length) -> std::wstring
+	requires handle<Mode>::readable
+{
+	return read_terminated<wchar_t>(h, addr, max_length);
+}
+
+template <handle_mode Mode>
+auto read_cstrings(handle<Mode> const& h, std::span<address_t const> addrs, std::size_t max_length) -> std::vector<std::optional<std::string>>
+	requires handle<Mode>::readable
+{
+	return read_terminated<char>(h, addrs, max_length);
+}
+
+template <handle_mode Mode>
+auto read_wstrings(handle<Mode> const& h, std::span<address_t const> addrs, std::size_t max_length) -> std::vector<std::optional<std::wstring>>
+	requires handle<Mode>::readable
+{
+	return read_terminated<wchar_t>(h, addrs, max_length);
+}
+
+template auto read_cstring(handle<handle_mode::in> const&, address_t, std::size_t) -> std::string;
+template auto read_cstring(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t) -> std::string;
+
+template auto read_wstring(handle<handle_mode::in> const&, address_t, std::size_t) -> std::wstring;
+template auto read_wstring(handle<handle_mode::in | handle_mode::out> const&, address_t, std::size_t) -> std::wstring;
+
+template auto read_cstrings(handle<handle_mode::in> const&, std::span<address_t const>, std::size_t) -> std::vector<std::optional<std::string>>;
+template auto read_cstrings(handle<handle_mode::in | handle_mode::out> const&, std::span<address_t const>, std::size_t)
+	-> std::vector<std::optional<std::string>>;
+
+template auto read_wstrings(handle<handle_mode::in> const&, std::span<address_t const>, std::size_t) -> std::vector<std::optional<std::wstring>>;
+template auto read_wstrings(handle<handle_mode::in | handle_mode::out> const&, std::span<address_t const>, std::size_t)
+	-> std::vector<std::optional<std::wstring>>;
+}
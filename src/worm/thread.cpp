@@ -0,0 +1,350 @@
+#include "platform.hpp"
+
+#if defined(WORM_POSIX)
+
+#	include <filesystem>
+#	include <fstream>
+#	include <iterator>
+#	include <string>
+
+#	include <elf.h>
+#	include <sys/ptrace.h>
+#	include <sys/user.h>
+#	include <sys/wait.h>
+
+#elif defined(WORM_WINDOWS)
+
+#	include <tlhelp32.h>
+#	include <winternl.h>
+
+#endif
+
+namespace worm
+{
+namespace
+{
+#if defined(__x86_64__) && !defined(WORM_WINDOWS)
+/// Number of bytes below the stack pointer that leaf functions may use.
+constexpr address_t red_zone_size = 128;
+#else
+/// Number of bytes below the stack pointer that leaf functions may use.
+constexpr address_t red_zone_size = 0;
+#endif
+
+/**
+ * @brief Locate a stack in memory regions.
+ *
+ * @param[in]     regions memory regions sorted by address
+ * @param[in]     addr    address that belongs to the stack
+ * @param[in,out] stack   stack to fill the ranges of
+ */
+auto locate_stack(std::vector<memory_region> const& regions, address_t addr, thread_stack& stack) noexcept -> void
+{
+	auto const it = std::ranges::upper_bound(regions, addr, {}, [](memory_region const& r) { return r.range.front(); });
+	if (!addr || it == regions.begin() || addr >= *std::prev(it)->range.end())
+	{
+		return;
+	}
+
+	stack.range = std::prev(it)->range;
+
+	address_t const live_begin = stack.stack_pointer ? std::max(stack.range.front(), stack.stack_pointer - red_zone_size) : stack.range.front();
+	stack.live = {live_begin, *stack.range.end()};
+}
+
+#ifdef WORM_POSIX
+/**
+ * @brief Read the whole contents of a file.
+ *
+ * @param[in] path file path
+ *
+ * @return file contents, or an empty string on failure
+ */
+[[nodiscard]]
+auto read_file(std::filesystem::path const& path) -> std::string
+{
+	std::ifstream f(path);
+	return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * @brief Parse a decimal number.
+ *
+ * @param[in] str string to parse
+ */
+[[nodiscard]]
+auto parse_decimal(std::string_view str) noexcept -> address_t
+{
+	address_t value = 0;
+	std::from_chars(str.data(), str.data() + str.size(), value);
+	return value;
+}
+
+/// Stack information from `/proc/<pid>/task/<tid>/stat`.
+struct stat_stack
+{
+	/// Start (top) of the stack.
+	address_t start;
+
+	/// Stack pointer, if exposed by the kernel.
+	address_t pointer;
+};
+
+/**
+ * @brief Read stack information of a thread from its `stat` file.
+ *
+ * @param[in] path path to the `stat` file
+ */
+[[nodiscard]]
+auto read_stat_stack(std::filesystem::path const& path) -> stat_stack
+{
+	// Fields 28 and 29 are `startstack` and `kstkesp`, the second field is the
+	// command name that may contain spaces and is therefore skipped as a whole.
+	static constexpr int startstack_field = 28;
+	static constexpr int first_field      = 3;
+
+	std::string const contents = read_file(path);
+
+	std::size_t const comm_end = contents.rfind(')');
+	if (comm_end == std::string::npos)
+	{
+		return {};
+	}
+
+	std::string_view columns(contents);
+	columns.remove_prefix(comm_end + 1);
+
+	for (int i = first_field; i < startstack_field; ++i)
+	{
+		static_cast<void>(next_column(columns));
+	}
+
+	address_t const start = parse_decimal(next_column(columns));
+
+	return {start, parse_decimal(next_column(columns))};
+}
+
+/**
+ * @brief Read stack pointer of a blocked thread from its `syscall` file.
+ *
+ * @param[in] path path to the `syscall` file
+ *
+ * @return stack pointer, or `0` if the thread is running
+ */
+[[nodiscard]]
+auto read_syscall_stack_pointer(std::filesystem::path const& path) -> address_t
+{
+	// The file is either "running", or a list of columns where the stack
+	// pointer and the program counter are the last two.
+	std::string const contents = read_file(path);
+
+	std::string_view rest(contents);
+	rest = rest.substr(0, rest.find('\n'));
+
+	std::vector<std::string_view> columns;
+	for (std::string_view column; !(column = next_column(rest)).empty();)
+	{
+		columns.push_back(column);
+	}
+
+	if (columns.size() < 3)
+	{
+		return 0;
+	}
+
+	std::string_view sp = columns[columns.size() - 2];
+	if (sp.starts_with("0x"))
+	{
+		sp.remove_prefix(2);
+	}
+
+	return parse_address(sp);
+}
+
+/**
+ * @brief Read stack pointer of a thread by briefly interrupting it with `ptrace`.
+ *
+ * @param[in] tid thread ID
+ *
+ * @return stack pointer, or `0` on failure
+ */
+[[nodiscard]]
+auto interrupt_stack_pointer(::pid_t tid) noexcept -> address_t
+{
+	if (ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) == -1)
+	{
+		return 0;
+	}
+
+	address_t sp = 0;
+
+	if (int status; ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) != -1 && waitpid(tid, &status, __WALL) == tid)
+	{
+		user_regs_struct regs{};
+		iovec            io{&regs, sizeof(regs)};
+
+		if (ptrace(PTRACE_GETREGSET, tid, NT_PRSTATUS, &io) != -1)
+		{
+#	if defined(__x86_64__)
+			sp = regs.rsp;
+#	elif defined(__i386__)
+			sp = regs.esp;
+#	elif defined(__aarch64__)
+			sp = regs.sp;
+#	endif
+		}
+	}
+
+	ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+
+	return sp;
+}
+#endif
+}
+
+template <handle_mode Mode>
+auto handle<Mode>::thread_stacks(bool interrupt) const -> std::vector<thread_stack>
+	requires readable
+{
+	auto const regions = this->regions();
+
+	std::vector<thread_stack> stacks;
+
+#if defined(WORM_POSIX)
+	std::error_code                     ec;
+	std::filesystem::directory_iterator tasks("/proc/" + std::to_string(pid_) + "/task", ec);
+
+	if (ec)
+	{
+		throw std::system_error(ec, "failed to enumerate threads");
+	}
+
+	for (auto const& task : tasks)
+	{
+		std::string const tid_str = task.path().filename().string();
+
+		pid_t tid = 0;
+		std::from_chars(tid_str.data(), tid_str.data() + tid_str.size(), tid);
+
+		// Threads may exit during enumeration, in which case nothing is read.
+		auto const [start, kstkesp] = read_stat_stack(task.path() / "stat");
+
+		address_t sp = kstkesp;
+		if (!sp)
+		{
+			sp = read_syscall_stack_pointer(task.path() / "syscall");
+		}
+		if (!sp && interrupt)
+		{
+			sp = interrupt_stack_pointer(static_cast<::pid_t>(tid));
+		}
+
+		thread_stack stack{tid, {}, {}, sp};
+
+		// Without a stack pointer, only the main thread's stack can be located.
+		locate_stack(regions, sp ? sp : (tid == pid_ ? start : 0), stack);
+
+		stacks.push_back(stack);
+	}
+#elif defined(WORM_WINDOWS)
+	using query_information_thread_type = NTSTATUS(NTAPI*)(HANDLE, THREADINFOCLASS, PVOID, ULONG, PULONG);
+
+	struct thread_basic_information
+	{
+		NTSTATUS  exit_status;
+		PVOID     teb_base_address;
+		CLIENT_ID client_id;
+		ULONG_PTR affinity_mask;
+		LONG      priority;
+		LONG      base_priority;
+	};
+
+	auto const query_information_thread = reinterpret_cast<query_information_thread_type>(
+		GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationThread")
+	);
+
+	if (!query_information_thread)
+	{
+		throw make_system_error("failed to locate NtQueryInformationThread");
+	}
+
+	HANDLE const snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+	if (snapshot == INVALID_HANDLE_VALUE)
+	{
+		throw make_system_error("failed to enumerate threads");
+	}
+
+	THREADENTRY32 entry{};
+	entry.dwSize = sizeof(entry);
+
+	for (BOOL found = Thread32First(snapshot, &entry); found; found = Thread32Next(snapshot, &entry))
+	{
+		if (entry.th32OwnerProcessID != pid_)
+		{
+			continue;
+		}
+
+		HANDLE const thread = OpenThread(THREAD_GET_CONTEXT | THREAD_QUERY_LIMITED_INFORMATION | (interrupt ? THREAD_SUSPEND_RESUME : 0), false, entry.th32ThreadID);
+		if (!thread)
+		{
+			continue;
+		}
+
+		thread_stack stack{entry.th32ThreadID, {}, {}, 0};
+
+		bool const suspended = interrupt && SuspendThread(thread) != static_cast<DWORD>(-1);
+
+		CONTEXT context{};
+		context.ContextFlags = CONTEXT_CONTROL;
+
+		if (GetThreadContext(thread, &context))
+		{
+#	if defined(_M_X64) || defined(__x86_64__)
+			stack.stack_pointer = context.Rsp;
+#	elif defined(_M_ARM64) || defined(__aarch64__)
+			stack.stack_pointer = context.Sp;
+#	else
+			stack.stack_pointer = context.Esp;
+#	endif
+		}
+
+		if (suspended)
+		{
+			ResumeThread(thread);
+		}
+
+		// Stack bounds are stored in the thread information block at the start of the TEB.
+		thread_basic_information info{};
+		NT_TIB                   tib{};
+
+		if (NT_SUCCESS(query_information_thread(thread, static_cast<THREADINFOCLASS>(0), &info, sizeof(info), nullptr)))
+		{
+			try
+			{
+				read_bytes(reinterpret_cast<address_t>(info.teb_base_address), &tib, sizeof(tib));
+
+				stack.range = {reinterpret_cast<address_t>(tib.StackLimit), reinterpret_cast<address_t>(tib.StackBase)};
+				stack.live  = {std::clamp(stack.stack_pointer, stack.range.front(), *stack.range.end()), *stack.range.end()};
+			}
+			catch (std::system_error const&)
+			{
+				locate_stack(regions, stack.stack_pointer, stack);
+			}
+		}
+
+		CloseHandle(thread);
+
+		stacks.push_back(stack);
+	}
+
+	CloseHandle(snapshot);
+#endif
+
+	std::ranges::sort(stacks, {}, &thread_stack::tid);
+
+	return stacks;
+}
+
+template auto handle<handle_mode::in>::thread_stacks(bool) const -> std::vector<thread_stack>;
+template auto handle<handle_mode::in | handle_mode::out>::thread_stacks(bool) const -> std::vector<thread_stack>;
+}
@@ -0,0 +1,295 @@
+#include "worm/value_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace worm
+{
+template <handle_mode Mode>
+struct alignas(64) value_cache<Mode>::slot
+{
+	/// Remote virtual memory address of the value.
+	address_t const address;
+
+	/// Number of bytes in the value.
+	std::size_t const size;
+
+	/// Sequence number, which is odd while the value is being published.
+	std::atomic<std::uint64_t> sequence{0};
+
+	/// Whether or not the published value could be read.
+	std::atomic<bool> valid{false};
+
+	/// Published value, word by word.
+	std::unique_ptr<std::atomic<std::uint64_t>[]> words;
+
+	/// Copy of the published value, used only by the poller.
+	std::vector<unsigned char> published;
+
+	/// Whether or not the published value could be read, used only by the poller.
+	bool published_valid = false;
+
+	slot(address_t address, std::size_t size)
+		: address{address}
+		, size{size}
+		, words{std::make_unique<std::atomic<std::uint64_t>[]>((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t))}
+		, published(size)
+	{}
+
+	/**
+	 * @brief Publish a value.
+	 *
+	 * It must not be called concurrently with itself.
+	 *
+	 * @param[in] ok   whether or not the value could be read
+	 * @param[in] data value
+	 */
+	auto publish(bool ok, unsigned char const* data) noexcept -> void
+	{
+		std::uint64_t const seq = sequence.load(std::memory_order::relaxed);
+
+		sequence.store(seq + 1, std::memory_order::relaxed);
+		std::atomic_thread_fence(std::memory_order::release);
+
+		valid.store(ok, std::memory_order::relaxed);
+
+		if (ok)
+		{
+			for (std::size_t offset = 0; offset < size; offset += sizeof(std::uint64_t))
+			{
+				std::uint64_t word = 0;
+				std::memcpy(&word, data + offset, std::min(sizeof(word), size - offset));
+
+				words[offset / sizeof(word)].store(word, std::memory_order::relaxed);
+			}
+
+			std::memcpy(published.data(), data, size);
+		}
+
+		sequence.store(seq + 2, std::memory_order::release);
+
+		published_valid = ok;
+	}
+};
+
+template <handle_mode Mode>
+struct value_cache<Mode>::state
+{
+	/// Handle to read values with.
+	handle_type const& h;
+
+	/// Interval between polls.
+	std::chrono::nanoseconds const interval;
+
+	/// Slots, which do not move once added.
+	std::deque<slot> slots;
+	std::mutex       slots_mutex;
+
+	/// Serializes polls.
+	std::mutex poll_mutex;
+
+	/// Slots being polled.
+	std::vector<slot*> polled;
+
+	/// Offsets of slots in the staging buffer.
+	std::vector<std::size_t> offsets;
+
+	/// Buffer that values are read into.
+	std::vector<unsigned char> staging;
+
+	/// Transfers into the staging buffer.
+	std::vector<memory_transfer> transfers;
+
+	/// Number of completed polls.
+	std::atomic<std::uint64_t> epoch{0};
+
+	std::mutex              stop_mutex;
+	std::condition_variable stop_cv;
+
+	/// Whether or not the poller thread has to stop.
+	bool stopped = false;
+
+	/// Poller thread.
+	std::thread poller;
+
+	state(handle_type const& h, std::chrono::nanoseconds interval)
+		: h{h}
+		, interval{interval}
+	{
+		poller = std::thread(&state::run, this);
+	}
+
+	state(state const&)                    = delete;
+	auto operator=(state const&) -> state& = delete;
+
+	~state()
+	{
+		{
+			std::scoped_lock lock(stop_mutex);
+			stopped = true;
+		}
+
+		stop_cv.notify_all();
+		poller.join();
+	}
+
+	/// Poll until stopped.
+	auto run() noexcept -> void
+	{
+		while (true)
+		{
+			{
+				std::unique_lock lock(stop_mutex);
+				if (stop_cv.wait_for(lock, interval, [this] { return stopped; }))
+				{
+					return;
+				}
+			}
+
+			try
+			{
+				poll();
+			}
+			catch (std::exception const&)
+			{}
+		}
+	}
+
+	/// Read and publish all values.
+	auto poll() -> void
+	{
+		std::scoped_lock lock(poll_mutex);
+
+		// Slots added since the previous poll get their own transfers.
+		{
+			std::scoped_lock slots_lock(slots_mutex);
+
+			if (polled.size() != slots.size())
+			{
+				for (std::size_t i = polled.size(); i < slots.size(); ++i)
+				{
+					polled.push_back(&slots[i]);
+					offsets.push_back(staging.size());
+					staging.resize(staging.size() + slots[i].size);
+				}
+
+				transfers.clear();
+				for (std::size_t i = 0; i < polled.size(); ++i)
+				{
+					transfers.push_back({polled[i]->address, staging.data() + offsets[i], polled[i]->size});
+				}
+			}
+		}
+
+		std::exception_ptr exception;
+
+		try
+		{
+			h.read_bytes(transfers);
+		}
+		catch (std::system_error const&)
+		{
+			for (auto& t : transfers)
+			{
+				t.transferred = 0;
+			}
+
+			exception = std::current_exception();
+		}
+
+		for (std::size_t i = 0; i < polled.size(); ++i)
+		{
+			auto&                      s    = *polled[i];
+			unsigned char const* const data = staging.data() + offsets[i];
+			bool const                 ok   = transfers[i].transferred == s.size;
+
+			if (ok != s.published_valid || (ok && std::memcmp(data, s.published.data(), s.size)))
+			{
+				s.publish(ok, data);
+			}
+		}
+
+		epoch.fetch_add(1, std::memory_order::release);
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+};
+
+template <handle_mode Mode>
+value_cache<Mode>::value_cache(handle_type const& h, std::chrono::nanoseconds interval)
+	requires(handle_type::readable)
+	: state_{std::make_unique<state>(h, interval)}
+{}
+
+template <handle_mode Mode>
+value_cache<Mode>::~value_cache() = default;
+
+template <handle_mode Mode>
+auto value_cache<Mode>::refresh() -> void
+{
+	state_->poll();
+}
+
+template <handle_mode Mode>
+auto value_cache<Mode>::epoch() const noexcept -> std::uint64_t
+{
+	return state_->epoch.load(std::memory_order::acquire);
+}
+
+template <handle_mode Mode>
+auto value_cache<Mode>::add(address_t addr, std::size_t size) -> slot const*
+{
+	std::scoped_lock lock(state_->slots_mutex);
+	return &state_->slots.emplace_back(addr, size);
+}
+
+template <handle_mode Mode>
+auto value_cache<Mode>::load(slot const& s, void* dst) noexcept -> bool
+{
+	auto* const out = static_cast<unsigned char*>(dst);
+
+	while (true)
+	{
+		std::uint64_t const before = s.sequence.load(std::memory_order::acquire);
+		if (before & 1)
+		{
+			continue;
+		}
+
+		bool const valid = s.valid.load(std::memory_order::relaxed);
+
+		for (std::size_t offset = 0; offset < s.size; offset += sizeof(std::uint64_t))
+		{
+			std::uint64_t const word = s.words[offset / sizeof(word)].load(std::memory_order::relaxed);
+			std::memcpy(out + offset, &word, std::min(sizeof(word), s.size - offset));
+		}
+
+		std::atomic_thread_fence(std::memory_order::acquire);
+
+		if (s.sequence.load(std::memory_order::relaxed) == before)
+		{
+			return valid;
+		}
+	}
+}
+
+template <handle_mode Mode>
+auto value_cache<Mode>::address(slot const& s) noexcept -> address_t
+{
+	return s.address;
+}
+
+template struct value_cache<handle_mode::in>;
+template struct value_cache<handle_mode::in | handle_mode::out>;
+}
@@ -1,91 +1,105 @@
-#if !defined(WORM_POSIX) && !defined(WORM_WINDOWS)
-
-#if defined(__unix__) || defined(__linux__) || defined(__APPLE__)
-#	define WORM_POSIX
-#elif defined(_WIN32)
-#	define WORM_WINDOWS
-#else
-#	error unsupported target operating system
-#endif
-
-#endif
+#include "platform.hpp"
+#include "probes.hpp"
+#include "simd.hpp"
+#include "soft_dirty.hpp"
 
-#include "worm/worm.hpp"
-
-#include <system_error>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
 
 #if defined(WORM_POSIX)
 
-#	define WORM_ERRNO (errno)
-
+#	include <climits>
 #	include <fstream>
+#	include <vector>
+
+#	include <sys/sysmacros.h>
 
 #	ifdef __cpp_lib_format
 #		include <format>
 #	endif
 
-#	include <sys/uio.h>
-
-#elif defined(WORM_WINDOWS)
-
-#	define WORM_ERRNO (static_cast<int>(GetLastError()))
-
-#	define WIN32_LEAN_AND_MEAN
-
-#	include <processthreadsapi.h>
-#	include <errhandlingapi.h>
-#	include <stringapiset.h>
-#	include <libloaderapi.h>
-#	include <handleapi.h>
-#	include <memoryapi.h>
-#	include <minwindef.h>
-#	include <winnls.h>
-#	include <psapi.h>
-
 #endif
 
 namespace worm
 {
 namespace
 {
-[[nodiscard]]
-inline auto make_system_error(char const* what_arg) noexcept -> std::system_error
+#ifdef WORM_POSIX
+/**
+ * @brief Transfer bytes with vectored system calls.
+ *
+ * Transfers are batched by `IOV_MAX`. A vectored call stops at the first
+ * inaccessible byte, so the transfer that it stopped at is counted as partial
+ * and the following ones are retried in another call.
+ *
+ * @param[in,out] transfers transfers
+ * @param[in]     call      function that performs a vectored call with local and remote vectors and their length
+ * @param[in]     message   error message
+ *
+ * @return total number of bytes transferred
+ */
+template <typename F>
+auto transfer_vectored(std::span<memory_transfer> transfers, F&& call, char const* message) -> std::size_t
 {
-	return {
-		{WORM_ERRNO, std::system_category()},
-		what_arg
-	};
-}
-}
+	std::size_t const batch_size = std::min<std::size_t>(transfers.size(), IOV_MAX);
 
-template <handle_mode Mode>
-struct handle<Mode>::system_handle
-{
-	using handle_type = handle<Mode>;
+	std::vector<iovec> local;
+	std::vector<iovec> remote;
+	local.reserve(batch_size);
+	remote.reserve(batch_size);
 
-#ifdef WORM_WINDOWS
-	void* handle{};
+	std::size_t total = 0;
 
-	explicit system_handle(pid_t pid)
-		: handle{OpenProcess(
-			  (handle_type::readable ? PROCESS_VM_READ | PROCESS_QUERY_LIMITED_INFORMATION : 0) |
-				  (handle_type::writable ? PROCESS_VM_OPERATION | PROCESS_VM_WRITE : 0),
-			  false,
-			  pid
-		  )}
+	for (std::size_t first = 0; first < transfers.size();)
 	{
-		if (!handle)
+		std::size_t const count = std::min(transfers.size() - first, batch_size);
+
+		local.clear();
+		remote.clear();
+
+		for (std::size_t i = first; i < first + count; ++i)
 		{
-			throw make_system_error("failed to open a process handle");
+			local.push_back({transfers[i].buffer, transfers[i].size});
+			remote.push_back({reinterpret_cast<void*>(transfers[i].address), transfers[i].size});
 		}
-	}
 
-	~system_handle()
-	{
-		CloseHandle(handle);
+		ssize_t const result = call(local.data(), remote.data(), count);
+		if (result < 0)
+		{
+			if (errno != EFAULT)
+			{
+				throw make_system_error(message);
+			}
+
+			transfers[first++].transferred = 0;
+			continue;
+		}
+
+		total += static_cast<std::size_t>(result);
+
+		std::size_t left = static_cast<std::size_t>(result);
+		std::size_t i    = first;
+
+		for (; i < first + count && left >= transfers[i].size; ++i)
+		{
+			transfers[i].transferred = transfers[i].size;
+			left -= transfers[i].size;
+		}
+
+		if (i < first + count)
+		{
+			transfers[i++].transferred = left;
+		}
+
+		first = i;
 	}
+
+	return total;
+}
 #endif
-};
+}
 
 template <handle_mode Mode>
 handle<Mode>::handle(pid_t pid)
@@ -106,6 +120,8 @@ template <handle_mode Mode>
 auto handle<Mode>::read_bytes(address_t src, void* dst, std::size_t size) const -> std::size_t
 	requires readable
 {
+	WORM_PROBE(read_bytes__entry, pid_, src, size);
+
 #ifdef WORM_POSIX
 	iovec local{dst, size};
 	iovec remote{reinterpret_cast<void*>(src), size};
@@ -119,9 +135,13 @@ auto handle<Mode>::read_bytes(address_t src, void* dst, std::size_t size) const
 #endif
 	)
 	{
+		WORM_PROBE(read_bytes__return, pid_, src, size, bytes_read);
+
 		return bytes_read;
 	}
 
+	WORM_PROBE(read_bytes__return, pid_, src, size, -1);
+
 	throw make_system_error("failed to read from virtual memory");
 }
 
@@ -129,9 +149,11 @@ template <handle_mode Mode>
 auto handle<Mode>::write_bytes(address_t dst, void const* src, std::size_t size) const -> std::size_t
 	requires writable
 {
+	WORM_PROBE(write_bytes__entry, pid_, dst, size);
+
 #ifdef WORM_POSIX
-	iovec local{reinterpret_cast<void*>(src), size};
-	iovec remote{dst, size};
+	iovec local{const_cast<void*>(src), size};
+	iovec remote{reinterpret_cast<void*>(dst), size};
 #endif
 
 	if (
@@ -142,16 +164,247 @@ auto handle<Mode>::write_bytes(address_t dst, void const* src, std::size_t size)
 #endif
 	)
 	{
+		WORM_PROBE(write_bytes__return, pid_, dst, size, bytes_written);
+
 		return bytes_written;
 	}
 
+	WORM_PROBE(write_bytes__return, pid_, dst, size, -1);
+
 	throw make_system_error("failed to write to virtual memory");
 }
 
+template <handle_mode Mode>
+auto handle<Mode>::read_bytes(std::span<memory_transfer> transfers) const -> std::size_t
+	requires readable
+{
+	WORM_PROBE(read_vector__entry, pid_, transfers.size());
+
+	std::size_t total = 0;
+
+	try
+	{
+#if defined(WORM_POSIX)
+		total = transfer_vectored(
+			transfers,
+			[this](iovec const* local, iovec const* remote, std::size_t count) { return process_vm_readv(pid_, local, count, remote, count, 0); },
+			"failed to read from virtual memory"
+		);
+#elif defined(WORM_WINDOWS)
+		for (auto& t : transfers)
+		{
+			t.transferred = 0;
+			ReadProcessMemory(system_handle_->handle, reinterpret_cast<void const*>(t.address), t.buffer, t.size, &t.transferred);
+			total += t.transferred;
+		}
+#endif
+	}
+	catch (std::system_error const&)
+	{
+		WORM_PROBE(read_vector__return, pid_, transfers.size(), -1);
+
+		throw;
+	}
+
+	WORM_PROBE(read_vector__return, pid_, transfers.size(), total);
+
+	return total;
+}
+
+template <handle_mode Mode>
+auto handle<Mode>::write_bytes(std::span<memory_transfer> transfers) const -> std::size_t
+	requires writable
+{
+	WORM_PROBE(write_vector__entry, pid_, transfers.size());
+
+	std::size_t total = 0;
+
+	try
+	{
+#if defined(WORM_POSIX)
+		total = transfer_vectored(
+			transfers,
+			[this](iovec const* local, iovec const* remote, std::size_t count) { return process_vm_writev(pid_, local, count, remote, count, 0); },
+			"failed to write to virtual memory"
+		);
+#elif defined(WORM_WINDOWS)
+		for (auto& t : transfers)
+		{
+			t.transferred = 0;
+			WriteProcessMemory(system_handle_->handle, reinterpret_cast<void*>(t.address), t.buffer, t.size, &t.transferred);
+			total += t.transferred;
+		}
+#endif
+	}
+	catch (std::system_error const&)
+	{
+		WORM_PROBE(write_vector__return, pid_, transfers.size(), -1);
+
+		throw;
+	}
+
+	WORM_PROBE(write_vector__return, pid_, transfers.size(), total);
+
+	return total;
+}
+
+template <handle_mode Mode>
+auto handle<Mode>::wait_until(
+	std::span<memory_transfer> transfers,
+	std::function<bool()> const& pred,
+	std::chrono::nanoseconds timeout,
+	wait_options const& options
+) const -> bool
+	requires readable
+{
+	using clock = std::chrono::steady_clock;
+
+	if (options.min_interval > options.max_interval)
+	{
+		throw std::invalid_argument("shortest polling interval is longer than the longest one");
+	}
+
+	WORM_PROBE(wait__entry, pid_, transfers.size(), timeout.count());
+
+	auto const deadline = clock::now() + timeout;
+
+	std::optional<soft_dirty_tracker> tracker;
+	if (options.soft_dirty)
+	{
+		try
+		{
+			tracker.emplace(pid_);
+		}
+		catch (std::system_error const&)
+		{}
+	}
+
+	// Contents and transferred sizes of the transfers as of the previous read.
+	std::vector<unsigned char> previous;
+	std::vector<std::size_t>   previous_transferred(transfers.size());
+
+	std::size_t polls = 0;
+	std::size_t reads = 0;
+
+	// Whether or not soft-dirty bits were cleared right before the latest read, so that they tell whether it is stale.
+	bool bits_fresh = false;
+
+	auto const poll = [&](bool clear) -> bool
+	{
+		++polls;
+
+		bits_fresh = false;
+
+		if (clear)
+		{
+			try
+			{
+				tracker->clear();
+				bits_fresh = true;
+			}
+			catch (std::system_error const&)
+			{
+				tracker.reset();
+			}
+		}
+
+		read_bytes(transfers);
+		++reads;
+
+		bool        changed = previous.empty();
+		std::size_t offset  = 0;
+
+		for (std::size_t i = 0; i < transfers.size(); ++i)
+		{
+			auto const& t = transfers[i];
+
+			if (previous.size() < offset + t.size)
+			{
+				previous.resize(offset + t.size);
+			}
+
+			if (t.transferred != previous_transferred[i] || std::memcmp(previous.data() + offset, t.buffer, t.transferred))
+			{
+				changed = true;
+
+				previous_transferred[i] = t.transferred;
+				std::memcpy(previous.data() + offset, t.buffer, t.transferred);
+			}
+
+			offset += t.size;
+		}
+
+		return changed;
+	};
+
+	auto const unchanged_pages = [&]() -> bool
+	{
+		return std::ranges::none_of(transfers, [&](auto const& t) { return tracker->dirty(t.address, t.size); });
+	};
+
+	bool satisfied = poll(false) && pred();
+
+	auto last_change = clock::now();
+	auto last_read   = last_change;
+	auto last_clear  = clock::time_point::min();
+
+	std::chrono::nanoseconds interval{0};
+
+	while (!satisfied)
+	{
+		auto now = clock::now();
+		if (now >= deadline)
+		{
+			break;
+		}
+
+		bool const sleeping = now - last_change >= options.spin;
+
+		if (sleeping)
+		{
+			interval = std::clamp(interval * 2, options.min_interval, options.max_interval);
+
+			std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(interval, deadline - now));
+			now = clock::now();
+		}
+
+		// Soft-dirty bits are only a hint, so values are still read every longest interval.
+		if (tracker && bits_fresh && now - last_read < options.max_interval && unchanged_pages())
+		{
+			++polls;
+			continue;
+		}
+
+		last_read = now;
+
+		// Clearing write-protects the whole process, so it is never done while
+		// spinning on changing values, and at most once per shortest interval.
+		bool const clear = tracker && sleeping && now - last_clear >= options.min_interval;
+		if (clear)
+		{
+			last_clear = now;
+		}
+
+		if (poll(clear))
+		{
+			last_change = clock::now();
+			interval    = std::chrono::nanoseconds{0};
+
+			satisfied = pred();
+		}
+	}
+
+	WORM_PROBE(wait__return, pid_, transfers.size(), polls, reads, satisfied);
+
+	return satisfied;
+}
+
 template <handle_mode Mode>
 auto handle<Mode>::regions() const -> std::vector<memory_region>
 	requires readable
 {
+	WORM_PROBE(regions__entry, pid_);
+
 	std::vector<memory_region> regions;
 
 #if defined(WORM_POSIX)
@@ -163,26 +416,61 @@ auto handle<Mode>::regions() const -> std::vector<memory_region>
 #	endif
 	);
 
-	static constexpr char column_delim = ' ';
-	static constexpr char range_delim  = '-';
+	if (!f)
+	{
+		WORM_PROBE(regions__return, pid_, -1);
+
+		throw make_system_error("failed to open memory maps");
+	}
 
-	while (!f.eof())
+	static constexpr char range_delim = '-';
+
+	std::string row;
+	while (std::getline(f, row))
 	{
-		std::string row;
-		std::getline(f, row);
+		std::string_view columns(row);
 
-		std::size_t const first_delim_index = row.find(column_delim);
-		if (first_delim_index == std::string::npos)
+		std::string_view const range_str = next_column(columns);
+		std::size_t const      range_delim_index = range_str.find(range_delim);
+		if (range_delim_index == std::string_view::npos)
 		{
 			break;
 		}
 
-		std::string_view const range_str(row.substr(0, first_delim_index));
-		std::size_t const      range_delim_index = range_str.find(range_delim);
+		std::string_view const permissions_str = next_column(columns);
+		std::string_view const offset_str      = next_column(columns);
+		std::string_view const device_str      = next_column(columns);
+		std::string_view const inode_str       = next_column(columns);
+
+		// The rest of the row is the name.
+		columns.remove_prefix(std::min(columns.find_first_not_of(' '), columns.size()));
+
+		auto permissions = memory_permission::none;
+		if (permissions_str.find('r') != std::string_view::npos)
+		{
+			permissions = permissions | memory_permission::read;
+		}
+		if (permissions_str.find('w') != std::string_view::npos)
+		{
+			permissions = permissions | memory_permission::write;
+		}
+		if (permissions_str.find('x') != std::string_view::npos)
+		{
+			permissions = permissions | memory_permission::execute;
+		}
+
+		std::size_t const device_delim_index = device_str.find(':');
+
+		std::uint64_t inode = 0;
+		std::from_chars(inode_str.data(), inode_str.data() + inode_str.size(), inode);
 
 		regions.push_back({
-			row.substr(row.rfind(column_delim) + 1),
-			{std::stoull(range_str.substr(0, range_delim_index), nullptr, 16), std::stoull(range_str.substr(range_delim_index + 1), nullptr, 16)}
+			std::string(columns),
+			{parse_address(range_str.substr(0, range_delim_index)), parse_address(range_str.substr(range_delim_index + 1))},
+			permissions,
+			parse_address(offset_str),
+			makedev(parse_address(device_str.substr(0, device_delim_index)), parse_address(device_str.substr(std::min(device_delim_index + 1, device_str.size())))),
+			inode,
 		});
 	}
 #elif defined(WORM_WINDOWS)
@@ -192,6 +480,8 @@ auto handle<Mode>::regions() const -> std::vector<memory_region>
 
 	if (!EnumProcessModules(windows_handle, nullptr, 0, &size))
 	{
+		WORM_PROBE(regions__return, pid_, -1);
+
 		throw make_system_error("failed to count process modules during initial enumeration");
 	}
 
@@ -200,6 +490,8 @@ auto handle<Mode>::regions() const -> std::vector<memory_region>
 
 	if (!EnumProcessModules(windows_handle, modules.get(), size, &size))
 	{
+		WORM_PROBE(regions__return, pid_, -1);
+
 		throw make_system_error("failed to enumerate process modules");
 	}
 
@@ -224,14 +516,60 @@ auto handle<Mode>::regions() const -> std::vector<memory_region>
 		auto const base_addr = reinterpret_cast<address_t>(module_handle);
 		regions.push_back({
 			module_name,
-			{base_addr, base_addr + module_info.SizeOfImage}
+			{base_addr, base_addr + module_info.SizeOfImage},
+			memory_permission::read
 		});
 	}
 #endif
 
+	WORM_PROBE(regions__return, pid_, regions.size());
+
 	return regions;
 }
 
+template <handle_mode Mode>
+auto handle<Mode>::validate_pointers(std::span<address_t const> addrs, memory_permission required) const -> std::vector<std::uint64_t>
+	requires readable
+{
+	return worm::validate_pointers(regions(), addrs, required);
+}
+
+auto validate_pointers(std::vector<memory_region> const& regions, std::span<address_t const> addrs, memory_permission required)
+	-> std::vector<std::uint64_t>
+{
+	std::vector<address_t> begins;
+	std::vector<address_t> ends;
+
+	std::vector<address_range> ranges;
+	for (auto const& region : regions)
+	{
+		if ((region.permissions & required) == required && !region.range.empty())
+		{
+			ranges.push_back(region.range);
+		}
+	}
+
+	std::ranges::sort(ranges, {}, [](auto const& r) { return r.front(); });
+
+	// Adjacent regions are merged, so that the index is smaller.
+	for (auto const& range : ranges)
+	{
+		if (!ends.empty() && range.front() <= ends.back())
+		{
+			ends.back() = std::max(ends.back(), *range.end());
+			continue;
+		}
+
+		begins.push_back(range.front());
+		ends.push_back(*range.end());
+	}
+
+	std::vector<std::uint64_t> bits((addrs.size() + 63) / 64);
+	simd::contained(begins, ends, addrs, bits.data());
+
+	return bits;
+}
+
 template struct handle<handle_mode::in>;
 template struct handle<handle_mode::out>;
 template struct handle<handle_mode::in | handle_mode::out>;
@@ -0,0 +1,160 @@
+#include <worm/daemon.hpp>
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <pthread.h>
+
+namespace
+{
+/// Exit status of a malformed command line.
+constexpr int usage_error = 2;
+
+constexpr char const* usage = R"(usage: worm-daemon [options]
+
+options:
+  -s, --socket <path>        path of the socket, $XDG_RUNTIME_DIR/worm.sock by default
+  -m, --mode <octal>         permissions of the socket file, 0600 by default
+      --region-ttl <ms>      longest duration that region tables are cached for
+      --target-ttl <ms>      longest duration that idle processes are kept attached for
+  -h, --help                 print this message
+)";
+
+/**
+ * @brief Parse an unsigned integer.
+ *
+ * @param[in] str  string
+ * @param[in] base numeric base
+ */
+[[nodiscard]]
+auto parse_unsigned(std::string const& str, int base) -> unsigned long
+{
+	std::size_t end = 0;
+
+	unsigned long value;
+	try
+	{
+		value = std::stoul(str, &end, base);
+	}
+	catch (std::exception const&)
+	{
+		throw std::invalid_argument("invalid number: " + str);
+	}
+
+	if (end != str.size() || str.starts_with('-'))
+	{
+		throw std::invalid_argument("invalid number: " + str);
+	}
+
+	return value;
+}
+}
+
+auto main(int argc, char** argv) -> int
+{
+	worm::daemon_options options;
+
+	try
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string_view const arg = argv[i];
+
+			auto const value = [&]() -> std::string
+			{
+				if (i + 1 >= argc)
+				{
+					throw std::invalid_argument("missing value of " + std::string(arg));
+				}
+
+				return argv[++i];
+			};
+
+			if (arg == "-h" || arg == "--help")
+			{
+				std::fputs(usage, stdout);
+				return 0;
+			}
+			else if (arg == "-s" || arg == "--socket")
+			{
+				options.socket_path = value();
+			}
+			else if (arg == "-m" || arg == "--mode")
+			{
+				options.socket_mode = static_cast<unsigned>(parse_unsigned(value(), 8));
+			}
+			else if (arg == "--region-ttl")
+			{
+				options.region_ttl = std::chrono::milliseconds(parse_unsigned(value(), 10));
+			}
+			else if (arg == "--target-ttl")
+			{
+				options.target_ttl = std::chrono::milliseconds(parse_unsigned(value(), 10));
+			}
+			else
+			{
+				throw std::invalid_argument("unknown option: " + std::string(arg));
+			}
+		}
+	}
+	catch (std::invalid_argument const& e)
+	{
+		std::fprintf(stderr, "worm-daemon: %s\n\n%s", e.what(), usage);
+		return usage_error;
+	}
+
+	// Termination signals are taken by a thread that stops the daemon, so that it removes its socket.
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+	try
+	{
+		worm::daemon_server server(options);
+
+		std::thread stopper(
+			[&]
+			{
+				int signal;
+				sigwait(&signals, &signal);
+				server.stop();
+			}
+		);
+
+		// The stopper refers to the server, so that it is woken and joined before the server is destroyed.
+		auto const join_stopper = [&]
+		{
+			pthread_kill(stopper.native_handle(), SIGTERM);
+			stopper.join();
+		};
+
+		try
+		{
+			std::fprintf(stderr, "worm-daemon: listening on %s\n", server.socket_path().c_str());
+
+			server.run();
+		}
+		catch (...)
+		{
+			join_stopper();
+			throw;
+		}
+
+		join_stopper();
+	}
+	catch (std::exception const& e)
+	{
+		std::fprintf(stderr, "worm-daemon: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
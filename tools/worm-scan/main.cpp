@@ -0,0 +1,656 @@
+#include <worm/references.hpp>
+#include <worm/scan.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+/// Exit status of a malformed command line.
+constexpr int usage_error = 2;
+
+/// Number of bytes that are scanned in parallel before their matches are written out.
+constexpr std::size_t batch_size = std::size_t{64} << 20;
+
+constexpr char const* usage = R"(usage: worm-scan [options] <pid> <query>
+
+queries:
+  value <type> <value>       object representation of a value, where type is one of
+                             i8, i16, i32, i64, u8, u16, u32, u64, f32, f64
+  signature <signature>      hexadecimal bytes and ?? wildcards, e.g. "48 8B 05 ?? ?? ?? ??"
+  string <text>              characters of a string, without the terminator
+  refs <address>[+<size>]    pointers into a range of addresses
+
+options:
+  -r, --region <name>        only scan regions whose name contains the name (repeatable)
+  -p, --perms <rwx>          only scan regions with all of the permissions
+      --range <lo>-<hi>      only report matches within the address range
+  -t, --threads <n>          number of worker threads, 0 for hardware concurrency
+  -a, --alignment <n>        alignment of matched addresses
+  -w, --wide                 match strings as wchar_t characters
+  -f, --format <text|binary> output format, where binary writes native 64-bit words
+  -q, --quiet                do not report statistics
+  -h, --help                 print this message
+)";
+
+/// Command-line error.
+struct usage_exception : std::runtime_error
+{
+	using std::runtime_error::runtime_error;
+};
+
+/// Parsed command line.
+struct arguments
+{
+	worm::pid_t pid = 0;
+
+	std::vector<std::string> query;
+
+	std::vector<std::string>           region_names;
+	worm::memory_permission            permissions = worm::memory_permission::read;
+	std::optional<worm::address_range> range;
+	std::size_t                        threads = 0;
+	std::optional<std::size_t>         alignment;
+	bool                               wide   = false;
+	bool                               binary = false;
+	bool                               quiet  = false;
+};
+
+/**
+ * @brief Parse an unsigned integer, in hexadecimal with a `0x` prefix.
+ *
+ * @param[in] str string
+ */
+[[nodiscard]]
+auto parse_unsigned(std::string const& str) -> std::uint64_t
+{
+	std::size_t end = 0;
+
+	std::uint64_t value;
+	try
+	{
+		value = std::stoull(str, &end, 0);
+	}
+	catch (std::exception const&)
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	if (end != str.size() || str.starts_with('-'))
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	return value;
+}
+
+/**
+ * @brief Parse a signed integer, in hexadecimal with a `0x` prefix.
+ *
+ * @param[in] str string
+ */
+[[nodiscard]]
+auto parse_signed(std::string const& str) -> std::int64_t
+{
+	std::size_t end = 0;
+
+	std::int64_t value;
+	try
+	{
+		value = std::stoll(str, &end, 0);
+	}
+	catch (std::exception const&)
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	if (end != str.size())
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	return value;
+}
+
+/**
+ * @brief Parse a floating-point number.
+ *
+ * @param[in] str string
+ */
+[[nodiscard]]
+auto parse_floating(std::string const& str) -> double
+{
+	std::size_t end = 0;
+
+	double value;
+	try
+	{
+		value = std::stod(str, &end);
+	}
+	catch (std::exception const&)
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	if (end != str.size())
+	{
+		throw usage_exception("invalid number: " + str);
+	}
+
+	return value;
+}
+
+/**
+ * @brief Parse the command line.
+ *
+ * @param[in] argc number of arguments
+ * @param[in] argv arguments
+ *
+ * @return parsed arguments, or `std::nullopt` if help was requested
+ */
+[[nodiscard]]
+auto parse_arguments(int argc, char** argv) -> std::optional<arguments>
+{
+	arguments args;
+
+	std::vector<std::string> positional;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view const arg = argv[i];
+
+		auto const value = [&]() -> std::string
+		{
+			if (i + 1 >= argc)
+			{
+				throw usage_exception("missing value of " + std::string(arg));
+			}
+
+			return argv[++i];
+		};
+
+		if (arg == "-h" || arg == "--help")
+		{
+			return std::nullopt;
+		}
+		else if (arg == "-r" || arg == "--region")
+		{
+			args.region_names.push_back(value());
+		}
+		else if (arg == "-p" || arg == "--perms")
+		{
+			args.permissions = worm::memory_permission::none;
+
+			for (char const c : value())
+			{
+				switch (c)
+				{
+				case 'r':
+					args.permissions = args.permissions | worm::memory_permission::read;
+					break;
+				case 'w':
+					args.permissions = args.permissions | worm::memory_permission::write;
+					break;
+				case 'x':
+					args.permissions = args.permissions | worm::memory_permission::execute;
+					break;
+				default:
+					throw usage_exception(std::string("invalid permission: ") + c);
+				}
+			}
+
+			// Only readable memory can be scanned.
+			args.permissions = args.permissions | worm::memory_permission::read;
+		}
+		else if (arg == "--range")
+		{
+			std::string const range = value();
+
+			std::size_t const dash = range.find('-');
+			if (dash == std::string::npos)
+			{
+				throw usage_exception("invalid range: " + range);
+			}
+
+			std::uint64_t const lo = parse_unsigned(range.substr(0, dash));
+			std::uint64_t const hi = parse_unsigned(range.substr(dash + 1));
+
+			if (hi < lo)
+			{
+				throw usage_exception("invalid range: " + range);
+			}
+
+			args.range = worm::address_range(lo, hi);
+		}
+		else if (arg == "-t" || arg == "--threads")
+		{
+			args.threads = parse_unsigned(value());
+		}
+		else if (arg == "-a" || arg == "--alignment")
+		{
+			args.alignment = parse_unsigned(value());
+		}
+		else if (arg == "-w" || arg == "--wide")
+		{
+			args.wide = true;
+		}
+		else if (arg == "-f" || arg == "--format")
+		{
+			std::string const format = value();
+			if (format != "text" && format != "binary")
+			{
+				throw usage_exception("invalid format: " + format);
+			}
+
+			args.binary = format == "binary";
+		}
+		else if (arg == "-q" || arg == "--quiet")
+		{
+			args.quiet = true;
+		}
+		else if (arg.starts_with('-') && arg.size() > 1 && !std::isdigit(static_cast<unsigned char>(arg[1])) && arg[1] != '.')
+		{
+			throw usage_exception("unknown option: " + std::string(arg));
+		}
+		else
+		{
+			positional.emplace_back(arg);
+		}
+	}
+
+	if (positional.size() < 3)
+	{
+		throw usage_exception("missing arguments");
+	}
+
+	args.pid = parse_unsigned(positional.front());
+	args.query.assign(positional.begin() + 1, positional.end());
+
+	return args;
+}
+
+/**
+ * @brief Build the pattern of a value, signature or string query.
+ *
+ * @param[in] args parsed arguments
+ */
+[[nodiscard]]
+auto make_pattern(arguments const& args) -> worm::pattern
+{
+	auto const& kind = args.query[0];
+
+	auto const expect = [&](std::size_t count)
+	{
+		if (args.query.size() != count)
+		{
+			throw usage_exception("wrong number of arguments of " + kind);
+		}
+	};
+
+	if (kind == "value")
+	{
+		expect(3);
+
+		auto const& type = args.query[1];
+		auto const& text = args.query[2];
+
+		auto const integer = [&]<typename T>(T) -> worm::pattern
+		{
+			if constexpr (std::is_signed_v<T>)
+			{
+				auto const value = parse_signed(text);
+				if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max())
+				{
+					throw usage_exception("value out of range: " + text);
+				}
+
+				return worm::pattern::value(static_cast<T>(value));
+			}
+			else
+			{
+				auto const value = parse_unsigned(text);
+				if (value > std::numeric_limits<T>::max())
+				{
+					throw usage_exception("value out of range: " + text);
+				}
+
+				return worm::pattern::value(static_cast<T>(value));
+			}
+		};
+
+		if (type == "i8")
+		{
+			return integer(std::int8_t{});
+		}
+		else if (type == "i16")
+		{
+			return integer(std::int16_t{});
+		}
+		else if (type == "i32")
+		{
+			return integer(std::int32_t{});
+		}
+		else if (type == "i64")
+		{
+			return integer(std::int64_t{});
+		}
+		else if (type == "u8")
+		{
+			return integer(std::uint8_t{});
+		}
+		else if (type == "u16")
+		{
+			return integer(std::uint16_t{});
+		}
+		else if (type == "u32")
+		{
+			return integer(std::uint32_t{});
+		}
+		else if (type == "u64")
+		{
+			return integer(std::uint64_t{});
+		}
+		else if (type == "f32")
+		{
+			return worm::pattern::value(static_cast<float>(parse_floating(text)));
+		}
+		else if (type == "f64")
+		{
+			return worm::pattern::value(parse_floating(text));
+		}
+
+		throw usage_exception("invalid type: " + type);
+	}
+
+	if (kind == "signature")
+	{
+		expect(2);
+
+		try
+		{
+			return worm::pattern::signature(args.query[1]);
+		}
+		catch (std::invalid_argument const& e)
+		{
+			throw usage_exception(e.what());
+		}
+	}
+
+	if (kind == "string")
+	{
+		expect(2);
+
+		if (!args.wide)
+		{
+			return worm::pattern::text(args.query[1]);
+		}
+
+		// Characters are widened byte by byte, which is exact for ASCII.
+		worm::pattern p;
+		for (unsigned char const c : args.query[1])
+		{
+			auto const w = worm::pattern::value(static_cast<wchar_t>(c));
+
+			p.bytes.insert(p.bytes.end(), w.bytes.begin(), w.bytes.end());
+			p.mask.insert(p.mask.end(), w.mask.begin(), w.mask.end());
+		}
+
+		return p;
+	}
+
+	throw usage_exception("unknown query: " + kind);
+}
+
+/**
+ * @brief Select regions to scan.
+ *
+ * @param[in] regions memory regions of the process
+ * @param[in] args    parsed arguments
+ */
+[[nodiscard]]
+auto select_regions(std::vector<worm::memory_region> const& regions, arguments const& args) -> std::vector<worm::memory_region>
+{
+	std::vector<worm::memory_region> selected;
+
+	for (auto const& region : regions)
+	{
+		if ((region.permissions & args.permissions) != args.permissions)
+		{
+			continue;
+		}
+
+		if (args.range && (region.range.front() >= *args.range->end() || *region.range.end() <= args.range->front()))
+		{
+			continue;
+		}
+
+		if (!args.region_names.empty()
+			&& std::none_of(args.region_names.begin(), args.region_names.end(), [&](auto const& name) { return region.name.find(name) != std::string::npos; }))
+		{
+			continue;
+		}
+
+		selected.push_back(region);
+	}
+
+	return selected;
+}
+
+/// Writer of results to the standard output.
+struct writer
+{
+	bool binary;
+
+	auto write(worm::address_t addr) const -> void
+	{
+		if (binary)
+		{
+			std::uint64_t const word = addr;
+			std::fwrite(&word, sizeof(word), 1, stdout);
+		}
+		else
+		{
+			std::fprintf(stdout, "0x%016llx\n", static_cast<unsigned long long>(addr));
+		}
+	}
+
+	auto write(worm::reference const& ref) const -> void
+	{
+		if (binary)
+		{
+			std::uint64_t const words[] = {ref.address, ref.offset};
+			std::fwrite(words, sizeof(words), 1, stdout);
+		}
+		else
+		{
+			std::fprintf(stdout, "0x%016llx +0x%llx\n", static_cast<unsigned long long>(ref.address), static_cast<unsigned long long>(ref.offset));
+		}
+	}
+};
+
+/**
+ * @brief Run a query.
+ *
+ * @param[in] args parsed arguments
+ */
+auto run(arguments const& args) -> void
+{
+	using clock = std::chrono::steady_clock;
+
+	worm::ihandle const h(args.pid);
+
+	auto const regions = select_regions(h.regions(), args);
+
+	std::size_t bytes = 0;
+	for (auto const& region : regions)
+	{
+		bytes += region.range.size();
+	}
+
+	writer const out{args.binary};
+
+	// Results are written through a large buffer, so that piping them is cheap.
+	static char buffer[1 << 16];
+	std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+	std::size_t matches = 0;
+
+	auto const started = clock::now();
+
+	auto const in_range = [&](worm::address_t addr) { return !args.range || (addr >= args.range->front() && addr < *args.range->end()); };
+
+	if (args.query[0] == "refs")
+	{
+		if (args.query.size() != 2)
+		{
+			throw usage_exception("wrong number of arguments of refs");
+		}
+
+		auto const& target = args.query[1];
+
+		std::size_t const   plus = target.find('+');
+		std::uint64_t const lo   = parse_unsigned(target.substr(0, plus));
+		std::uint64_t const size = plus == std::string::npos ? 1 : parse_unsigned(target.substr(plus + 1));
+
+		worm::reference_options options{.threads = args.threads};
+		if (args.alignment)
+		{
+			options.alignment = *args.alignment;
+		}
+
+		try
+		{
+			for (auto const& ref : worm::find_references(h, regions, worm::address_range(lo, lo + size), options))
+			{
+				if (in_range(ref.address))
+				{
+					out.write(ref);
+					++matches;
+				}
+			}
+		}
+		catch (std::invalid_argument const& e)
+		{
+			throw usage_exception(e.what());
+		}
+	}
+	else
+	{
+		auto const p = make_pattern(args);
+
+		// Matches starting in the overlap of a region split between batches are left to the next batch.
+		std::size_t const overlap = p.size() ? p.size() - 1 : 0;
+
+		std::vector<worm::memory_region> batch;
+
+		// Regions are scanned in batches on all threads, and matches of each batch
+		// are written out before the next one, so that they can be consumed while
+		// the scan runs, in ascending order.
+		auto const scan_batch = [&](worm::address_t limit)
+		{
+			for (auto const addr : worm::scan(h, batch, p, {.alignment = args.alignment.value_or(1), .threads = args.threads}))
+			{
+				if (addr < limit && in_range(addr))
+				{
+					out.write(addr);
+					++matches;
+				}
+			}
+
+			std::fflush(stdout);
+
+			batch.clear();
+		};
+
+		std::size_t batch_bytes = 0;
+
+		for (auto const& region : regions)
+		{
+			if (!static_cast<bool>(region.permissions & worm::memory_permission::read))
+			{
+				continue;
+			}
+
+			for (worm::address_t begin = region.range.front(); begin < *region.range.end();)
+			{
+				std::size_t const size = std::min<std::size_t>(*region.range.end() - begin, batch_size - batch_bytes);
+				worm::address_t const end = begin + size;
+
+				auto& slice = batch.emplace_back(region);
+				slice.range = worm::address_range(begin, std::min<worm::address_t>(end + overlap, *region.range.end()));
+
+				batch_bytes += size;
+				begin = end;
+
+				if (batch_bytes == batch_size)
+				{
+					scan_batch(end);
+					batch_bytes = 0;
+				}
+			}
+		}
+
+		if (!batch.empty())
+		{
+			scan_batch(std::numeric_limits<worm::address_t>::max());
+		}
+	}
+
+	std::fflush(stdout);
+
+	auto const elapsed = std::chrono::duration<double>(clock::now() - started).count();
+
+	if (!args.quiet)
+	{
+		double const mib = static_cast<double>(bytes) / (1 << 20);
+
+		std::fprintf(
+			stderr,
+			"worm-scan: %zu matches in %zu regions, %.1f MiB in %.3f s (%.1f MiB/s)\n",
+			matches,
+			regions.size(),
+			mib,
+			elapsed,
+			elapsed > 0 ? mib / elapsed : 0.0
+		);
+	}
+}
+}
+
+auto main(int argc, char** argv) -> int
+{
+	try
+	{
+		auto const args = parse_arguments(argc, argv);
+		if (!args)
+		{
+			std::fputs(usage, stdout);
+			return 0;
+		}
+
+		run(*args);
+	}
+	catch (usage_exception const& e)
+	{
+		std::fprintf(stderr, "worm-scan: %s\n\n%s", e.what(), usage);
+		return usage_error;
+	}
+	catch (std::exception const& e)
+	{
+		std::fprintf(stderr, "worm-scan: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}